@@ -0,0 +1,78 @@
+#include "allocCheck.hpp"
+
+#ifdef CACHESIM_ALLOC_CHECK
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<uint64_t> scopedAllocations(0);
+static thread_local unsigned int scopeDepth = 0;
+
+AllocationFreeScope::AllocationFreeScope() {
+	scopeDepth++;
+}
+
+AllocationFreeScope::~AllocationFreeScope() {
+	scopeDepth--;
+}
+
+uint64_t getScopedAllocations() {
+	return scopedAllocations.load();
+}
+
+static void* countedAllocate(size_t size) {
+	if (scopeDepth != 0) {
+		scopedAllocations++;
+	}
+	void* memory = malloc(size == 0 ? 1 : size);
+	if (memory == nullptr) {
+		throw std::bad_alloc();
+	}
+	return memory;
+}
+
+/**********************************************************************************************/
+// Replacements of the global allocation functions, every other form forwards to these
+
+void* operator new(size_t size) {
+	return countedAllocate(size);
+}
+
+void* operator new[](size_t size) {
+	return countedAllocate(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+	try {
+		return countedAllocate(size);
+	} catch (const std::bad_alloc&) {
+		return nullptr;
+	}
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+	try {
+		return countedAllocate(size);
+	} catch (const std::bad_alloc&) {
+		return nullptr;
+	}
+}
+
+void operator delete(void* memory) noexcept {
+	free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+	free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+	free(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept {
+	free(memory);
+}
+
+#endif // CACHESIM_ALLOC_CHECK
@@ -0,0 +1,34 @@
+#ifndef ALLOC_CHECK_HPP
+#define ALLOC_CHECK_HPP
+
+#include <stdint.h>
+
+// Heap allocation instrumentation for the access path, built with `make ALLOC_CHECK=1`.
+// allocCheck.cpp then replaces the global operator new and counts every allocation made
+// while a thread is inside an AllocationFreeScope. readFromCache and writeToCache open one,
+// and simulateTrace fails the run if the count moved, so anything that allocates after the
+// Cache is constructed is caught. In normal builds ALLOCATION_FREE_SCOPE expands to nothing.
+
+#ifdef CACHESIM_ALLOC_CHECK
+
+class AllocationFreeScope {
+private:
+    AllocationFreeScope(const AllocationFreeScope&) = delete;
+    AllocationFreeScope& operator=(const AllocationFreeScope&) = delete;
+public:
+    AllocationFreeScope();
+    ~AllocationFreeScope();
+};
+
+// allocations made inside any scope, on any thread, since the program started
+uint64_t getScopedAllocations();
+
+#define ALLOCATION_FREE_SCOPE AllocationFreeScope allocationFreeScope
+
+#else
+
+#define ALLOCATION_FREE_SCOPE do {} while (0)
+
+#endif // CACHESIM_ALLOC_CHECK
+
+#endif // ALLOC_CHECK_HPP
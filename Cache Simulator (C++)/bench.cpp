@@ -0,0 +1,267 @@
+#include "cacheSim.hpp"
+#include "simulator.hpp"
+#include "synthetic.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <map>
+
+// Simulator throughput benchmark, built with `make bench`:
+// cacheBench [--accesses <N>] [--repeat <R>] [--patterns <sequential,uniform,..>]
+//            [--sizes <S,..>] [--assocs <A,..>] [--repl <policy>] [--json <out.json>]
+//            [--baseline <in.json>] [--tolerance <fraction>] [--batch 1]
+// Every point is one pattern (see synthetic.hpp) driving one geometry, sizes and associativities
+// are log2 of bytes and ways as on the cacheSim command line. The size is the L2 size, L1 is a
+// quarter of it up to 32KB, both levels take the same associativity where it fits. The trace is
+// generated in memory before the clock starts, and the best of R runs is reported.
+// --json writes the results as a baseline, --baseline compares against one and exits with 1 if
+// any point is slower by more than the tolerance (0.1 by default). --batch 1 feeds the cache
+// through accessBatch, ACCESS_BATCH_SIZE accesses at a time (see simulator.hpp).
+#define BENCH_BSIZE 6
+#define BENCH_MAX_L1_SIZE 15
+#define BENCH_FOOTPRINT_SHIFT 1 // the footprint is twice the largest L2
+#define BENCH_WRITE_FRACTION 0.25
+#define BENCH_SEED 1
+
+struct BenchResult {
+    SyntheticPattern pattern;
+    unsigned int size, assoc;
+    double accessesPerSecond;
+    double nsPerAccess;
+};
+
+struct BenchRunner {
+	typedef double Result;
+	const vector<TraceAccess>& trace;
+	const CacheConfig& config;
+	// the trace split into accessBatch arrays, empty to feed accesses one at a time
+	const vector<uint64_t>& addresses;
+	const vector<uint8_t>& operations;
+	// seconds spent simulating the trace
+	template <class ReplacementPolicy>
+	double run() {
+		BasicCache<ReplacementPolicy> cache(this->config);
+		MemoryTraceReader reader(this->trace);
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		if (this->addresses.empty()) {
+			simulateTrace(reader, cache);
+		} else {
+			for (size_t first = 0; first < this->addresses.size(); first += ACCESS_BATCH_SIZE) {
+				cache.accessBatch(&this->addresses[first], &this->operations[first],
+								  min((size_t)ACCESS_BATCH_SIZE, this->addresses.size() - first));
+			}
+		}
+		return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	}
+};
+
+static bool parseList(const char* text, vector<unsigned int>& values) {
+	stringstream items(text);
+	string item;
+	values.clear();
+	while (getline(items, item, ',')) {
+		char* end;
+		unsigned long value = strtoul(item.c_str(), &end, 10);
+		if (item.empty() || *end != '\0') {
+			return false;
+		}
+		values.push_back((unsigned int)value);
+	}
+	return !values.empty();
+}
+
+static bool writeJSON(const char* path, const vector<BenchResult>& results, uint64_t accesses,
+					  ReplacementPolicyKind replacement) {
+	FILE* out = fopen(path, "w");
+	if (out == nullptr) {
+		return false;
+	}
+	// one result per line, which is all readBaseline expects
+	fprintf(out, "{\n  \"accesses\": %llu,\n  \"replacement\": \"%s\",\n  \"results\": [\n",
+			(unsigned long long)accesses, replacementPolicyName(replacement));
+	for (size_t i = 0; i < results.size(); i++) {
+		const BenchResult& r = results[i];
+		fprintf(out, "    {\"pattern\": \"%s\", \"size\": %u, \"assoc\": %u, "
+					 "\"accessesPerSecond\": %.0f, \"nsPerAccess\": %.3f}%s\n",
+				syntheticPatternName(r.pattern), r.size, r.assoc, r.accessesPerSecond, r.nsPerAccess,
+				i + 1 < results.size() ? "," : "");
+	}
+	fprintf(out, "  ]\n}\n");
+	return fclose(out) == 0;
+}
+
+// accesses per second of every point of a file written by writeJSON, keyed by
+// "pattern/size/assoc"
+static bool readBaseline(const char* path, map<string, double>& baseline) {
+	ifstream in(path);
+	if (!in.is_open()) {
+		return false;
+	}
+	string line;
+	while (getline(in, line)) {
+		char pattern[32];
+		unsigned int size, assoc;
+		double accessesPerSecond;
+		if (sscanf(line.c_str(), " {\"pattern\": \"%31[^\"]\", \"size\": %u, \"assoc\": %u, "
+								 "\"accessesPerSecond\": %lf", pattern, &size, &assoc,
+				   &accessesPerSecond) == 4) {
+			stringstream key;
+			key << pattern << "/" << size << "/" << assoc;
+			baseline[key.str()] = accessesPerSecond;
+		}
+	}
+	return true;
+}
+
+int main(int argc, char **argv) {
+	uint64_t numAccesses = 1 << 20;
+	unsigned int repeat = 3;
+	vector<unsigned int> patterns, sizes, assocs;
+	for (unsigned int pattern = 0; pattern < NUM_SYNTHETIC_PATTERNS; pattern++) {
+		patterns.push_back(pattern);
+	}
+	unsigned int defaultSizes[] = {12, 14, 16, 18, 20, 22, 23}; // 4KB .. 8MB
+	sizes.assign(defaultSizes, defaultSizes + sizeof(defaultSizes) / sizeof(defaultSizes[0]));
+	for (unsigned int assoc = 0; assoc <= 5; assoc++) { // 1 .. 32 ways
+		assocs.push_back(assoc);
+	}
+	ReplacementPolicyKind replacement = REPLACEMENT_LRU;
+	const char* jsonPath = NULL;
+	const char* baselinePath = NULL;
+	double tolerance = 0.1;
+	bool batch = false;
+
+	for (int i = 1; i < argc; i += 2) {
+		string s(argv[i]);
+		if (i + 1 == argc) {
+			cerr << "Error in arguments" << endl;
+			return 1;
+		}
+		bool ok = true;
+		if (s == "--accesses") {
+			numAccesses = strtoull(argv[i + 1], NULL, 10);
+			ok = numAccesses > 0;
+		} else if (s == "--repeat") {
+			repeat = atoi(argv[i + 1]);
+			ok = repeat > 0;
+		} else if (s == "--patterns") {
+			stringstream names(argv[i + 1]);
+			string name;
+			patterns.clear();
+			while (ok && getline(names, name, ',')) {
+				SyntheticPattern pattern;
+				ok = parseSyntheticPattern(name, pattern);
+				patterns.push_back(pattern);
+			}
+			ok = ok && !patterns.empty();
+		} else if (s == "--sizes") {
+			ok = parseList(argv[i + 1], sizes);
+		} else if (s == "--assocs") {
+			ok = parseList(argv[i + 1], assocs);
+		} else if (s == "--repl") {
+			ok = parseReplacementPolicy(argv[i + 1], replacement);
+		} else if (s == "--json") {
+			jsonPath = argv[i + 1];
+		} else if (s == "--baseline") {
+			baselinePath = argv[i + 1];
+		} else if (s == "--batch") {
+			batch = atoi(argv[i + 1]) != 0;
+		} else if (s == "--tolerance") {
+			tolerance = atof(argv[i + 1]);
+			ok = tolerance >= 0 && tolerance < 1;
+		} else {
+			ok = false;
+		}
+		if (!ok) {
+			cerr << "Error in arguments" << endl;
+			return 1;
+		}
+	}
+	unsigned int maxSize = 0;
+	for (size_t i = 0; i < sizes.size(); i++) {
+		if (sizes[i] < BENCH_BSIZE || sizes[i] >= 40) {
+			cerr << "Error in arguments" << endl;
+			return 1;
+		}
+		maxSize = max(maxSize, sizes[i]);
+	}
+	map<string, double> baseline;
+	if (baselinePath != NULL && !readBaseline(baselinePath, baseline)) {
+		cerr << "File not found" << endl;
+		return 1;
+	}
+
+	vector<BenchResult> results;
+	vector<TraceAccess> trace;
+	unsigned int regressions = 0;
+	for (size_t p = 0; p < patterns.size(); p++) {
+		SyntheticConfig synthetic = {(SyntheticPattern)patterns[p], numAccesses,
+									 (uint64_t)1 << (maxSize + BENCH_FOOTPRINT_SHIFT),
+									 1 << BENCH_BSIZE, BENCH_WRITE_FRACTION, BENCH_SEED};
+		generateSyntheticTrace(synthetic, trace);
+		vector<uint64_t> addresses;
+		vector<uint8_t> operations;
+		for (size_t i = 0; batch && i < trace.size(); i++) {
+			addresses.push_back(trace[i].address);
+			operations.push_back(trace[i].operation == 'w' ? ACCESS_WRITE : ACCESS_READ);
+		}
+		for (size_t s = 0; s < sizes.size(); s++) {
+			for (size_t a = 0; a < assocs.size(); a++) {
+				// every level keeps at least one set
+				unsigned int L2Size = sizes[s];
+				unsigned int L1Size = min(L2Size - min(L2Size, 2u), (unsigned int)BENCH_MAX_L1_SIZE);
+				L1Size = max(L1Size, (unsigned int)BENCH_BSIZE);
+				unsigned int L2Assoc = min(assocs[a], L2Size - BENCH_BSIZE);
+				unsigned int L1Assoc = min(assocs[a], L1Size - BENCH_BSIZE);
+				CacheConfig config = defaultCacheConfig();
+				config.MemCyc = 100;
+				config.BSize = BENCH_BSIZE;
+				config.L1Size = L1Size;
+				config.L2Size = L2Size;
+				config.L1Assoc = L1Assoc;
+				config.L2Assoc = L2Assoc;
+				config.L1Cyc = 1;
+				config.L2Cyc = 10;
+				config.WrAlloc = WRITE_ALLOCATE;
+				config.replacement = replacement;
+				BenchRunner runner = {trace, config, addresses, operations};
+				double best = 0;
+				for (unsigned int r = 0; r < repeat; r++) {
+					double seconds = dispatchReplacementPolicy(replacement, runner);
+					best = r == 0 ? seconds : min(best, seconds);
+				}
+				BenchResult result = {(SyntheticPattern)patterns[p], L2Size, assocs[a],
+									  best > 0 ? numAccesses / best : 0, best * 1e9 / numAccesses};
+				results.push_back(result);
+				printf("pattern=%s size=%u assoc=%u accessesPerSec=%.0f nsPerAccess=%.3f",
+					   syntheticPatternName(result.pattern), result.size, result.assoc,
+					   result.accessesPerSecond, result.nsPerAccess);
+
+				stringstream key;
+				key << syntheticPatternName(result.pattern) << "/" << result.size << "/" << result.assoc;
+				map<string, double>::const_iterator old = baseline.find(key.str());
+				if (old != baseline.end() && old->second > 0) {
+					double change = result.accessesPerSecond / old->second - 1;
+					printf(" change=%+.03f", change);
+					if (change < -tolerance) {
+						printf(" REGRESSION");
+						regressions++;
+					}
+				}
+				printf("\n");
+				fflush(stdout);
+			}
+		}
+	}
+
+	if (jsonPath != NULL && !writeJSON(jsonPath, results, numAccesses, replacement)) {
+		cerr << "Cannot create " << jsonPath << endl;
+		return 1;
+	}
+	if (regressions > 0) {
+		cerr << regressions << " points slower than the baseline" << endl;
+		return 1;
+	}
+	return 0;
+}
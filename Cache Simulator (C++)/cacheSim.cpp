@@ -1,199 +1,252 @@
 #include "cacheSim.hpp"
+#include "trace.hpp"
 
 /**********************************************************************************************/
-// CacheLine definitions
-CacheLine::CacheLine(unsigned int initialLRU) : tag(0), valid(false),
-												dirty(false), LRU(initialLRU) {	
+// CacheStats definitions
+CacheStats& CacheStats::operator+=(const CacheStats& other) {
+	this->L1Reads += other.L1Reads;
+	this->L1ReadMisses += other.L1ReadMisses;
+	this->L1Writes += other.L1Writes;
+	this->L1WriteMisses += other.L1WriteMisses;
+	this->L2Reads += other.L2Reads;
+	this->L2ReadMisses += other.L2ReadMisses;
+	this->L2Writes += other.L2Writes;
+	this->L2WriteMisses += other.L2WriteMisses;
+	this->L1Fetches += other.L1Fetches;
+	this->L1FetchMisses += other.L1FetchMisses;
+	this->L2Fetches += other.L2Fetches;
+	this->L2FetchMisses += other.L2FetchMisses;
+	this->totalL1Cycles += other.totalL1Cycles;
+	this->totalL2Cycles += other.totalL2Cycles;
+	this->totalMemCycles += other.totalMemCycles;
+	this->L1WriteBacks += other.L1WriteBacks;
+	this->L2WriteBacks += other.L2WriteBacks;
+	this->L2ReadBytes += other.L2ReadBytes;
+	this->L2WriteBytes += other.L2WriteBytes;
+	this->memReadBytes += other.memReadBytes;
+	this->memWriteBytes += other.memWriteBytes;
+	this->writeBufferStallCycles += other.writeBufferStallCycles;
+	this->L1Prefetch += other.L1Prefetch;
+	this->L2Prefetch += other.L2Prefetch;
+	this->victimHits += other.victimHits;
+	this->victimMisses += other.victimMisses;
+	this->victimCycles += other.victimCycles;
+	this->dram += other.dram;
+	this->tlb += other.tlb;
+	return *this;
 }
 
-CacheLine::~CacheLine() {
-}
-
-unsigned int CacheLine::getTag() {
-	return this->tag;
-}
-
-bool CacheLine::getValid() {
-	return this->valid;
-}
-
-bool CacheLine::getDirty() {
-	return this->dirty;
-}
-
-unsigned int CacheLine::getLRU() {
-	return this->LRU;
-}
-
-void CacheLine::setTag(unsigned int tag) {
-	this->tag = tag;
-}
-
-void CacheLine::setValid(bool valid) {
-	this->valid = valid;
-}
-
-void CacheLine::setDirty(bool dirty) {
-	this->dirty = dirty;
-}
-
-void CacheLine::setLRU(unsigned int LRU) {
-	this->LRU = LRU;
-}
-
-bool CacheLine::compareTag(unsigned int outsideTag) {
-	return this->tag == outsideTag;
+CacheStats& CacheStats::operator-=(const CacheStats& other) {
+	this->L1Reads -= other.L1Reads;
+	this->L1ReadMisses -= other.L1ReadMisses;
+	this->L1Writes -= other.L1Writes;
+	this->L1WriteMisses -= other.L1WriteMisses;
+	this->L2Reads -= other.L2Reads;
+	this->L2ReadMisses -= other.L2ReadMisses;
+	this->L2Writes -= other.L2Writes;
+	this->L2WriteMisses -= other.L2WriteMisses;
+	this->L1Fetches -= other.L1Fetches;
+	this->L1FetchMisses -= other.L1FetchMisses;
+	this->L2Fetches -= other.L2Fetches;
+	this->L2FetchMisses -= other.L2FetchMisses;
+	this->totalL1Cycles -= other.totalL1Cycles;
+	this->totalL2Cycles -= other.totalL2Cycles;
+	this->totalMemCycles -= other.totalMemCycles;
+	this->L1WriteBacks -= other.L1WriteBacks;
+	this->L2WriteBacks -= other.L2WriteBacks;
+	this->L2ReadBytes -= other.L2ReadBytes;
+	this->L2WriteBytes -= other.L2WriteBytes;
+	this->memReadBytes -= other.memReadBytes;
+	this->memWriteBytes -= other.memWriteBytes;
+	this->writeBufferStallCycles -= other.writeBufferStallCycles;
+	this->L1Prefetch -= other.L1Prefetch;
+	this->L2Prefetch -= other.L2Prefetch;
+	this->victimHits -= other.victimHits;
+	this->victimMisses -= other.victimMisses;
+	this->victimCycles -= other.victimCycles;
+	this->dram -= other.dram;
+	this->tlb -= other.tlb;
+	return *this;
 }
 
 /**********************************************************************************************/
-// CacheSet definitions
-CacheSet::CacheSet() : numWays(0), lineCount(0), lines(nullptr) {
-}
-
-CacheSet::CacheSet(unsigned int numWays) : numWays(numWays), lineCount(0) {
-	this->lines = new CacheLine[this->numWays];
+// CacheLevel definitions
+template <class ReplacementPolicy>
+CacheLevel<ReplacementPolicy>::CacheLevel() : numSets(0), numWays(0), wayStride(0), maskWords(0),
+		tags(nullptr), validMask(nullptr), dirtyMask(nullptr), prefetchMask(nullptr), usedMask(nullptr),
+		lineCount(nullptr) {
 }
 
-CacheSet::~CacheSet() {
-	if (this->lines != nullptr) {	
-		delete[] this->lines;
-	}
+template <class ReplacementPolicy>
+CacheLevel<ReplacementPolicy>::~CacheLevel() {
+	delete[] this->tags;
+	delete[] this->validMask;
+	delete[] this->dirtyMask;
+	delete[] this->prefetchMask;
+	delete[] this->usedMask;
+	delete[] this->lineCount;
 }
 
-void CacheSet::initSet(unsigned int numOfWays) {
+template <class ReplacementPolicy>
+void CacheLevel<ReplacementPolicy>::initLevel(unsigned int numOfSets, unsigned int numOfWays,
+											 IndexKind indexing) {
+	this->index.initIndex(indexing, __builtin_ctz(numOfSets));
+	this->numSets = numOfSets;
 	this->numWays = numOfWays;
-	this->lines = new CacheLine[numOfWays];
+	// direct mapped sets are compared scalar, so they need no padding
+	if (numOfWays == 1) {
+		this->wayStride = 1;
+	} else {
+		this->wayStride = (numOfWays + TAG_LANES - 1) / TAG_LANES * TAG_LANES;
+	}
+	this->maskWords = (this->wayStride + 63) / 64;
+	size_t numLines = (size_t)numOfSets * this->wayStride;
+	size_t numWords = (size_t)numOfSets * this->maskWords;
+	this->tags = new CacheTag[numLines]();
+	this->validMask = new uint64_t[numWords]();
+	this->dirtyMask = new uint64_t[numWords]();
+	this->prefetchMask = new uint64_t[numWords]();
+	this->usedMask = new uint64_t[numWords]();
+	this->lineCount = new unsigned int[numOfSets]();
+	this->policy.initPolicy(numOfSets, numOfWays);
 }
 
-unsigned int CacheSet::getWay(unsigned int tag) {
-	for (unsigned int i = 0; i < this->numWays; i++) {
-		if (this->lines[i].compareTag(tag) && this->lines[i].getValid()) {
-			return i;
-		}
+template <class ReplacementPolicy>
+unsigned int CacheLevel<ReplacementPolicy>::insertLine(unsigned int set, CacheTag tag) {
+	// check if the set is full
+	if (this->lineCount[set] == this->numWays) {
+		return NO_WAY;
+	}
+	// find the first invalid line
+	uint64_t* valid = this->validMask + (size_t)set * this->maskWords;
+	unsigned int word = 0;
+	while (~valid[word] == 0) {
+		word++;
 	}
-	return (unsigned int)-1;
+	unsigned int way = word * 64 + __builtin_ctzll(~valid[word]);
+	this->placeLine(set, way, tag);
+	return way;
 }
 
-void CacheSet::updateLRU(unsigned int way) {
-	// update the LRU of all the lines in the set
-	unsigned int LRU = this->lines[way].getLRU();
-	for (unsigned int i = 0; i < this->numWays; i++) {
-		unsigned int currentLRU = this->lines[i].getLRU();
-		if ((i != way) && (currentLRU > LRU) && (this->lines[i].getValid())) {
-			this->lines[i].setLRU(currentLRU - 1);
-		}
-	}
-	this->lines[way].setLRU(this->lineCount - 1);
+template <class ReplacementPolicy>
+void CacheLevel<ReplacementPolicy>::placeLine(unsigned int set, unsigned int way, CacheTag tag) {
+	this->tags[(size_t)set * this->wayStride + way] = tag;
+	this->lineCount[set]++;
+	this->validMask[(size_t)set * this->maskWords + (way >> 6)] |= (uint64_t)1 << (way & 63);
+	this->setDirty(set, way, false);
+	this->setPrefetchState(set, way, LINE_DEMAND);
+	this->policy.insert(set, way);
 }
 
-bool CacheSet::insertLine(unsigned int tag) {
-	// check if the set is full
-	if (this->lineCount == this->numWays) {
-		return false;
+template <class ReplacementPolicy>
+unsigned int CacheLevel<ReplacementPolicy>::findHashedBlock(CacheTag block, unsigned int& set) {
+	if (this->index.kind != INDEX_SKEW) {
+		set = this->index.set(block, 0);
+		return this->findWay(set, (CacheTag)this->index.tag(block));
 	}
-	// find the first invalid line
-	for (unsigned int i = 0; i < this->numWays; i++) {
-		if (!this->lines[i].getValid()) {
-			this->lines[i].setTag(tag);
-			this->lines[i].setValid(true);
-			this->lines[i].setDirty(false);
-			this->lines[i].setLRU(this->lineCount++);
-			return true;
+	for (unsigned int way = 0; way < this->numWays; way++) {
+		unsigned int waySet = this->index.set(block, way);
+		if (this->tags[(size_t)waySet * this->wayStride + way] == block &&
+			((this->validMask[(size_t)waySet * this->maskWords + (way >> 6)] >> (way & 63)) & 1)) {
+			set = waySet;
+			return way;
 		}
 	}
-	return false;
+	set = this->index.set(block, 0);
+	return NO_WAY;
 }
 
-bool CacheSet::isLineInSet(unsigned int tag) {
-	for (unsigned int i = 0; i < this->numWays; i++) {
-		if (this->lines[i].compareTag(tag) && this->lines[i].getValid()) {
-			return true;
+template <class ReplacementPolicy>
+unsigned int CacheLevel<ReplacementPolicy>::insertHashedBlock(CacheTag block, unsigned int& set) {
+	if (this->index.kind != INDEX_SKEW) {
+		set = this->index.set(block, 0);
+		return this->insertLine(set, (CacheTag)this->index.tag(block));
+	}
+	// the first way whose line for block is free
+	for (unsigned int way = 0; way < this->numWays; way++) {
+		unsigned int waySet = this->index.set(block, way);
+		if (!((this->validMask[(size_t)waySet * this->maskWords + (way >> 6)] >> (way & 63)) & 1)) {
+			set = waySet;
+			this->placeLine(set, way, block);
+			return way;
 		}
 	}
-	return false;
+	set = this->index.set(block, 0);
+	return NO_WAY;
 }
 
-CacheLine* CacheSet::findLine(unsigned int tag) {
-	for (unsigned int i = 0; i < this->numWays; i++) {
-		if (this->lines[i].compareTag(tag) && this->lines[i].getValid()) {
-			this->updateLRU(i);
-			return &this->lines[i];
+template <class ReplacementPolicy>
+unsigned int CacheLevel<ReplacementPolicy>::selectSkewedVictim(CacheTag block, unsigned int& set) {
+	unsigned int victim = 0;
+	set = this->index.set(block, 0);
+	for (unsigned int way = 1; way < this->numWays; way++) {
+		unsigned int waySet = this->index.set(block, way);
+		if (this->policy.age(waySet, way) < this->policy.age(set, victim)) {
+			victim = way;
+			set = waySet;
 		}
 	}
-	return nullptr;
+	return victim;
 }
 
-CacheLine* CacheSet::removeLine() {
-	unsigned int way = 0;
-	// find first valid line
-	while (!this->lines[way].getValid()) {
-		way++;
-	}
-	// find the least recently used line
-	for (unsigned int i = way + 1; i < this->numWays; i++) {
-		if ((this->lines[i].getLRU() < this->lines[way].getLRU()) && 
-			(this->lines[i].getValid())) {
-			way = i;
-		}
-	}
-	// way is the least recently used line (LRU = 0)
-	CacheLine* line = new CacheLine();
-	// copy the line
-	*line = this->lines[way];
+template <class ReplacementPolicy>
+void CacheLevel<ReplacementPolicy>::removeLine(unsigned int set, unsigned int way) {
 	// invalidate the line
-	this->updateLRU(way);
-	this->lines[way].setValid(false);
-	this->lines[way].setDirty(false);
-	this->lines[way].setTag(0);
-	this->lines[way].setLRU(0);
-	this->lineCount--;
-	return line;
-}
-
-CacheLine* CacheSet::removeLine(unsigned int way) {
-	CacheLine* line = new CacheLine();
-	// copy the line
-	*line = this->lines[way];
-	// invalidate the line
-	this->updateLRU(way);
-	this->lines[way].setValid(false);
-	this->lines[way].setDirty(false);
-	this->lines[way].setTag(0);
-	this->lines[way].setLRU(0);
-	this->lineCount--;
-	return line;
+	this->validMask[(size_t)set * this->maskWords + (way >> 6)] &= ~((uint64_t)1 << (way & 63));
+	this->setDirty(set, way, false);
+	this->setPrefetchState(set, way, LINE_DEMAND);
+	this->tags[(size_t)set * this->wayStride + way] = 0;
+	this->lineCount[set]--;
+	this->policy.remove(set, way);
 }
 
-bool CacheSet::writeToLine(unsigned int tag) {
-	CacheLine* line = this->findLine(tag);
-	if (line != nullptr) {
-		line->setDirty(true);
-		return true;
+template <class ReplacementPolicy>
+void CacheLevel<ReplacementPolicy>::saveState(CheckpointWriter& checkpoint) {
+	for (unsigned int set = 0; set < this->numSets; set++) {
+		checkpoint.writeArray(this->tags + (size_t)set * this->wayStride, this->numWays);
 	}
-	return false;
+	checkpoint.writeArray(this->validMask, (size_t)this->numSets * this->maskWords);
+	checkpoint.writeArray(this->dirtyMask, (size_t)this->numSets * this->maskWords);
+	checkpoint.writeArray(this->prefetchMask, (size_t)this->numSets * this->maskWords);
+	checkpoint.writeArray(this->usedMask, (size_t)this->numSets * this->maskWords);
+	checkpoint.writeArray(this->lineCount, this->numSets);
+	this->policy.saveState(checkpoint, this->numSets);
 }
 
-bool CacheSet::readFromLine(unsigned int tag) {
-	CacheLine* line = this->findLine(tag);
-	if (line != nullptr) {
-		return true;
+template <class ReplacementPolicy>
+bool CacheLevel<ReplacementPolicy>::restoreState(CheckpointReader& checkpoint) {
+	for (unsigned int set = 0; set < this->numSets; set++) {
+		if (!checkpoint.readArray(this->tags + (size_t)set * this->wayStride, this->numWays)) {
+			return false;
+		}
 	}
-	return false;
-}
-
-void CacheSet::updateDirty(unsigned int way, bool dirty) {
-	this->lines[way].setDirty(dirty);
+	return checkpoint.readArray(this->validMask, (size_t)this->numSets * this->maskWords) &&
+		   checkpoint.readArray(this->dirtyMask, (size_t)this->numSets * this->maskWords) &&
+		   checkpoint.readArray(this->prefetchMask, (size_t)this->numSets * this->maskWords) &&
+		   checkpoint.readArray(this->usedMask, (size_t)this->numSets * this->maskWords) &&
+		   checkpoint.readArray(this->lineCount, this->numSets) &&
+		   this->policy.restoreState(checkpoint, this->numSets);
 }
 
 /**********************************************************************************************/
 // Cache definitions
-Cache::Cache(unsigned int MemCyc, unsigned int BSize, unsigned int L1Size, unsigned int L2Size,
+template <class ReplacementPolicy>
+BasicCache<ReplacementPolicy>::BasicCache(unsigned int MemCyc, unsigned int BSize, unsigned int L1Size, unsigned int L2Size,
             unsigned int L1Assoc, unsigned int L2Assoc, unsigned int L1Cyc, unsigned int L2Cyc,
-            unsigned int WrAlloc) : MemCyc(MemCyc), BSize(BSize), L1Size(L1Size), L2Size(L2Size),
+            unsigned int WrAlloc, int writeBufferDepth, IndexKind L1Indexing, IndexKind L2Indexing) :
+			MemCyc(MemCyc), BSize(BSize), L1Size(L1Size), L2Size(L2Size),
 			L1Assoc(L1Assoc), L2Assoc(L2Assoc), L1Cyc(L1Cyc), L2Cyc(L2Cyc), WrAlloc(WrAlloc), 
 			L1Reads(0), L1ReadMisses(0), L1Writes(0), L1WriteMisses(0),
 			L2Reads(0), L2ReadMisses(0), L2Writes(0), L2WriteMisses(0),
-			totalL1Cycles(0), totalL2Cycles(0), totalMemCycles(0) {	
+			L1Fetches(0), L1FetchMisses(0), L2Fetches(0), L2FetchMisses(0), totalL1Cycles(0), totalL2Cycles(0), totalMemCycles(0),
+			L1WriteBacks(0), L2WriteBacks(0), L2ReadBytes(0), L2WriteBytes(0),
+			memReadBytes(0), memWriteBytes(0), writeBufferStallCycles(0),
+			writeBufferDepth(writeBufferDepth), writeBuffer(nullptr), writeBufferHead(0),
+			writeBufferCount(0), lastDrain(0), counting(true), translating(true), L1PrefetchStats(), L2PrefetchStats(),
+			L1Ready(nullptr), L2Ready(nullptr), victimEntries(VICTIM_OFF), VictimCyc(0), victimHits(0),
+			victimMisses(0), victimCycles(0), victimBlocks(nullptr), victimStamps(nullptr), victimClock(0),
+			victimValid(0), victimDirty(0), dramStats(), tlbStats(), L1ISize(L1I_OFF), L1ICyc(0),
+			replayPending(false), replayVictim(0) {	
 	// calculate the number of bits for the tag, index and offset
     this->BlockSize = 1 << this->BSize; 
 	this->L1OffsetBits = this->BSize;
@@ -202,6 +255,8 @@ Cache::Cache(unsigned int MemCyc, unsigned int BSize, unsigned int L1Size, unsig
 	this->L2IndexBits = this->L2Size - this->L2OffsetBits - this->L2Assoc;
 	this->L1TagBits = FULL_TAG_SIZE - this->L1IndexBits - this->L1OffsetBits;
 	this->L2TagBits = FULL_TAG_SIZE - this->L2IndexBits - this->L2OffsetBits;
+	this->L1IndexMask = (1 << this->L1IndexBits) - 1;
+	this->L2IndexMask = (1 << this->L2IndexBits) - 1;
 
 	// calculate the number of blocks, sets and ways
 	this->L1NumBlocks = 1 << (this->L1Size - this->BSize);
@@ -211,325 +266,979 @@ Cache::Cache(unsigned int MemCyc, unsigned int BSize, unsigned int L1Size, unsig
 	this->L1NumWays = 1 << this->L1Assoc;
 	this->L2NumWays = 1 << this->L2Assoc;
 
-	// create the cache sets
-	this->L1Sets = new CacheSet[this->L1NumSets];
-	for (unsigned int i = 0; i < this->L1NumSets; i++) {
-		this->L1Sets[i].initSet(this->L1NumWays);
-	}
-	
-	this->L2Sets = new CacheSet[this->L2NumSets];
-	for (unsigned int i = 0; i < this->L2NumSets; i++) {
-		this->L2Sets[i].initSet(this->L2NumWays);
+	// create the cache levels
+	this->L1.initLevel(this->L1NumSets, this->L1NumWays, L1Indexing);
+	this->L2.initLevel(this->L2NumSets, this->L2NumWays, L2Indexing);
+	if (this->writeBufferDepth > 0) {
+		this->writeBuffer = new uint64_t[this->writeBufferDepth]();
 	}
 }
 
-Cache::~Cache() {
-	if (this->L1Sets != nullptr) {
-		delete[] this->L1Sets;
+template <class ReplacementPolicy>
+BasicCache<ReplacementPolicy>::BasicCache(const CacheConfig& config) :
+		BasicCache(config.MemCyc, config.BSize, config.L1Size, config.L2Size, config.L1Assoc,
+				   config.L2Assoc, config.L1Cyc, config.L2Cyc, config.WrAlloc, config.writeBufferDepth,
+				   config.L1Indexing, config.L2Indexing) {
+	this->L1Prefetcher.initPrefetcher(config.L1Prefetch, this->BSize);
+	this->L2Prefetcher.initPrefetcher(config.L2Prefetch, this->BSize);
+	// stream buffers fill lines on demand, only the others need arrival times
+	if (config.L1Prefetch.kind == PREFETCH_NEXT_LINE || config.L1Prefetch.kind == PREFETCH_STRIDE) {
+		this->L1Ready = new uint64_t[(size_t)this->L1NumSets * this->L1NumWays]();
+	}
+	if (config.L2Prefetch.kind == PREFETCH_NEXT_LINE || config.L2Prefetch.kind == PREFETCH_STRIDE) {
+		this->L2Ready = new uint64_t[(size_t)this->L2NumSets * this->L2NumWays]();
 	}
-	if (this->L2Sets != nullptr) {
-		delete[] this->L2Sets;
+	this->victimEntries = config.victimEntries;
+	this->VictimCyc = config.VictimCyc;
+	if (this->victimEntries != VICTIM_OFF) {
+		this->victimBlocks = new CacheTag[this->victimEntries]();
+		this->victimStamps = new uint64_t[this->victimEntries]();
 	}
+	this->dram.initDram(config.dram, this->BSize, this->MemCyc);
+	this->tlb.initTlb(config.tlb);
+	this->L1ISize = config.L1ISize;
+	this->L1ICyc = config.L1ICyc;
+	if (this->L1ISize != L1I_OFF) {
+		this->L1I.initLevel(1 << (this->L1ISize - this->BSize - config.L1IAssoc), 1 << config.L1IAssoc,
+							config.L1Indexing);
+	}
+}
+
+template <class ReplacementPolicy>
+BasicCache<ReplacementPolicy>::~BasicCache() {
+	delete[] this->writeBuffer;
+	delete[] this->L1Ready;
+	delete[] this->L2Ready;
+	delete[] this->victimBlocks;
+	delete[] this->victimStamps;
 }
 
-unsigned int Cache::getL1Reads() {
+template <class ReplacementPolicy>
+uint64_t BasicCache<ReplacementPolicy>::getL1Reads() {
 	return this->L1Reads;
 }
 
-unsigned int Cache::getL1ReadMisses() {
+template <class ReplacementPolicy>
+uint64_t BasicCache<ReplacementPolicy>::getL1ReadMisses() {
 	return this->L1ReadMisses;
 }
 
-unsigned int Cache::getL1Writes() {
+template <class ReplacementPolicy>
+uint64_t BasicCache<ReplacementPolicy>::getL1Writes() {
 	return this->L1Writes;
 }
 
-unsigned int Cache::getL1WriteMisses() {
+template <class ReplacementPolicy>
+uint64_t BasicCache<ReplacementPolicy>::getL1WriteMisses() {
 	return this->L1WriteMisses;
 }
 
-unsigned int Cache::getL2Reads() {
+template <class ReplacementPolicy>
+uint64_t BasicCache<ReplacementPolicy>::getL2Reads() {
 	return this->L2Reads;
 }
 
-unsigned int Cache::getL2ReadMisses() {
+template <class ReplacementPolicy>
+uint64_t BasicCache<ReplacementPolicy>::getL2ReadMisses() {
 	return this->L2ReadMisses;
 }
 
-unsigned int Cache::getL2Writes() {
+template <class ReplacementPolicy>
+uint64_t BasicCache<ReplacementPolicy>::getL2Writes() {
 	return this->L2Writes;
 }
 
-unsigned int Cache::getL2WriteMisses() {
+template <class ReplacementPolicy>
+uint64_t BasicCache<ReplacementPolicy>::getL2WriteMisses() {
 	return this->L2WriteMisses;
 }
 
-unsigned int Cache::getTotalL1Cycles() {
+template <class ReplacementPolicy>
+uint64_t BasicCache<ReplacementPolicy>::getTotalL1Cycles() {
 	return this->totalL1Cycles;
 }
 
-unsigned int Cache::getTotalL2Cycles() {
+template <class ReplacementPolicy>
+uint64_t BasicCache<ReplacementPolicy>::getTotalL2Cycles() {
 	return this->totalL2Cycles;
 }
 
-unsigned int Cache::getTotalMemCycles() {
+template <class ReplacementPolicy>
+uint64_t BasicCache<ReplacementPolicy>::getTotalMemCycles() {
 	return this->totalMemCycles;
 }
 
-void Cache::readFromCache(unsigned int fullTag) {
-	// calculate the address of the line in L1
-	unsigned int L1Index = (fullTag >> this->L1OffsetBits) & ((1 << this->L1IndexBits) - 1);
-	unsigned int L1Tag = fullTag >> (this->L1OffsetBits + this->L1IndexBits);
-	CacheSet* L1Set = &this->L1Sets[L1Index];
+template <class ReplacementPolicy>
+CacheStats BasicCache<ReplacementPolicy>::getStats() {
+	CacheStats stats = {this->L1Reads, this->L1ReadMisses, this->L1Writes, this->L1WriteMisses,
+						this->L2Reads, this->L2ReadMisses, this->L2Writes, this->L2WriteMisses,
+						this->L1Fetches, this->L1FetchMisses, this->L2Fetches, this->L2FetchMisses,
+						this->totalL1Cycles, this->totalL2Cycles, this->totalMemCycles,
+						this->L1WriteBacks, this->L2WriteBacks, this->L2ReadBytes, this->L2WriteBytes,
+						this->memReadBytes, this->memWriteBytes, this->writeBufferStallCycles,
+						this->L1PrefetchStats, this->L2PrefetchStats, this->victimHits, this->victimMisses,
+						this->victimCycles, this->dramStats, this->tlbStats};
+	return stats;
+}
+
+template <class ReplacementPolicy>
+void BasicCache<ReplacementPolicy>::saveState(CheckpointWriter& checkpoint) {
+	CacheStats stats = this->getStats();
+	checkpoint.write(&stats, sizeof(stats));
+	if (this->writeBufferDepth > 0) {
+		checkpoint.writeArray(this->writeBuffer, this->writeBufferDepth);
+		checkpoint.writeArray(&this->writeBufferHead, 1);
+		checkpoint.writeArray(&this->writeBufferCount, 1);
+		checkpoint.writeArray(&this->lastDrain, 1);
+	}
+	this->L1Prefetcher.saveState(checkpoint);
+	this->L2Prefetcher.saveState(checkpoint);
+	if (this->L1Ready != nullptr) {
+		checkpoint.writeArray(this->L1Ready, (size_t)this->L1NumSets * this->L1NumWays);
+	}
+	if (this->L2Ready != nullptr) {
+		checkpoint.writeArray(this->L2Ready, (size_t)this->L2NumSets * this->L2NumWays);
+	}
+	if (this->victimEntries != VICTIM_OFF) {
+		checkpoint.writeArray(this->victimBlocks, this->victimEntries);
+		checkpoint.writeArray(this->victimStamps, this->victimEntries);
+		checkpoint.writeArray(&this->victimClock, 1);
+		checkpoint.writeArray(&this->victimValid, 1);
+		checkpoint.writeArray(&this->victimDirty, 1);
+	}
+	if (this->dram.isEnabled()) {
+		this->dram.saveState(checkpoint);
+	}
+	if (this->tlb.isEnabled()) {
+		this->tlb.saveState(checkpoint);
+	}
+	this->L1.saveState(checkpoint);
+	this->L2.saveState(checkpoint);
+	if (this->L1ISize != L1I_OFF) {
+		this->L1I.saveState(checkpoint);
+	}
+}
+
+template <class ReplacementPolicy>
+bool BasicCache<ReplacementPolicy>::restoreState(CheckpointReader& checkpoint) {
+	CacheStats stats;
+	if (!checkpoint.read(&stats, sizeof(stats))) {
+		return false;
+	}
+	this->L1Reads = stats.L1Reads;
+	this->L1ReadMisses = stats.L1ReadMisses;
+	this->L1Writes = stats.L1Writes;
+	this->L1WriteMisses = stats.L1WriteMisses;
+	this->L2Reads = stats.L2Reads;
+	this->L2ReadMisses = stats.L2ReadMisses;
+	this->L2Writes = stats.L2Writes;
+	this->L2WriteMisses = stats.L2WriteMisses;
+	this->L1Fetches = stats.L1Fetches;
+	this->L1FetchMisses = stats.L1FetchMisses;
+	this->L2Fetches = stats.L2Fetches;
+	this->L2FetchMisses = stats.L2FetchMisses;
+	this->totalL1Cycles = stats.totalL1Cycles;
+	this->totalL2Cycles = stats.totalL2Cycles;
+	this->totalMemCycles = stats.totalMemCycles;
+	this->L1WriteBacks = stats.L1WriteBacks;
+	this->L2WriteBacks = stats.L2WriteBacks;
+	this->L2ReadBytes = stats.L2ReadBytes;
+	this->L2WriteBytes = stats.L2WriteBytes;
+	this->memReadBytes = stats.memReadBytes;
+	this->memWriteBytes = stats.memWriteBytes;
+	this->writeBufferStallCycles = stats.writeBufferStallCycles;
+	this->L1PrefetchStats = stats.L1Prefetch;
+	this->L2PrefetchStats = stats.L2Prefetch;
+	this->victimHits = stats.victimHits;
+	this->victimMisses = stats.victimMisses;
+	this->victimCycles = stats.victimCycles;
+	this->dramStats = stats.dram;
+	this->tlbStats = stats.tlb;
+	if (this->writeBufferDepth > 0 &&
+		!(checkpoint.readArray(this->writeBuffer, this->writeBufferDepth) &&
+		  checkpoint.readArray(&this->writeBufferHead, 1) &&
+		  checkpoint.readArray(&this->writeBufferCount, 1) &&
+		  checkpoint.readArray(&this->lastDrain, 1))) {
+		return false;
+	}
+	if (!this->L1Prefetcher.restoreState(checkpoint) || !this->L2Prefetcher.restoreState(checkpoint) ||
+		(this->L1Ready != nullptr &&
+		 !checkpoint.readArray(this->L1Ready, (size_t)this->L1NumSets * this->L1NumWays)) ||
+		(this->L2Ready != nullptr &&
+		 !checkpoint.readArray(this->L2Ready, (size_t)this->L2NumSets * this->L2NumWays))) {
+		return false;
+	}
+	if (this->victimEntries != VICTIM_OFF &&
+		!(checkpoint.readArray(this->victimBlocks, this->victimEntries) &&
+		  checkpoint.readArray(this->victimStamps, this->victimEntries) &&
+		  checkpoint.readArray(&this->victimClock, 1) &&
+		  checkpoint.readArray(&this->victimValid, 1) &&
+		  checkpoint.readArray(&this->victimDirty, 1))) {
+		return false;
+	}
+	if ((this->dram.isEnabled() && !this->dram.restoreState(checkpoint)) ||
+		(this->tlb.isEnabled() && !this->tlb.restoreState(checkpoint))) {
+		return false;
+	}
+	return this->L1.restoreState(checkpoint) && this->L2.restoreState(checkpoint) &&
+		   (this->L1ISize == L1I_OFF || this->L1I.restoreState(checkpoint));
+}
+
+template <class ReplacementPolicy>
+void BasicCache<ReplacementPolicy>::readFromCache(uint64_t address) {
+	ALLOCATION_FREE_SCOPE;
+	// narrow builds keep the low FULL_TAG_SIZE bits of the address
+	CacheTag block = (CacheTag)address >> this->BSize;
+	// the levels find the line from the block, and tell the set it is in
+	unsigned int L1Index, L2Index;
 	// read from L1
 	this->L1Reads++;
 	this->totalL1Cycles += this->L1Cyc;
-	if (L1Set->readFromLine(L1Tag)) { // L1 hit
-		L1Set->updateLRU(L1Set->getWay(L1Tag));
+	if (this->tlb.isEnabled() && this->translating) {
+		// an L1 DTLB miss holds up the access
+		this->totalL1Cycles += this->tlb.translate(address, this->tlbStats);
+	}
+	unsigned int L1Way = this->L1.findBlock(block, L1Index);
+	if (L1Way == NO_WAY && this->L1Prefetcher.getKind() == PREFETCH_STREAM) {
+		// a stream buffer hit fills L1 and then counts as an L1 hit
+		L1Way = this->streamFill(1, address >> this->BSize, L1Index);
+	}
+	bool L1Miss = L1Way == NO_WAY, L1PrefetchHit = false;
+	if (L1Way != NO_WAY) { // L1 hit
+		this->L1.touchLine(L1Index, L1Way);
+		if (this->L1Ready != nullptr && this->L1.getPrefetchState(L1Index, L1Way) == LINE_PREFETCHED) {
+			L1PrefetchHit = true;
+			this->usePrefetchedLine(1, L1Index, L1Way, this->L1Ready[(size_t)L1Index * this->L1NumWays + L1Way]);
+		}
 	} 
+	else if (this->victimEntries != VICTIM_OFF && this->probeVictim(block) != NO_WAY) {
+		// L1 miss, the victim cache swaps the line back into L1
+		this->L1ReadMisses++;
+		this->L1MissHandler(block, L1Index);
+	}
 	else { // L1 miss
 		this->L1ReadMisses++;
-		// calculate the address of the line in L2
-		unsigned int L2Index = (fullTag >> this->L2OffsetBits) & ((1 << this->L2IndexBits) - 1);
-		unsigned int L2Tag = fullTag >> (this->L2OffsetBits + this->L2IndexBits);
-		CacheSet* L2Set = &this->L2Sets[L2Index];
 		// read from L2
 		this->L2Reads++;
 		this->totalL2Cycles += this->L2Cyc;
-		if (L2Set->readFromLine(L2Tag)) { // L2 hit
-			unsigned int L2Way = L2Set->getWay(L2Tag);
-			L2Set->updateLRU(L2Way);
-			L2Set->updateDirty(L2Way, false);	
+		this->L2ReadBytes += this->BlockSize;
+		unsigned int L2Way = this->L2.findBlock(block, L2Index);
+		if (L2Way == NO_WAY && this->L2Prefetcher.getKind() == PREFETCH_STREAM) {
+			L2Way = this->streamFill(2, address >> this->BSize, L2Index);
+		}
+		bool L2Miss = L2Way == NO_WAY, L2PrefetchHit = false;
+		if (L2Way != NO_WAY) { // L2 hit
+			this->L2.touchLine(L2Index, L2Way);
+			if (this->L2Ready != nullptr && this->L2.getPrefetchState(L2Index, L2Way) == LINE_PREFETCHED) {
+				L2PrefetchHit = true;
+				this->usePrefetchedLine(2, L2Index, L2Way, this->L2Ready[(size_t)L2Index * this->L2NumWays + L2Way]);
+			}
 			// L2 hit, L1 miss, need to insert to L1
-			this->L1MissHandler(L1Tag, L1Index);
+			this->L1MissHandler(block, L1Index);
 		}
 		else { // L2 miss
 			this->L2ReadMisses++;
-			this->totalMemCycles += this->MemCyc;
+			this->totalMemCycles += this->memoryAccess(block, false);
+			this->memReadBytes += this->BlockSize;
 			// L2 miss, need to insert to L2 and L1
-			this->L2MissHandler(L1Tag, L1Index, L2Tag, L2Index);
+			this->L2MissHandler(block, L1Index);
+		}
+		if (this->L2Prefetcher.getKind() != PREFETCH_NONE) {
+			this->prefetchAccess(2, address >> this->BSize, L2Miss, L2PrefetchHit);
 		}
 	}
+	if (this->L1Prefetcher.getKind() != PREFETCH_NONE) {
+		this->prefetchAccess(1, address >> this->BSize, L1Miss, L1PrefetchHit);
+	}
 }
 
-void Cache::writeToCache(unsigned int fullTag) {
-	// calculate the address of the line in L1
-	unsigned int L1Index = (fullTag >> this->L1OffsetBits) & ((1 << this->L1IndexBits) - 1);
-	unsigned int L1Tag = fullTag >> (this->L1OffsetBits + this->L1IndexBits);
-	CacheSet* L1Set = &this->L1Sets[L1Index];
+template <class ReplacementPolicy>
+void BasicCache<ReplacementPolicy>::writeToCache(uint64_t address) {
+	ALLOCATION_FREE_SCOPE;
+	// narrow builds keep the low FULL_TAG_SIZE bits of the address
+	CacheTag block = (CacheTag)address >> this->BSize;
+	// the levels find the line from the block, and tell the set it is in
+	unsigned int L1Index, L2Index;
 	// write to L1
 	this->L1Writes++;
 	this->totalL1Cycles += this->L1Cyc;
-	if (L1Set->writeToLine(L1Tag)) { // L1 hit
-		L1Set->updateLRU(L1Set->getWay(L1Tag));
+	if (this->tlb.isEnabled()) {
+		this->totalL1Cycles += this->tlb.translate(address, this->tlbStats);
+	}
+	unsigned int L1Way = this->L1.findBlock(block, L1Index);
+	if (L1Way == NO_WAY && this->L1Prefetcher.getKind() == PREFETCH_STREAM &&
+		this->WrAlloc == WRITE_ALLOCATE) {
+		L1Way = this->streamFill(1, address >> this->BSize, L1Index);
+	}
+	bool L1Miss = L1Way == NO_WAY, L1PrefetchHit = false;
+	unsigned int victimEntry;
+	if (L1Way != NO_WAY) { // L1 hit
+		this->L1.touchLine(L1Index, L1Way);
+		this->L1.setDirty(L1Index, L1Way, true);
+		if (this->L1Ready != nullptr && this->L1.getPrefetchState(L1Index, L1Way) == LINE_PREFETCHED) {
+			L1PrefetchHit = true;
+			this->usePrefetchedLine(1, L1Index, L1Way, this->L1Ready[(size_t)L1Index * this->L1NumWays + L1Way]);
+		}
+	}
+	else if (this->victimEntries != VICTIM_OFF &&
+			 (victimEntry = this->probeVictim(block)) != NO_WAY) {
+		this->L1WriteMisses++;
+		if (this->WrAlloc == WRITE_ALLOCATE) {
+			// swap the line back into L1 and write it there
+			L1Way = this->L1MissHandler(block, L1Index);
+			this->L1.setDirty(L1Index, L1Way, true);
+		} else {
+			// write the line where it is
+			this->victimDirty |= (uint64_t)1 << victimEntry;
+		}
 	}
 	else { // L1 miss
 		this->L1WriteMisses++;
-		// calculate the address of the line in L2
-		unsigned int L2Index = (fullTag >> this->L2OffsetBits) & ((1 << this->L2IndexBits) - 1);
-		unsigned int L2Tag = fullTag >> (this->L2OffsetBits + this->L2IndexBits);
-		CacheSet* L2Set = &this->L2Sets[L2Index];
 		// write to L2
 		this->L2Writes++;
 		this->totalL2Cycles += this->L2Cyc;
+		unsigned int L2Way = this->L2.findBlock(block, L2Index);
+		if (L2Way == NO_WAY && this->L2Prefetcher.getKind() == PREFETCH_STREAM) {
+			L2Way = this->streamFill(2, address >> this->BSize, L2Index);
+		}
+		bool L2Miss = L2Way == NO_WAY, L2PrefetchHit = false;
+		if (L2Way != NO_WAY && this->L2Ready != nullptr &&
+			this->L2.getPrefetchState(L2Index, L2Way) == LINE_PREFETCHED) {
+			L2PrefetchHit = true;
+			this->usePrefetchedLine(2, L2Index, L2Way, this->L2Ready[(size_t)L2Index * this->L2NumWays + L2Way]);
+		}
 		// if write allocate - need to bring the line into L1 and write only to L1
 		if (this->WrAlloc == WRITE_ALLOCATE) {
-			if (L2Set->isLineInSet(L2Tag)) { // L2 hit
+			this->L2ReadBytes += this->BlockSize;
+			if (L2Way != NO_WAY) { // L2 hit
 				// update LRU in L2
-				L2Set->updateLRU(L2Set->getWay(L2Tag));
+				this->L2.touchLine(L2Index, L2Way);
 				// insert line to L1
-				this->L1MissHandler(L1Tag, L1Index);
-				// write to L1
-				L1Set->writeToLine(L1Tag);
-				L1Set->updateLRU(L1Set->getWay(L1Tag));
+				L1Way = this->L1MissHandler(block, L1Index);
 			}
 			else { // L2 miss
 				this->L2WriteMisses++;
-				this->totalMemCycles += this->MemCyc;
+				this->totalMemCycles += this->memoryAccess(block, false);
+				this->memReadBytes += this->BlockSize;
 				// insert to L2 and L1 
-				this->L2MissHandler(L1Tag, L1Index, L2Tag, L2Index);
-				// write to L1
-				L1Set->writeToLine(L1Tag);
-				L1Set->updateLRU(L1Set->getWay(L1Tag));
+				L1Way = this->L2MissHandler(block, L1Index);
 			}
+			// write to L1, the new line is already the most recently used
+			this->L1.setDirty(L1Index, L1Way, true);
 		}
 		// if no write allocate - search for the line in L2 and write to L2. if not found, write to memory
 		else { // no write allocate
-			if (L2Set->isLineInSet(L2Tag)) { // L2 hit
+			this->L2WriteBytes += this->BlockSize;
+			if (L2Way != NO_WAY) { // L2 hit
 				// write to L2
-				L2Set->writeToLine(L2Tag);
-				L2Set->updateLRU(L2Set->getWay(L2Tag));
+				this->L2.touchLine(L2Index, L2Way);
+				this->L2.setDirty(L2Index, L2Way, true);
 			}
 			else { // L2 miss
 				this->L2WriteMisses++;
 				// write to memory
-				this->totalMemCycles += this->MemCyc;
+				this->totalMemCycles += this->memoryAccess(block, true);
+				this->memWriteBytes += this->BlockSize;
+			}
+		}
+		if (this->L2Prefetcher.getKind() != PREFETCH_NONE) {
+			this->prefetchAccess(2, address >> this->BSize, L2Miss, L2PrefetchHit);
+		}
+	}
+	if (this->L1Prefetcher.getKind() != PREFETCH_NONE) {
+		this->prefetchAccess(1, address >> this->BSize, L1Miss, L1PrefetchHit);
+	}
+}
+
+template <class ReplacementPolicy>
+void BasicCache<ReplacementPolicy>::fetchFromCache(uint64_t address) {
+	ALLOCATION_FREE_SCOPE;
+	if (this->L1ISize == L1I_OFF) {
+		// a read of the unified L1, the counters it moved are the fetch's
+		uint64_t L1Misses = this->L1ReadMisses, L2Reads = this->L2Reads, L2Misses = this->L2ReadMisses;
+		this->translating = false;
+		this->readFromCache(address);
+		this->translating = true;
+		this->L1Fetches++;
+		this->L1FetchMisses += this->L1ReadMisses - L1Misses;
+		this->L2Fetches += this->L2Reads - L2Reads;
+		this->L2FetchMisses += this->L2ReadMisses - L2Misses;
+		return;
+	}
+	CacheTag block = (CacheTag)address >> this->BSize;
+	unsigned int L1IIndex, L2Index;
+	// fetch from L1I
+	this->L1Reads++;
+	this->L1Fetches++;
+	this->totalL1Cycles += this->L1ICyc;
+	unsigned int L1IWay = this->L1I.findBlock(block, L1IIndex);
+	if (L1IWay != NO_WAY) { // L1I hit
+		this->L1I.touchLine(L1IIndex, L1IWay);
+		return;
+	}
+	this->L1ReadMisses++;
+	this->L1FetchMisses++;
+	// read from L2
+	this->L2Reads++;
+	this->L2Fetches++;
+	this->totalL2Cycles += this->L2Cyc;
+	this->L2ReadBytes += this->BlockSize;
+	unsigned int L2Way = this->L2.findBlock(block, L2Index);
+	if (L2Way == NO_WAY && this->L2Prefetcher.getKind() == PREFETCH_STREAM) {
+		L2Way = this->streamFill(2, address >> this->BSize, L2Index);
+	}
+	bool L2Miss = L2Way == NO_WAY, L2PrefetchHit = false;
+	if (L2Way != NO_WAY) { // L2 hit
+		this->L2.touchLine(L2Index, L2Way);
+		if (this->L2Ready != nullptr && this->L2.getPrefetchState(L2Index, L2Way) == LINE_PREFETCHED) {
+			L2PrefetchHit = true;
+			this->usePrefetchedLine(2, L2Index, L2Way, this->L2Ready[(size_t)L2Index * this->L2NumWays + L2Way]);
+		}
+	}
+	else { // L2 miss
+		this->L2ReadMisses++;
+		this->L2FetchMisses++;
+		this->totalMemCycles += this->memoryAccess(block, false);
+		this->memReadBytes += this->BlockSize;
+		this->L2Fill(block, L2Index);
+	}
+	this->L1IFill(block);
+	if (this->L2Prefetcher.getKind() != PREFETCH_NONE) {
+		this->prefetchAccess(2, address >> this->BSize, L2Miss, L2PrefetchHit);
+	}
+}
+
+template <class ReplacementPolicy>
+bool BasicCache<ReplacementPolicy>::accessBatch(const uint64_t* addresses, const uint8_t* operations,
+												 size_t count) {
+	for (size_t i = 0; i < count; i++) {
+		if (i + BATCH_PREFETCH_DISTANCE < count) {
+			// L2 only matters on a miss, but the prefetch costs nothing on a hit
+			CacheTag block = (CacheTag)addresses[i + BATCH_PREFETCH_DISTANCE] >> this->BSize;
+			if (operations[i + BATCH_PREFETCH_DISTANCE] == ACCESS_FETCH && this->L1ISize != L1I_OFF) {
+				this->L1I.prefetchSet(this->L1I.homeSet(block));
+			} else {
+				this->L1.prefetchSet(this->L1.homeSet(block));
 			}
+			this->L2.prefetchSet(this->L2.homeSet(block));
+		}
+		if (operations[i] == ACCESS_READ) {
+			this->readFromCache(addresses[i]);
+		} else if (operations[i] == ACCESS_WRITE) {
+			this->writeToCache(addresses[i]);
+		} else if (operations[i] == ACCESS_FETCH) {
+			this->fetchFromCache(addresses[i]);
+		} else {
+			return false;
+		}
+	}
+	return true;
+}
+
+template <class ReplacementPolicy>
+void BasicCache<ReplacementPolicy>::warmAccess(uint64_t address, bool write) {
+	ALLOCATION_FREE_SCOPE;
+	// the miss handlers count write-backs, unless told not to
+	this->counting = false;
+	if (this->tlb.isEnabled()) {
+		TlbStats uncounted = TlbStats();
+		this->tlb.translate(address, uncounted);
+	}
+	this->warmLine(address, write);
+	this->counting = true;
+}
+
+template <class ReplacementPolicy>
+void BasicCache<ReplacementPolicy>::warmFetch(uint64_t address) {
+	ALLOCATION_FREE_SCOPE;
+	// like warmAccess, without the DTLB
+	this->counting = false;
+	if (this->L1ISize == L1I_OFF) {
+		this->warmLine(address, false);
+		this->counting = true;
+		return;
+	}
+	CacheTag block = (CacheTag)address >> this->BSize;
+	unsigned int L1IIndex, L2Index;
+	unsigned int L1IWay = this->L1I.findBlock(block, L1IIndex);
+	if (L1IWay != NO_WAY) {
+		this->L1I.touchLine(L1IIndex, L1IWay);
+	} else {
+		unsigned int L2Way = this->L2.findBlock(block, L2Index);
+		if (L2Way != NO_WAY) {
+			this->L2.touchLine(L2Index, L2Way);
+		} else {
+			this->L2Fill(block, L2Index);
+		}
+		this->L1IFill(block);
+	}
+	this->counting = true;
+}
+
+template <class ReplacementPolicy>
+void BasicCache<ReplacementPolicy>::replayHits(uint64_t reads, uint64_t writes, uint64_t fetches) {
+	// a fetch hit is a read hit, of the L1I when there is one
+	this->L1Reads += reads + fetches;
+	this->L1Writes += writes;
+	this->L1Fetches += fetches;
+	this->totalL1Cycles += (reads + writes) * this->L1Cyc +
+						   fetches * (this->L1ISize != L1I_OFF ? this->L1ICyc : this->L1Cyc);
+}
+
+template <class ReplacementPolicy>
+void BasicCache<ReplacementPolicy>::replayEviction(CacheTag block) {
+	this->replayPending = true;
+	this->replayVictim = block;
+}
+
+template <class ReplacementPolicy>
+void BasicCache<ReplacementPolicy>::warmLine(uint64_t address, bool write) {
+	CacheTag block = (CacheTag)address >> this->BSize;
+	unsigned int L1Index, L2Index;
+	unsigned int L1Way = this->L1.findBlock(block, L1Index);
+	if (L1Way != NO_WAY) {
+		this->L1.touchLine(L1Index, L1Way);
+		if (write) {
+			this->L1.setDirty(L1Index, L1Way, true);
+		}
+		return;
+	}
+	unsigned int victimEntry = NO_WAY;
+	if (this->victimEntries != VICTIM_OFF) {
+		victimEntry = this->findVictim(block);
+	}
+	if (victimEntry != NO_WAY) {
+		// as in writeToCache, a write that does not allocate stays in the victim cache
+		this->victimStamps[victimEntry] = ++this->victimClock;
+		if (write && this->WrAlloc != WRITE_ALLOCATE) {
+			this->victimDirty |= (uint64_t)1 << victimEntry;
+			return;
+		}
+		L1Way = this->L1MissHandler(block, L1Index);
+		if (write) {
+			this->L1.setDirty(L1Index, L1Way, true);
 		}
+		return;
+	}
+	unsigned int L2Way = this->L2.findBlock(block, L2Index);
+	if (L2Way != NO_WAY) {
+		this->L2.touchLine(L2Index, L2Way);
+	}
+	if (write && this->WrAlloc != WRITE_ALLOCATE) {
+		// the write stays in L2 (or goes to memory)
+		if (L2Way != NO_WAY) {
+			this->L2.setDirty(L2Index, L2Way, true);
+		}
+		return;
+	}
+	if (L2Way != NO_WAY) {
+		L1Way = this->L1MissHandler(block, L1Index);
+	} else {
+		L1Way = this->L2MissHandler(block, L1Index);
+	}
+	if (write) {
+		this->L1.setDirty(L1Index, L1Way, true);
 	}
 }
 
-void Cache::L1MissHandler(unsigned int L1Tag, unsigned int L1Index) {
-	CacheSet* L1Set = &this->L1Sets[L1Index];
-	if (L1Set->insertLine(L1Tag)) {
-		// successful insert
+template <class ReplacementPolicy>
+uint64_t BasicCache<ReplacementPolicy>::memoryAccess(uint64_t block, bool write) {
+	if (!this->dram.isEnabled()) {
+		return this->MemCyc;
+	}
+	return this->dram.access(block, write, this->getNow(), this->dramStats);
+}
+
+template <class ReplacementPolicy>
+void BasicCache<ReplacementPolicy>::writeBackToMemory(CacheTag block) {
+	this->L2WriteBacks++;
+	this->memWriteBytes += this->BlockSize;
+	if (this->writeBufferDepth == WRITE_BUFFER_OFF) {
+		// free for the access, but a DRAM bank is still busy with it
+		this->memoryAccess(block, true);
+		return;
+	}
+	uint64_t stall = 0;
+	if (this->writeBufferDepth == 0) {
+		stall = this->memoryAccess(block, true);
+	} else {
+		// memory reads go first, the buffer drains in the cycles memory is otherwise idle:
+		// those spent in L1 and L2, and those spent stalled on the buffer
+		uint64_t now = this->totalL1Cycles + this->totalL2Cycles + this->writeBufferStallCycles;
+		while (this->writeBufferCount > 0 && this->writeBuffer[this->writeBufferHead] <= now) {
+			this->writeBufferHead = (this->writeBufferHead + 1) % this->writeBufferDepth;
+			this->writeBufferCount--;
+		}
+		if (this->writeBufferCount == (unsigned int)this->writeBufferDepth) {
+			// full, wait for the oldest write-back
+			stall = this->writeBuffer[this->writeBufferHead] - now;
+			now += stall;
+			this->writeBufferHead = (this->writeBufferHead + 1) % this->writeBufferDepth;
+			this->writeBufferCount--;
+		}
+		this->lastDrain = max(now, this->lastDrain) + this->memoryAccess(block, true);
+		unsigned int tail = (this->writeBufferHead + this->writeBufferCount) % this->writeBufferDepth;
+		this->writeBuffer[tail] = this->lastDrain;
+		this->writeBufferCount++;
 	}
+	this->totalMemCycles += stall;
+	this->writeBufferStallCycles += stall;
+}
+
+template <class ReplacementPolicy>
+unsigned int BasicCache<ReplacementPolicy>::L1MissHandler(CacheTag block, unsigned int& L1Index) {
+	bool dirty = false;
+	if (this->victimEntries != VICTIM_OFF) {
+		// a line never sits in L1 and the victim cache at once, and a swap frees the entry the
+		// L1 victim takes
+		unsigned int entry = this->findVictim(block);
+		if (entry != NO_WAY) {
+			dirty = this->removeVictim(entry);
+		}
+	}
+	if (this->replayPending) {
+		// the line the recorded L1 evicted, unless an L2 eviction took it already
+		this->replayPending = false;
+		unsigned int evictedL1Index;
+		unsigned int evictedL1Way = this->L1.findBlock(this->replayVictim, evictedL1Index);
+		if (evictedL1Way != NO_WAY) {
+			EvictedLine victim = this->L1.evictLine(evictedL1Index, evictedL1Way);
+			this->countEviction(1, victim);
+			if (victim.dirty) {
+				this->writeBackToL2(this->replayVictim);
+			}
+		}
+	}
+	unsigned int L1Way = this->L1.insertBlock(block, L1Index);
 	// L1 is full, need to evict
-	else {
-		CacheLine* evictedLine = L1Set->removeLine();
-		if (evictedLine->getDirty()) {
-			// calculate the address of the evicted line
-			unsigned int evictedFullTag = (evictedLine->getTag() << (this->L1IndexBits)) | L1Index;
-			unsigned int evictedL2Index = (evictedFullTag) & ((1 << this->L2IndexBits) - 1);
-			unsigned int evictedL2Tag = evictedFullTag >> (this->L2IndexBits);
-			// write to L2
-			CacheSet* L2SetEvicted = &this->L2Sets[evictedL2Index];
-			unsigned int evictedL2Way = L2SetEvicted->getWay(evictedL2Tag);
-			L2SetEvicted->updateLRU(evictedL2Way);
-			L2SetEvicted->updateDirty(evictedL2Way, false);
-		}
-		delete evictedLine;
+	if (L1Way == NO_WAY) {
+		EvictedLine victim = this->L1.evictLine(L1Index, this->L1.selectBlockVictim(block, L1Index));
+		this->countEviction(1, victim);
+		// calculate the address of the evicted line
+		CacheTag evictedBlock = this->L1.getBlock(victim.tag, L1Index);
+		if (this->victimEntries != VICTIM_OFF) {
+			this->insertVictim(evictedBlock, victim.dirty);
+		} else if (victim.dirty) {
+			this->writeBackToL2(evictedBlock);
+		}
 		// write to L1 (there is a free line now)
-		L1Set->insertLine(L1Tag);
+		L1Way = this->L1.insertBlock(block, L1Index);
+	}
+	if (dirty) {
+		this->L1.setDirty(L1Index, L1Way, true);
 	}
-	L1Set->updateLRU(L1Set->getWay(L1Tag));
+	// a freshly inserted line is already the most recently used
+	return L1Way;
 }
 
+template <class ReplacementPolicy>
+void BasicCache<ReplacementPolicy>::writeBackToL2(CacheTag block) {
+	if (this->counting) {
+		this->L1WriteBacks++;
+		this->L2WriteBytes += this->BlockSize;
+	}
+	// write to L2
+	unsigned int L2Index;
+	unsigned int L2Way = this->L2.findBlock(block, L2Index);
+	if (L2Way != NO_WAY) {
+		this->L2.touchLine(L2Index, L2Way);
+		// L2 now holds the only up to date copy
+		this->L2.setDirty(L2Index, L2Way, true);
+	}
+}
 
-void Cache::L2MissHandler(unsigned int L1Tag, unsigned int L1Index, 
-							  unsigned int L2Tag, unsigned int L2Index) {
-	CacheSet* L2Set = &this->L2Sets[L2Index];
+
+template <class ReplacementPolicy>
+unsigned int BasicCache<ReplacementPolicy>::L2MissHandler(CacheTag block, unsigned int& L1Index) {
+	unsigned int L2Index;
+	this->L2Fill(block, L2Index);
+	// insert to L1
+	return this->L1MissHandler(block, L1Index);
+}
+
+template <class ReplacementPolicy>
+unsigned int BasicCache<ReplacementPolicy>::L2Fill(CacheTag block, unsigned int& L2Index) {
 	// try to insert to L2
-	if (L2Set->insertLine(L2Tag)) {
-		// insert to L1
-		this->L1MissHandler(L1Tag, L1Index);
-	}
+	unsigned int L2Way = this->L2.insertBlock(block, L2Index);
 	// L2 is full, need to evict
-	else {
-		// select victim P from L2
-		CacheLine* evictedLineL2 = L2Set->removeLine();
-		unsigned int evictedFullTag = (evictedLineL2->getTag() << (this->L2IndexBits)) | L2Index;
+	if (L2Way == NO_WAY) {
+		// evict victim P from L2
+		EvictedLine victim = this->L2.evictLine(L2Index, this->L2.selectBlockVictim(block, L2Index));
+		this->countEviction(2, victim);
+		CacheTag evictedBlock = this->L2.getBlock(victim.tag, L2Index);
 
 		// snoop victim P from L1
-		unsigned int evictedL1Index = (evictedFullTag) & ((1 << this->L1IndexBits) - 1);
-		unsigned int evictedL1Tag = evictedFullTag >> (this->L1IndexBits);
-
-		CacheSet* L1SetEvicted = &this->L1Sets[evictedL1Index];
-		unsigned int evictedL1Way = L1SetEvicted->getWay(evictedL1Tag);
+		unsigned int evictedL1Index;
+		unsigned int evictedL1Way = this->L1.findBlock(evictedBlock, evictedL1Index);
 		// evict P from L1 if in L1 (update L2 if needed)
-		if (evictedL1Way != (unsigned int)-1) { // if in L1
+		if (evictedL1Way != NO_WAY) { // if in L1
 			// evict P from L1
-			CacheLine* evictedLineL1 = L1SetEvicted->removeLine(evictedL1Way);
-			if (evictedLineL1->getDirty()) {
-				evictedLineL2->setDirty(true);
+			EvictedLine copy = this->L1.evictLine(evictedL1Index, evictedL1Way);
+			this->countEviction(1, copy);
+			victim.dirty |= copy.dirty;
+		} else if (this->victimEntries != VICTIM_OFF) {
+			// or from the victim cache
+			unsigned int entry = this->findVictim(evictedBlock);
+			if (entry != NO_WAY) {
+				victim.dirty |= this->removeVictim(entry);
+			}
+		}
+		if (this->L1ISize != L1I_OFF) {
+			// and from L1I, which may hold it as well
+			unsigned int evictedL1IIndex;
+			unsigned int evictedL1IWay = this->L1I.findBlock(evictedBlock, evictedL1IIndex);
+			if (evictedL1IWay != NO_WAY) {
+				this->L1I.removeLine(evictedL1IIndex, evictedL1IWay);
 			}
-			delete evictedLineL1;
 		}
-		// evict P from L2
-		delete evictedLineL2;
 		// write to memeory the evicted line
-		
+		if (victim.dirty && this->counting) {
+			this->writeBackToMemory(evictedBlock);
+		}
+
 		// insert the line we missed to L2
-		L2Set->insertLine(L2Tag);
-		L2Set->updateLRU(L2Set->getWay(L2Tag));
-		// insert to L1
-		this->L1MissHandler(L1Tag, L1Index);
+		L2Way = this->L2.insertBlock(block, L2Index);
+	}
+	return L2Way;
+}
+
+template <class ReplacementPolicy>
+void BasicCache<ReplacementPolicy>::L1IFill(CacheTag block) {
+	unsigned int L1IIndex;
+	if (this->replayPending) {
+		this->replayPending = false;
+		unsigned int L1IWay = this->L1I.findBlock(this->replayVictim, L1IIndex);
+		if (L1IWay != NO_WAY) {
+			this->L1I.removeLine(L1IIndex, L1IWay);
+		}
+	}
+	if (this->L1I.insertBlock(block, L1IIndex) == NO_WAY) {
+		// L1I is full, its lines are clean and just dropped
+		this->L1I.removeLine(L1IIndex, this->L1I.selectBlockVictim(block, L1IIndex));
+		this->L1I.insertBlock(block, L1IIndex);
 	}
 }
 
 /**********************************************************************************************/
+// Victim cache, see VICTIM_OFF
 
-int main(int argc, char **argv) {
-
-	if (argc < 19) {
-		cerr << "Not enough arguments" << endl;
-		return 0;
-	}
-
-	// Get input arguments
-
-	// File
-	// Assuming it is the first argument
-	char* fileString = argv[1];
-	ifstream file(fileString); //input file stream
-	string line;
-	if (!file || !file.good()) {
-		// File doesn't exist or some other error
-		cerr << "File not found" << endl;
-		return 0;
-	}
-
-	unsigned int MemCyc = 0, BSize = 0, L1Size = 0, L2Size = 0, L1Assoc = 0,
-			L2Assoc = 0, L1Cyc = 0, L2Cyc = 0, WrAlloc = 0;
-
-	for (int i = 2; i < 19; i += 2) {
-		string s(argv[i]);
-		if (s == "--mem-cyc") {
-			MemCyc = atoi(argv[i + 1]);
-		} else if (s == "--bsize") {
-			BSize = atoi(argv[i + 1]);
-		} else if (s == "--l1-size") {
-			L1Size = atoi(argv[i + 1]);
-		} else if (s == "--l2-size") {
-			L2Size = atoi(argv[i + 1]);
-		} else if (s == "--l1-cyc") {
-			L1Cyc = atoi(argv[i + 1]);
-		} else if (s == "--l2-cyc") {
-			L2Cyc = atoi(argv[i + 1]);
-		} else if (s == "--l1-assoc") {
-			L1Assoc = atoi(argv[i + 1]);
-		} else if (s == "--l2-assoc") {
-			L2Assoc = atoi(argv[i + 1]);
-		} else if (s == "--wr-alloc") {
-			WrAlloc = atoi(argv[i + 1]);
-		} else {
-			cerr << "Error in arguments" << endl;
-			return 0;
+template <class ReplacementPolicy>
+inline unsigned int BasicCache<ReplacementPolicy>::findVictim(CacheTag block) {
+	for (uint64_t valid = this->victimValid; valid != 0; valid &= valid - 1) {
+		unsigned int entry = __builtin_ctzll(valid);
+		if (this->victimBlocks[entry] == block) {
+			return entry;
 		}
 	}
+	return NO_WAY;
+}
 
-	// create cache
-	Cache cache(MemCyc, BSize, L1Size, L2Size, L1Assoc, L2Assoc, 
-				L1Cyc, L2Cyc, WrAlloc);
+// findVictim for an L1 miss, counting the probe
+template <class ReplacementPolicy>
+unsigned int BasicCache<ReplacementPolicy>::probeVictim(CacheTag block) {
+	this->totalL1Cycles += this->VictimCyc;
+	this->victimCycles += this->VictimCyc;
+	unsigned int entry = this->findVictim(block);
+	if (entry == NO_WAY) {
+		this->victimMisses++;
+	} else {
+		this->victimHits++;
+		this->victimStamps[entry] = ++this->victimClock;
+	}
+	return entry;
+}
 
-	while (getline(file, line)) {
+// frees entry, returns its dirty bit
+template <class ReplacementPolicy>
+bool BasicCache<ReplacementPolicy>::removeVictim(unsigned int entry) {
+	uint64_t bit = (uint64_t)1 << entry;
+	bool dirty = (this->victimDirty & bit) != 0;
+	this->victimValid &= ~bit;
+	this->victimDirty &= ~bit;
+	return dirty;
+}
 
-		stringstream ss(line);
-		string address;
-		char operation = 0; // read (r) or write (w)
-		if (!(ss >> operation >> address)) {
-			// Operation appears in an Invalid format
-			cout << "Command Format error" << endl;
-			return 0;
+template <class ReplacementPolicy>
+void BasicCache<ReplacementPolicy>::insertVictim(CacheTag block, bool dirty) {
+	uint64_t all = this->victimEntries == 64 ? ~(uint64_t)0 : ((uint64_t)1 << this->victimEntries) - 1;
+	unsigned int entry;
+	if (this->victimValid != all) {
+		entry = __builtin_ctzll(~this->victimValid);
+	} else {
+		// full, drop the least recently used line
+		entry = 0;
+		for (unsigned int i = 1; i < this->victimEntries; i++) {
+			if (this->victimStamps[i] < this->victimStamps[entry]) {
+				entry = i;
+			}
+		}
+		if (this->removeVictim(entry)) {
+			this->writeBackToL2(this->victimBlocks[entry]);
 		}
+	}
+	uint64_t bit = (uint64_t)1 << entry;
+	this->victimBlocks[entry] = block;
+	this->victimStamps[entry] = ++this->victimClock;
+	this->victimValid |= bit;
+	if (dirty) {
+		this->victimDirty |= bit;
+	}
+}
 
-		string cutAddress = address.substr(2); // Removing the "0x" part of the address
+/**********************************************************************************************/
+// Cache prefetching, see prefetch.hpp
 
-		unsigned long int fullTag = 0;
-		fullTag = strtoul(cutAddress.c_str(), NULL, 16);
+template <class ReplacementPolicy>
+inline uint64_t BasicCache<ReplacementPolicy>::getNow() {
+	// the serial clock
+	return this->totalL1Cycles + this->totalL2Cycles + this->totalMemCycles;
+}
+
+template <class ReplacementPolicy>
+void BasicCache<ReplacementPolicy>::usePrefetchedLine(unsigned int level, unsigned int set,
+													   unsigned int way, uint64_t ready) {
+	PrefetchStats& stats = level == 1 ? this->L1PrefetchStats : this->L2PrefetchStats;
+	(level == 1 ? this->L1 : this->L2).setPrefetchState(set, way, LINE_PREFETCH_USED);
+	stats.useful++;
+	uint64_t now = this->getNow();
+	if (ready > now) {
+		// the demand access waits for the rest of the prefetch
+		stats.late++;
+		stats.lateCycles += ready - now;
+		this->totalMemCycles += ready - now;
+	}
+}
+
+template <class ReplacementPolicy>
+inline void BasicCache<ReplacementPolicy>::countEviction(unsigned int level, const EvictedLine& victim) {
+	if (victim.prefetch == LINE_DEMAND || !this->counting) {
+		return;
+	}
+	PrefetchStats& stats = level == 1 ? this->L1PrefetchStats : this->L2PrefetchStats;
+	if (victim.prefetch == LINE_PREFETCHED) {
+		stats.evictedUnused++;
+	} else {
+		stats.evictedUsed++;
+	}
+}
+
+template <class ReplacementPolicy>
+unsigned int BasicCache<ReplacementPolicy>::streamFill(unsigned int level, uint64_t block, unsigned int& set) {
+	Prefetcher& prefetcher = level == 1 ? this->L1Prefetcher : this->L2Prefetcher;
+	int buffer = prefetcher.findStream(block);
+	if (buffer < 0) {
+		return NO_WAY;
+	}
+	uint64_t ready = prefetcher.popStream(buffer);
+	// the line comes from the buffer, moving it costs no traffic
+	CacheTag cacheBlock = (CacheTag)(block << this->BSize) >> this->BSize;
+	unsigned int L2Index, way;
+	if (level == 1) {
+		// L1 stays inclusive in L2
+		if (this->L2.findBlock(cacheBlock, L2Index) == NO_WAY) {
+			this->L2Fill(cacheBlock, L2Index);
+		}
+		way = this->L1MissHandler(cacheBlock, set);
+	} else {
+		way = this->L2Fill(cacheBlock, set);
+	}
+	this->usePrefetchedLine(level, set, way, ready);
+	this->refillStream(level, buffer);
+	return way;
+}
 
-		if (operation == 'r') {
-			cache.readFromCache(fullTag);
-		} else if (operation == 'w') {
-			cache.writeToCache(fullTag);
+template <class ReplacementPolicy>
+void BasicCache<ReplacementPolicy>::refillStream(unsigned int level, int buffer) {
+	Prefetcher& prefetcher = level == 1 ? this->L1Prefetcher : this->L2Prefetcher;
+	PrefetchStats& stats = level == 1 ? this->L1PrefetchStats : this->L2PrefetchStats;
+	while (!prefetcher.streamFull(buffer)) {
+		CacheTag cacheBlock = (CacheTag)(prefetcher.nextStreamBlock(buffer) << this->BSize) >> this->BSize;
+		uint64_t latency;
+		if (level == 1) {
+			// L1 buffers read L2, or memory around it
+			unsigned int L2Index;
+			this->L2ReadBytes += this->BlockSize;
+			if (this->L2.findBlock(cacheBlock, L2Index) != NO_WAY) {
+				latency = this->L2Cyc;
+			} else {
+				latency = this->L2Cyc + this->memoryAccess(cacheBlock, false);
+				this->memReadBytes += this->BlockSize;
+			}
 		} else {
-			// Operation appears in an Invalid format
-			cout << "Operation Format error" << endl;
-			return 0;
+			latency = this->memoryAccess(cacheBlock, false);
+			this->memReadBytes += this->BlockSize;
 		}
+		prefetcher.pushStream(buffer, this->getNow() + latency);
+		stats.issued++;
 	}
-	
+}
 
-	// Calculate L1MissRate, L2MissRate, avgAccTime
-	double L1MissRate = (double)(cache.getL1ReadMisses() + cache.getL1WriteMisses()) / 
-						(cache.getL1Reads() + cache.getL1Writes());
-	double L2MissRate = (double)(cache.getL2ReadMisses() + cache.getL2WriteMisses()) / 
-						(cache.getL2Reads() + cache.getL2Writes());
-	double avgAccTime = (double)(cache.getTotalL1Cycles() + cache.getTotalL2Cycles() + cache.getTotalMemCycles()) / 
-						(cache.getL1Reads() + cache.getL1Writes());
+template <class ReplacementPolicy>
+void BasicCache<ReplacementPolicy>::prefetchBlock(unsigned int level, uint64_t block) {
+	CacheTag cacheBlock = (CacheTag)(block << this->BSize) >> this->BSize;
+	unsigned int L1Index, L2Index;
+	unsigned int L2Way = this->L2.findBlock(cacheBlock, L2Index);
+	if (level == 2) {
+		if (L2Way != NO_WAY) {
+			return;
+		}
+		this->memReadBytes += this->BlockSize;
+		L2Way = this->L2Fill(cacheBlock, L2Index);
+		this->L2.setPrefetchState(L2Index, L2Way, LINE_PREFETCHED);
+		this->L2Ready[(size_t)L2Index * this->L2NumWays + L2Way] = this->getNow() + this->memoryAccess(cacheBlock, false);
+		this->L2PrefetchStats.issued++;
+		return;
+	}
+	if (this->L1.findBlock(cacheBlock, L1Index) != NO_WAY ||
+		(this->victimEntries != VICTIM_OFF && this->findVictim(cacheBlock) != NO_WAY)) {
+		return;
+	}
+	uint64_t latency = this->L2Cyc;
+	this->L2ReadBytes += this->BlockSize;
+	if (L2Way != NO_WAY) {
+		this->L2.touchLine(L2Index, L2Way);
+	} else {
+		latency += this->memoryAccess(cacheBlock, false);
+		this->memReadBytes += this->BlockSize;
+		this->L2Fill(cacheBlock, L2Index);
+	}
+	unsigned int L1Way = this->L1MissHandler(cacheBlock, L1Index);
+	this->L1.setPrefetchState(L1Index, L1Way, LINE_PREFETCHED);
+	this->L1Ready[(size_t)L1Index * this->L1NumWays + L1Way] = this->getNow() + latency;
+	this->L1PrefetchStats.issued++;
+}
 
-	printf("L1miss=%.03f ", L1MissRate);
-	printf("L2miss=%.03f ", L2MissRate);
-	printf("AccTimeAvg=%.03f\n", avgAccTime);
-	return 0;
+template <class ReplacementPolicy>
+void BasicCache<ReplacementPolicy>::prefetchAccess(unsigned int level, uint64_t block, bool miss,
+													bool prefetchHit) {
+	Prefetcher& prefetcher = level == 1 ? this->L1Prefetcher : this->L2Prefetcher;
+	if (prefetcher.getKind() == PREFETCH_STREAM) {
+		if (miss) {
+			// no buffer had the line
+			unsigned int dropped;
+			int buffer = prefetcher.restartStream(block, dropped);
+			(level == 1 ? this->L1PrefetchStats : this->L2PrefetchStats).evictedUnused += dropped;
+			this->refillStream(level, buffer);
+		}
+		return;
+	}
+	uint64_t blocks[MAX_PREFETCH_DEGREE];
+	unsigned int count = prefetcher.train(block, miss, prefetchHit, blocks);
+	for (unsigned int i = 0; i < count; i++) {
+		this->prefetchBlock(level, blocks[i]);
+	}
 }
+
+// every policy dispatchReplacementPolicy can pick, the levels are also used by coherence.cpp
+template class CacheLevel<LRUPolicy>;
+template class CacheLevel<TreePLRUPolicy>;
+template class CacheLevel<SRRIPPolicy>;
+template class CacheLevel<BRRIPPolicy>;
+template class CacheLevel<FIFOPolicy>;
+template class CacheLevel<RandomPolicy>;
+template class BasicCache<LRUPolicy>;
+template class BasicCache<TreePLRUPolicy>;
+template class BasicCache<SRRIPPolicy>;
+template class BasicCache<BRRIPPolicy>;
+template class BasicCache<FIFOPolicy>;
+template class BasicCache<RandomPolicy>;
@@ -5,62 +5,208 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <stdint.h>
+
+#include "allocCheck.hpp"
+#include "checkpoint.hpp"
+#include "dram.hpp"
+#include "index.hpp"
+#include "prefetch.hpp"
+#include "replacement.hpp"
+#include "tlb.hpp"
+#include "trace.hpp"
+
+// Tag (and block address) width, fixed at compile time. The default 32-bit tags keep the
+// low 32 bits of every address, `make TAG64=1` stores 64-bit tags for traces with wider
+// (x86-64 virtual or physical) addresses, at half as many tags per vector compare.
+#ifdef CACHESIM_TAG64
+typedef uint64_t CacheTag;
+#define FULL_TAG_SIZE 64
+#else
+typedef uint32_t CacheTag;
+#define FULL_TAG_SIZE 32
+#endif
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define TAG_LANES (256 / FULL_TAG_SIZE) // tags compared per vector instruction
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define TAG_LANES (128 / FULL_TAG_SIZE)
+#else
+#define TAG_LANES 1
+#endif
+
+// The block lookups sit on every access, and the compiler gives up inlining them into the
+// long access functions on its own
+#if defined(__GNUC__)
+#define HOT_INLINE inline __attribute__((always_inline))
+#else
+#define HOT_INLINE inline
+#endif
 
 #define READ "r"
 #define WRITE "w"
-#define FULL_TAG_SIZE 32
+#define NO_WAY ((unsigned int)-1)
+
+// Operations of accessBatch, the op bits of the binary trace format
+#define ACCESS_READ 0
+#define ACCESS_WRITE 1
+#define ACCESS_FETCH 2
+// accessBatch prefetches the sets of the access this many ahead of the one it simulates
+#define BATCH_PREFETCH_DISTANCE 8
 
 using  namespace std;
 
+// Write-backs to memory cost no cycles by default, which keeps the access times of the
+// original model. With a write buffer depth of 0 every write-back stalls its access for
+// MemCyc. A deeper buffer absorbs write-backs and drains them one per MemCyc cycles, in the
+// cycles memory spends no time on misses. An access only stalls on a full buffer, until its
+// oldest write-back is done.
+#define WRITE_BUFFER_OFF -1
+#define MAX_WRITE_BUFFER 1024
+
+// The victim cache (Jouppi, 1990), a small fully associative LRU buffer of the lines L1 evicts.
+// L1 misses probe it for VictimCyc cycles before going to L2, and a hit swaps the line back
+// into L1 with the L1 victim taking its entry. Lines it drops are written back to L2 if dirty.
+// L2 stays inclusive of both L1 and the buffer, its evictions invalidate the block in either.
+#define VICTIM_OFF 0
+#define MIN_VICTIM_ENTRIES 4
+#define MAX_VICTIM_ENTRIES 64 // the valid and dirty bits are one word each
+
+// Instruction fetches (the "i" trace operation) go to an L1 instruction cache of their own
+// when L1ISize is set, and L1 is then the data cache. L2 stays unified and inclusive of both,
+// its evictions invalidate the block in either. Instruction lines are never written, so the
+// L1I evicts them without a write-back, and writes do not look at the L1I (no self modifying
+// code). The victim cache and the L1 prefetcher serve the L1D only. Without an L1I a fetch
+// is a read of the one L1. Either way a fetch counts as a read of the levels it reaches, and
+// the fetch counters tell its share, but it is not translated by the (data) TLB, see tlb.hpp.
+#define L1I_OFF 0
+
 enum WriteAllocatePolicy {
     NO_WRITE_ALLOCATE = 0,
     WRITE_ALLOCATE = 1
 };
 
 
-class CacheLine {
-private:
-    unsigned int tag;
-    bool valid;
+// Cache constructor parameters, same units as the command line
+struct CacheConfig {
+    unsigned int MemCyc;
+    unsigned int BSize;
+    unsigned int L1Size, L2Size;
+    unsigned int L1Assoc, L2Assoc;
+    unsigned int L1Cyc, L2Cyc;
+    unsigned int WrAlloc;
+    ReplacementPolicyKind replacement; // both levels use the same policy
+    int writeBufferDepth; // WRITE_BUFFER_OFF, or how write-backs to memory are charged
+    PrefetchConfig L1Prefetch, L2Prefetch; // see prefetch.hpp
+    unsigned int victimEntries; // VICTIM_OFF, or the lines of the victim cache
+    unsigned int VictimCyc; // victim cache probe time in cycles
+    IndexKind L1Indexing, L2Indexing; // set index functions, see index.hpp
+    DramConfig dram; // DRAM_OFF channels for the flat MemCyc, see dram.hpp
+    TlbConfig tlb; // TLB_OFF L1 entries for no address translation, see tlb.hpp
+    unsigned int L1ISize, L1IAssoc, L1ICyc; // L1I_OFF size for one L1 of data and instructions
+};
+
+// Snapshot of the Cache counters, partial runs of one configuration can be summed with +=
+// and the counters of a stretch of a run are the difference of two snapshots
+struct CacheStats {
+    uint64_t L1Reads, L1ReadMisses, L1Writes, L1WriteMisses;
+    uint64_t L2Reads, L2ReadMisses, L2Writes, L2WriteMisses;
+    uint64_t L1Fetches, L1FetchMisses, L2Fetches, L2FetchMisses; // part of the reads and read misses
+    uint64_t totalL1Cycles, totalL2Cycles, totalMemCycles;
+    // traffic, every transfer is a whole block (traces have no access sizes)
+    uint64_t L1WriteBacks, L2WriteBacks; // dirty victims written to the next level
+    uint64_t L2ReadBytes, L2WriteBytes; // between L1 and L2: fills, write-backs, L1 write misses
+    uint64_t memReadBytes, memWriteBytes; // between L2 and memory
+    uint64_t writeBufferStallCycles; // part of totalMemCycles
+    PrefetchStats L1Prefetch, L2Prefetch;
+    uint64_t victimHits, victimMisses; // probes of the victim cache, one per L1 miss
+    uint64_t victimCycles; // part of totalL1Cycles
+    DramStats dram; // latencyCycles are part of totalMemCycles
+    TlbStats tlb; // cycles are part of totalL1Cycles
+    CacheStats& operator+=(const CacheStats& other);
+    CacheStats& operator-=(const CacheStats& other);
+};
+
+// How a line got into a level, for the prefetch statistics
+enum PrefetchLineState {
+    LINE_DEMAND = 0,
+    LINE_PREFETCHED = 1, // by a prefetch, no demand access used it yet
+    LINE_PREFETCH_USED = 2
+};
+
+// A line taken out of a level, returned by value so evictions never touch the heap
+struct EvictedLine {
+    CacheTag tag;
     bool dirty;
-    unsigned int LRU;
-public:
-    CacheLine(unsigned int initialLRU = 0);
-    ~CacheLine();
-    unsigned int getTag();
-    bool getValid();
-    bool getDirty();
-    unsigned int getLRU();
-    void setTag(unsigned int tag);
-    void setValid(bool valid);
-    void setDirty(bool dirty);
-    void setLRU(unsigned int LRU);
-    bool compareTag(unsigned int outsideTag);
+    PrefetchLineState prefetch;
 };
 
-class CacheSet {
+// A single cache level stored as a struct of arrays. Every per-line field lives in its own
+// flat array indexed by set * wayStride + way, so the tags of a set are contiguous and a
+// lookup is one vector compare per TAG_LANES ways. Valid and dirty bits are bitmasks with
+// maskWords 64-bit words per set. Replacement state belongs to ReplacementPolicy (see
+// replacement.hpp), which is only asked for a victim once every way of a set is valid.
+// Two more bitmasks keep the PrefetchLineState of every line.
+// The block functions place blocks with the SetIndex of the level, a skewed level looks at one
+// line in every way and replaces the oldest of them by ReplacementPolicy::age.
+template <class ReplacementPolicy>
+class CacheLevel {
 private:
+    SetIndex index;
+    unsigned int numSets;
     unsigned int numWays;
-    unsigned int lineCount;
-    CacheLine* lines;
+    unsigned int wayStride; // numWays rounded up to TAG_LANES, padding ways are never valid
+    unsigned int maskWords; // 64-bit words per set in validMask and dirtyMask
+    CacheTag* tags;
+    uint64_t* validMask;
+    uint64_t* dirtyMask;
+    uint64_t* prefetchMask; // LINE_PREFETCHED lines
+    uint64_t* usedMask; // LINE_PREFETCH_USED lines
+    unsigned int* lineCount; // number of valid lines per set
+    ReplacementPolicy policy;
+    void placeLine(unsigned int set, unsigned int way, CacheTag tag);
+    // the block functions off INDEX_MODULO
+    unsigned int findHashedBlock(CacheTag block, unsigned int& set);
+    unsigned int insertHashedBlock(CacheTag block, unsigned int& set);
+    unsigned int selectSkewedVictim(CacheTag block, unsigned int& set);
 public:
-    CacheSet();
-    CacheSet(unsigned int numWays);
-    ~CacheSet();
-    void initSet(unsigned int numWays);
-    unsigned int getWay(unsigned int tag);
-    void updateLRU(unsigned int way);
-    bool insertLine(unsigned int tag);
-    bool isLineInSet(unsigned int tag);
-    CacheLine* findLine(unsigned int tag);
-    CacheLine* removeLine();
-    CacheLine* removeLine(unsigned int way);
-    bool writeToLine(unsigned int tag);
-    bool readFromLine(unsigned int tag);
-    void updateDirty(unsigned int way, bool dirty);
+    CacheLevel();
+    ~CacheLevel();
+    void initLevel(unsigned int numSets, unsigned int numWays, IndexKind indexing = INDEX_MODULO);
+    // the way holding block, or NO_WAY, with set where it is (or the set of way 0 on a miss)
+    unsigned int findBlock(CacheTag block, unsigned int& set);
+    // insertLine and selectVictim for block, set is the set of the returned way
+    unsigned int insertBlock(CacheTag block, unsigned int& set);
+    unsigned int selectBlockVictim(CacheTag block, unsigned int& set);
+    // the block of a line with the given tag in set
+    CacheTag getBlock(CacheTag tag, unsigned int set);
+    // the set block is looked up in first
+    unsigned int homeSet(CacheTag block);
+    unsigned int findWay(unsigned int set, CacheTag tag);
+    // start loading the tags and valid bits of set into the data cache
+    void prefetchSet(unsigned int set);
+    void touchLine(unsigned int set, unsigned int way);
+    // the first free way of set, for a level indexed by INDEX_MODULO
+    unsigned int insertLine(unsigned int set, CacheTag tag);
+    unsigned int selectVictim(unsigned int set);
+    void removeLine(unsigned int set, unsigned int way);
+    EvictedLine evictLine(unsigned int set, unsigned int way); // removeLine, returning what was there
+    CacheTag getTag(unsigned int set, unsigned int way);
+    bool getDirty(unsigned int set, unsigned int way);
+    void setDirty(unsigned int set, unsigned int way, bool dirty);
+    PrefetchLineState getPrefetchState(unsigned int set, unsigned int way);
+    void setPrefetchState(unsigned int set, unsigned int way, PrefetchLineState state);
+    // tags are written numWays per set, so checkpoints do not depend on TAG_LANES
+    void saveState(CheckpointWriter& checkpoint);
+    bool restoreState(CheckpointReader& checkpoint);
 };
 
-class Cache {
+// The two level inclusive cache. Instantiated for every policy in replacement.hpp, Cache is
+// the LRU one and dispatchReplacementPolicy picks the others at run time.
+template <class ReplacementPolicy>
+class BasicCache {
 private:
     unsigned int MemCyc; // Memory cycles
     unsigned int BSize; // Block size in bytes (given in log2)
@@ -69,41 +215,331 @@ private:
     unsigned int L1Cyc, L2Cyc; // L1 and L2 access time in cycles
     unsigned int WrAlloc; // Write allocate policy (0 = no write allocate, 1 = write allocate)
 
-    unsigned int L1Reads, L1ReadMisses, L1Writes, L1WriteMisses; // L1 cache stats
-    unsigned int L2Reads, L2ReadMisses, L2Writes, L2WriteMisses; // L2 cache stats
-    unsigned int totalL1Cycles, totalL2Cycles, totalMemCycles; // total cycles for each cache and memory
+    uint64_t L1Reads, L1ReadMisses, L1Writes, L1WriteMisses; // L1 cache stats
+    uint64_t L2Reads, L2ReadMisses, L2Writes, L2WriteMisses; // L2 cache stats
+    uint64_t L1Fetches, L1FetchMisses, L2Fetches, L2FetchMisses; // see CacheStats
+    uint64_t totalL1Cycles, totalL2Cycles, totalMemCycles; // total cycles for each cache and memory
+    uint64_t L1WriteBacks, L2WriteBacks; // traffic stats, see CacheStats
+    uint64_t L2ReadBytes, L2WriteBytes;
+    uint64_t memReadBytes, memWriteBytes;
+    uint64_t writeBufferStallCycles;
+
+    int writeBufferDepth; // see CacheConfig
+    uint64_t* writeBuffer; // ring of the cycles the buffered write-backs are done
+    unsigned int writeBufferHead, writeBufferCount;
+    uint64_t lastDrain; // cycle the newest buffered write-back is done
+    bool counting; // false while warmAccess runs
+    bool translating; // false while a fetch reads the unified L1, fetches skip the DTLB
+
+    Prefetcher L1Prefetcher, L2Prefetcher;
+    PrefetchStats L1PrefetchStats, L2PrefetchStats;
+    uint64_t* L1Ready; // per line, the cycle a prefetched line arrives (next line and stride)
+    uint64_t* L2Ready;
+
+    unsigned int victimEntries, VictimCyc; // see CacheConfig
+    uint64_t victimHits, victimMisses, victimCycles;
+    CacheTag* victimBlocks; // block address of every entry
+    uint64_t* victimStamps; // last use of every entry, the smallest is the LRU one
+    uint64_t victimClock;
+    uint64_t victimValid, victimDirty; // bit per entry
+
+    DramModel dram;
+    DramStats dramStats;
+
+    TlbModel tlb;
+    TlbStats tlbStats;
+
+    unsigned int L1ISize, L1ICyc; // see CacheConfig
+
+    bool replayPending; // the next L1 (or L1I) fill evicts replayVictim, see replayEviction
+    CacheTag replayVictim;
 
     unsigned int BlockSize; // 2^BSize in bytes
     unsigned int L1OffsetBits, L2OffsetBits; // number of bits for offset (Bsize)
     unsigned int L1IndexBits, L2IndexBits; // number of bits for index (Lsize - Bsize - Associativity)
-    unsigned int L1TagBits, L2TagBits; // number of bits for tag (32 - IndexBits - OffsetBits)
+    unsigned int L1TagBits, L2TagBits; // number of bits for tag (FULL_TAG_SIZE - IndexBits - OffsetBits)
+    unsigned int L1IndexMask, L2IndexMask; // (2^IndexBits) - 1
 
     unsigned int L1NumBlocks, L2NumBlocks; // number of blocks in L1 and L2 (2^LSize/2^BSize)
     unsigned int L1NumSets, L2NumSets; // number of sets in L1 and L2 (2^IndexBits)
     unsigned int L1NumWays, L2NumWays; // number of ways in L1 and L2 (2^L1Assoc, 2^L2Assoc)
 
-    CacheSet *L1Sets, *L2Sets;
+    CacheLevel<ReplacementPolicy> L1, L2;
+    CacheLevel<ReplacementPolicy> L1I; // with L1ISize set
 public:
-    Cache(unsigned int MemCyc, unsigned int BSize, unsigned int L1Size, unsigned int L2Size,
+    BasicCache(unsigned int MemCyc, unsigned int BSize, unsigned int L1Size, unsigned int L2Size,
             unsigned int L1Assoc, unsigned int L2Assoc, unsigned int L1Cyc, unsigned int L2Cyc,
-            unsigned int WrAlloc);
-    ~Cache();
-    unsigned int getL1Reads();
-    unsigned int getL1ReadMisses();
-    unsigned int getL1Writes();
-    unsigned int getL1WriteMisses();
-    unsigned int getL2Reads();
-    unsigned int getL2ReadMisses();
-    unsigned int getL2Writes();
-    unsigned int getL2WriteMisses();
-    unsigned int getTotalL1Cycles();
-    unsigned int getTotalL2Cycles();
-    unsigned int getTotalMemCycles();
-    void readFromCache(unsigned int fullTag);
-    void writeToCache(unsigned int fullTag);
-    void L1MissHandler(unsigned int L1Tag, unsigned int L1index);
-    void L2MissHandler(unsigned int L1Tag, unsigned int L1Index, 
-                           unsigned int L2Tag, unsigned int L2index);
+            unsigned int WrAlloc, int writeBufferDepth = WRITE_BUFFER_OFF,
+            IndexKind L1Indexing = INDEX_MODULO, IndexKind L2Indexing = INDEX_MODULO);
+    explicit BasicCache(const CacheConfig& config);
+    ~BasicCache();
+    uint64_t getL1Reads();
+    uint64_t getL1ReadMisses();
+    uint64_t getL1Writes();
+    uint64_t getL1WriteMisses();
+    uint64_t getL2Reads();
+    uint64_t getL2ReadMisses();
+    uint64_t getL2Writes();
+    uint64_t getL2WriteMisses();
+    uint64_t getTotalL1Cycles();
+    uint64_t getTotalL2Cycles();
+    uint64_t getTotalMemCycles();
+    CacheStats getStats();
+    void readFromCache(uint64_t address);
+    void writeToCache(uint64_t address);
+    // an instruction fetch, see L1I_OFF
+    void fetchFromCache(uint64_t address);
+    // count accesses, operations[i] is ACCESS_READ, ACCESS_WRITE or ACCESS_FETCH. The sets
+    // of later accesses are prefetched while earlier ones are simulated. Returns false at the
+    // first other operation, after simulating the accesses before it.
+    bool accessBatch(const uint64_t* addresses, const uint8_t* operations, size_t count);
+    // the state changes of a read or write without touching any counter, for warming
+    // the cache while a sampled run fast-forwards (see sampling.hpp)
+    void warmAccess(uint64_t address, bool write);
+    void warmFetch(uint64_t address);
+    // replay of an L1-filtered trace (see filter.hpp): the counters and L1 cycles of the hits
+    // it left out, and the line the recorded L1 evicted for the miss replayed next, which the
+    // fill removes (with its write-back) in place of a victim of the replacement policy
+    void replayHits(uint64_t reads, uint64_t writes, uint64_t fetches);
+    void replayEviction(CacheTag block);
+    // the counters and both levels, restored into a cache of the same configuration (see
+    // checkpoint.hpp)
+    void saveState(CheckpointWriter& checkpoint);
+    bool restoreState(CheckpointReader& checkpoint);
+    void warmLine(uint64_t address, bool write);
+    // the cycles an access to block in memory takes, MemCyc without a DRAM model
+    uint64_t memoryAccess(uint64_t block, bool write);
+    void writeBackToMemory(CacheTag block);
+    // prefetching, level is 1 or 2
+    uint64_t getNow();
+    void usePrefetchedLine(unsigned int level, unsigned int set, unsigned int way, uint64_t ready);
+    void countEviction(unsigned int level, const EvictedLine& victim);
+    unsigned int streamFill(unsigned int level, uint64_t block, unsigned int& set);
+    void refillStream(unsigned int level, int buffer);
+    void prefetchBlock(unsigned int level, uint64_t block);
+    void prefetchAccess(unsigned int level, uint64_t block, bool miss, bool prefetchHit);
+    // victim cache, blocks are addresses without the offset bits
+    unsigned int findVictim(CacheTag block);
+    unsigned int probeVictim(CacheTag block);
+    bool removeVictim(unsigned int entry);
+    void insertVictim(CacheTag block, bool dirty);
+    void writeBackToL2(CacheTag block);
+    // the miss handlers take a block and return the way and set it was put in
+    unsigned int L2Fill(CacheTag block, unsigned int& L2Index);
+    unsigned int L1MissHandler(CacheTag block, unsigned int& L1Index);
+    unsigned int L2MissHandler(CacheTag block, unsigned int& L1Index);
+    void L1IFill(CacheTag block);
+};
+
+typedef BasicCache<LRUPolicy> Cache;
+
+// Simulate an open trace reader with a cache built from config, using the replacement policy
+// config names. Fills stats and returns false on a trace error. simulator.hpp has the same
+// for a file path.
+template <class TraceReader>
+bool simulateConfig(TraceReader& reader, const CacheConfig& config, CacheStats& stats);
+
+/**********************************************************************************************/
+// CacheLevel hot path, kept inline so the access loop does not pay for a call per lookup
+
+#if TAG_LANES > 1
+#if defined(__AVX2__)
+typedef __m256i TagVector;
+
+inline TagVector broadcastTag(CacheTag tag) {
+#ifdef CACHESIM_TAG64
+	return _mm256_set1_epi64x((long long)tag);
+#else
+	return _mm256_set1_epi32((int)tag);
+#endif
+}
+
+// bit i is set if tags[i] == key, for TAG_LANES tags
+inline unsigned int matchTags(const CacheTag* tags, TagVector key) {
+	__m256i chunk = _mm256_loadu_si256((const __m256i*)tags);
+#ifdef CACHESIM_TAG64
+	return (unsigned int)_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(chunk, key)));
+#else
+	return (unsigned int)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(chunk, key)));
+#endif
+}
+#else
+typedef __m128i TagVector;
+
+inline TagVector broadcastTag(CacheTag tag) {
+#ifdef CACHESIM_TAG64
+	return _mm_set1_epi64x((long long)tag);
+#else
+	return _mm_set1_epi32((int)tag);
+#endif
+}
+
+inline unsigned int matchTags(const CacheTag* tags, TagVector key) {
+	__m128i equal = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)tags), key);
+#ifdef CACHESIM_TAG64
+	// SSE2 has no 64-bit compare, a tag matches when both of its halves do
+	equal = _mm_and_si128(equal, _mm_shuffle_epi32(equal, _MM_SHUFFLE(2, 3, 0, 1)));
+	return (unsigned int)_mm_movemask_pd(_mm_castsi128_pd(equal));
+#else
+	return (unsigned int)_mm_movemask_ps(_mm_castsi128_ps(equal));
+#endif
+}
+#endif
+#endif // TAG_LANES > 1
+
+// returns the way holding tag in set, or NO_WAY on a miss
+template <class ReplacementPolicy>
+inline unsigned int CacheLevel<ReplacementPolicy>::findWay(unsigned int set, CacheTag tag) {
+	const CacheTag* setTags = this->tags + (size_t)set * this->wayStride;
+	const uint64_t* valid = this->validMask + (size_t)set * this->maskWords;
+	if (TAG_LANES == 1 || this->numWays == 1) {
+		for (unsigned int way = 0; way < this->numWays; way++) {
+			if (setTags[way] == tag && ((valid[way >> 6] >> (way & 63)) & 1)) {
+				return way;
+			}
+		}
+		return NO_WAY;
+	}
+#if TAG_LANES > 1
+	const TagVector key = broadcastTag(tag);
+	for (unsigned int way = 0; way < this->numWays; way += TAG_LANES) {
+		unsigned int hits = matchTags(setTags + way, key);
+		// TAG_LANES divides 64, so a chunk never straddles two mask words
+		hits &= (unsigned int)(valid[way >> 6] >> (way & 63)) & ((1u << TAG_LANES) - 1);
+		if (hits != 0) {
+			return way + __builtin_ctz(hits);
+		}
+	}
+#endif
+	return NO_WAY;
+}
+
+template <class ReplacementPolicy>
+HOT_INLINE unsigned int CacheLevel<ReplacementPolicy>::findBlock(CacheTag block, unsigned int& set) {
+	if (this->index.kind == INDEX_MODULO) {
+		// the original model, kept to a mask and a shift
+		set = (unsigned int)(block & this->index.mask);
+		return this->findWay(set, block >> this->index.indexBits);
+	}
+	return this->findHashedBlock(block, set);
+}
+
+template <class ReplacementPolicy>
+HOT_INLINE unsigned int CacheLevel<ReplacementPolicy>::insertBlock(CacheTag block, unsigned int& set) {
+	if (this->index.kind == INDEX_MODULO) {
+		set = (unsigned int)(block & this->index.mask);
+		return this->insertLine(set, block >> this->index.indexBits);
+	}
+	return this->insertHashedBlock(block, set);
+}
+
+template <class ReplacementPolicy>
+HOT_INLINE unsigned int CacheLevel<ReplacementPolicy>::selectBlockVictim(CacheTag block, unsigned int& set) {
+	if (this->index.kind == INDEX_SKEW) {
+		return this->selectSkewedVictim(block, set);
+	}
+	set = this->index.kind == INDEX_MODULO ? (unsigned int)(block & this->index.mask) : this->index.set(block, 0);
+	return this->selectVictim(set);
+}
+
+template <class ReplacementPolicy>
+inline CacheTag CacheLevel<ReplacementPolicy>::getBlock(CacheTag tag, unsigned int set) {
+	return (CacheTag)this->index.block(tag, set);
+}
+
+template <class ReplacementPolicy>
+inline unsigned int CacheLevel<ReplacementPolicy>::homeSet(CacheTag block) {
+	return this->index.set(block, 0);
+}
+
+template <class ReplacementPolicy>
+inline void CacheLevel<ReplacementPolicy>::prefetchSet(unsigned int set) {
+#if defined(__GNUC__)
+	__builtin_prefetch(this->tags + (size_t)set * this->wayStride);
+	__builtin_prefetch(this->validMask + (size_t)set * this->maskWords);
+#else
+	(void)set;
+#endif
+}
+
+template <class ReplacementPolicy>
+inline void CacheLevel<ReplacementPolicy>::touchLine(unsigned int set, unsigned int way) {
+	this->policy.touch(set, way);
+}
+
+template <class ReplacementPolicy>
+inline unsigned int CacheLevel<ReplacementPolicy>::selectVictim(unsigned int set) {
+	return this->policy.victim(set);
+}
+
+template <class ReplacementPolicy>
+inline EvictedLine CacheLevel<ReplacementPolicy>::evictLine(unsigned int set, unsigned int way) {
+	EvictedLine line = {this->getTag(set, way), this->getDirty(set, way),
+						this->getPrefetchState(set, way)};
+	this->removeLine(set, way);
+	return line;
+}
+
+template <class ReplacementPolicy>
+inline CacheTag CacheLevel<ReplacementPolicy>::getTag(unsigned int set, unsigned int way) {
+	return this->tags[(size_t)set * this->wayStride + way];
+}
+
+template <class ReplacementPolicy>
+inline bool CacheLevel<ReplacementPolicy>::getDirty(unsigned int set, unsigned int way) {
+	return (this->dirtyMask[(size_t)set * this->maskWords + (way >> 6)] >> (way & 63)) & 1;
+}
+
+template <class ReplacementPolicy>
+inline void CacheLevel<ReplacementPolicy>::setDirty(unsigned int set, unsigned int way, bool dirty) {
+	uint64_t* word = &this->dirtyMask[(size_t)set * this->maskWords + (way >> 6)];
+	if (dirty) {
+		*word |= (uint64_t)1 << (way & 63);
+	} else {
+		*word &= ~((uint64_t)1 << (way & 63));
+	}
+}
+
+template <class ReplacementPolicy>
+inline PrefetchLineState CacheLevel<ReplacementPolicy>::getPrefetchState(unsigned int set, unsigned int way) {
+	size_t word = (size_t)set * this->maskWords + (way >> 6);
+	if ((this->prefetchMask[word] >> (way & 63)) & 1) {
+		return LINE_PREFETCHED;
+	}
+	return ((this->usedMask[word] >> (way & 63)) & 1) ? LINE_PREFETCH_USED : LINE_DEMAND;
+}
+
+template <class ReplacementPolicy>
+inline void CacheLevel<ReplacementPolicy>::setPrefetchState(unsigned int set, unsigned int way,
+															 PrefetchLineState state) {
+	size_t word = (size_t)set * this->maskWords + (way >> 6);
+	uint64_t bit = (uint64_t)1 << (way & 63);
+	this->prefetchMask[word] = (this->prefetchMask[word] & ~bit) | (state == LINE_PREFETCHED ? bit : 0);
+	this->usedMask[word] = (this->usedMask[word] & ~bit) | (state == LINE_PREFETCH_USED ? bit : 0);
+}
+
+/**********************************************************************************************/
+// Run time policy selection
+
+template <class TraceReader>
+struct ReaderRunner {
+    typedef bool Result;
+    TraceReader& reader;
+    const CacheConfig& config;
+    CacheStats& stats;
+    template <class ReplacementPolicy>
+    bool run() {
+        BasicCache<ReplacementPolicy> cache(this->config);
+        bool ok = simulateTrace(this->reader, cache);
+        this->stats = cache.getStats();
+        return ok;
+    }
 };
 
-#endif // CACHE_SIM_HPP
\ No newline at end of file
+template <class TraceReader>
+bool simulateConfig(TraceReader& reader, const CacheConfig& config, CacheStats& stats) {
+	ReaderRunner<TraceReader> runner = {reader, config, stats};
+	return dispatchReplacementPolicy(config.replacement, runner);
+}
+
+#endif // CACHE_SIM_HPP
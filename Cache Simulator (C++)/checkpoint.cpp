@@ -0,0 +1,103 @@
+#include "checkpoint.hpp"
+#include "cacheSim.hpp"
+
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**********************************************************************************************/
+
+// every field of CacheConfig, its nested configs included, is one 32-bit word, so a field
+// added to it changes the size and stops the build here until it is added below
+static_assert(sizeof(CacheConfig) == CHECKPOINT_CONFIG_FIELDS * sizeof(uint32_t),
+			  "CacheConfig and the checkpoint config words differ");
+
+CheckpointHeader makeCheckpointHeader(const CacheConfig& c) {
+	CheckpointHeader header = CheckpointHeader();
+	header.magic = CHECKPOINT_MAGIC;
+	header.version = CHECKPOINT_VERSION;
+	header.tagBits = FULL_TAG_SIZE;
+	const uint32_t config[] = {c.MemCyc, c.BSize, c.L1Size, c.L2Size, c.L1Assoc, c.L2Assoc, c.L1Cyc,
+							   c.L2Cyc, c.WrAlloc, (uint32_t)c.replacement, (uint32_t)c.writeBufferDepth,
+							   (uint32_t)c.L1Prefetch.kind, c.L1Prefetch.degree,
+							   (uint32_t)c.L2Prefetch.kind, c.L2Prefetch.degree, c.victimEntries,
+							   c.VictimCyc, (uint32_t)c.L1Indexing, (uint32_t)c.L2Indexing,
+							   c.dram.channels, c.dram.ranks, c.dram.banks, c.dram.rowSize, c.dram.tRCD,
+							   c.dram.tCAS, c.dram.tRP, (uint32_t)c.dram.page, (uint32_t)c.dram.mapping,
+							   c.tlb.L1Entries, c.tlb.L1Ways, c.tlb.L2Entries, c.tlb.L2Ways, c.tlb.L2TlbCyc,
+							   c.tlb.walkCyc, c.tlb.pwcEntries, (uint32_t)c.tlb.pageSize, c.L1ISize,
+							   c.L1IAssoc, c.L1ICyc};
+	static_assert(sizeof(config) == sizeof(header.config), "a CacheConfig field is missing above");
+	memcpy(header.config, config, sizeof(config));
+	return header;
+}
+
+bool isCheckpointOf(const CheckpointHeader& header, const CacheConfig& config) {
+	CheckpointHeader expected = makeCheckpointHeader(config);
+	return header.tagBits == expected.tagBits &&
+		   memcmp(header.config, expected.config, sizeof(header.config)) == 0;
+}
+
+/**********************************************************************************************/
+// CheckpointWriter definitions
+CheckpointWriter::CheckpointWriter(const char* path) : file(path, ios::binary | ios::trunc) {
+}
+
+bool CheckpointWriter::isOpen() {
+	return this->file.is_open() && this->file.good();
+}
+
+void CheckpointWriter::write(const void* data, size_t size) {
+	this->file.write((const char*)data, size);
+}
+
+bool CheckpointWriter::close() {
+	bool ok = this->file.good();
+	this->file.close();
+	return ok && !this->file.fail();
+}
+
+/**********************************************************************************************/
+// CheckpointReader definitions
+CheckpointReader::CheckpointReader(const char* path) : data(nullptr), size(0), cursor(nullptr) {
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		return;
+	}
+	struct stat st;
+	if (fstat(fd, &st) == 0 && st.st_size > 0) {
+		void* mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (mapped != MAP_FAILED) {
+			madvise(mapped, st.st_size, MADV_SEQUENTIAL);
+			this->data = (const uint8_t*)mapped;
+			this->size = st.st_size;
+			this->cursor = this->data;
+		}
+	}
+	close(fd);
+}
+
+CheckpointReader::~CheckpointReader() {
+	if (this->data != nullptr) {
+		munmap((void*)this->data, this->size);
+	}
+}
+
+bool CheckpointReader::isOpen() {
+	return this->data != nullptr;
+}
+
+bool CheckpointReader::read(void* data, size_t size) {
+	if ((size_t)(this->data + this->size - this->cursor) < size) {
+		return false;
+	}
+	memcpy(data, this->cursor, size);
+	this->cursor += size;
+	return true;
+}
+
+bool CheckpointReader::atEnd() {
+	return this->cursor == this->data + this->size;
+}
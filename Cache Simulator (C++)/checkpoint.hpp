@@ -0,0 +1,78 @@
+#ifndef CHECKPOINT_HPP
+#define CHECKPOINT_HPP
+
+#include <fstream>
+#include <stdint.h>
+
+using  namespace std;
+
+// Checkpoint layout:
+//   header - CheckpointHeader below (little endian). The configuration has to match the one
+//            restoring it, the trace position says where the checkpointed run stopped.
+//   state  - the Cache counters, the write buffer, prefetchers, victim cache, DRAM banks and
+//            TLBs that are in use, then L1, L2 and an L1I (see CacheLevel::saveState): tags, valid and
+//            dirty masks, line counts and the replacement policy arrays, each as raw arrays.
+// A restore maps the file and copies the arrays out of the mapping, and continues the trace
+// at the saved position, so a restored run counts exactly what an uninterrupted one does.
+#define CHECKPOINT_MAGIC 0x4B435343 // "CSCK"
+#define CHECKPOINT_VERSION 8
+// One word per CacheConfig field, checked against the struct when checkpoint.cpp compiles
+#define CHECKPOINT_CONFIG_FIELDS 39
+
+struct CacheConfig;
+
+struct CheckpointHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t tagBits; // FULL_TAG_SIZE of the build that wrote it
+    uint32_t config[CHECKPOINT_CONFIG_FIELDS]; // CacheConfig fields in declaration order
+    uint32_t traceKind;
+    uint64_t accesses;
+    uint64_t offset;
+    uint64_t lastAddress;
+};
+
+// a header for config at the start of a trace, the caller fills in the trace position
+CheckpointHeader makeCheckpointHeader(const CacheConfig& config);
+
+// true if header was written by this build for config
+bool isCheckpointOf(const CheckpointHeader& header, const CacheConfig& config);
+
+// Buffered writer of the state arrays
+class CheckpointWriter {
+private:
+    ofstream file;
+public:
+    CheckpointWriter(const char* path);
+    bool isOpen();
+    void write(const void* data, size_t size);
+    template <class T>
+    void writeArray(const T* values, size_t count) {
+        this->write(values, count * sizeof(T));
+    }
+    // returns false if anything failed to write
+    bool close();
+};
+
+// Reads the state arrays back out of a mapped checkpoint
+class CheckpointReader {
+private:
+    const uint8_t* data;
+    size_t size;
+    const uint8_t* cursor;
+    CheckpointReader(const CheckpointReader&) = delete;
+    CheckpointReader& operator=(const CheckpointReader&) = delete;
+public:
+    CheckpointReader(const char* path);
+    ~CheckpointReader();
+    bool isOpen();
+    // false if the checkpoint ends first
+    bool read(void* data, size_t size);
+    template <class T>
+    bool readArray(T* values, size_t count) {
+        return this->read(values, count * sizeof(T));
+    }
+    bool atEnd();
+};
+
+#endif // CHECKPOINT_HPP
@@ -0,0 +1,127 @@
+#include "classify.hpp"
+
+#define NO_NODE ((uint32_t)-1)
+#define NO_SLOT ((uint32_t)-1)
+#define SHADOW_MIN_SLOTS 1024
+
+static inline uint64_t hashBlock(uint64_t block) {
+	// Fibonacci hashing, the high bits are the well mixed ones
+	return block * 0x9E3779B97F4A7C15ull;
+}
+
+/**********************************************************************************************/
+// ShadowCache definitions
+ShadowCache::ShadowCache() : capacity(0), size(0), head(NO_NODE), tail(NO_NODE), numKeys(0),
+		hashShift(64) {
+}
+
+void ShadowCache::initShadow(uint32_t numLines) {
+	this->capacity = numLines;
+	this->size = 0;
+	this->head = this->tail = NO_NODE;
+	this->nodes.assign(numLines, Node());
+	// room for twice the lines at half load before the first resize
+	size_t slots = SHADOW_MIN_SLOTS;
+	while (slots < (size_t)numLines * 4) {
+		slots *= 2;
+	}
+	this->slots.clear();
+	this->resize(slots);
+}
+
+void ShadowCache::resize(size_t slots) {
+	Slot empty = {0, NO_NODE};
+	vector<Slot> old(slots, empty);
+	old.swap(this->slots);
+	this->numKeys = 0;
+	this->hashShift = 64;
+	for (size_t rest = slots; rest > 1; rest >>= 1) {
+		this->hashShift--;
+	}
+	for (size_t slot = 0; slot < old.size(); slot++) {
+		if (old[slot].key != 0) {
+			uint32_t moved = this->find(old[slot].key - 1, true);
+			this->slots[moved].value = old[slot].value;
+			if (old[slot].value != NO_NODE) {
+				this->nodes[old[slot].value].slot = moved;
+			}
+		}
+	}
+}
+
+uint32_t ShadowCache::find(uint64_t block, bool insert) {
+	uint32_t mask = (uint32_t)this->slots.size() - 1;
+	uint32_t slot = (uint32_t)(hashBlock(block) >> this->hashShift) & mask;
+	while (this->slots[slot].key != 0) {
+		if (this->slots[slot].key == block + 1) {
+			return slot;
+		}
+		slot = (slot + 1) & mask;
+	}
+	if (!insert) {
+		return NO_SLOT;
+	}
+	if (2 * (this->numKeys + 1) > this->slots.size()) {
+		this->resize(this->slots.size() * 2);
+		return this->find(block, true);
+	}
+	this->slots[slot].key = block + 1;
+	this->numKeys++;
+	return slot;
+}
+
+void ShadowCache::unlink(uint32_t node) {
+	Node& n = this->nodes[node];
+	if (n.prev != NO_NODE) {
+		this->nodes[n.prev].next = n.next;
+	} else {
+		this->head = n.next;
+	}
+	if (n.next != NO_NODE) {
+		this->nodes[n.next].prev = n.prev;
+	} else {
+		this->tail = n.prev;
+	}
+}
+
+void ShadowCache::pushFront(uint32_t node) {
+	Node& n = this->nodes[node];
+	n.prev = NO_NODE;
+	n.next = this->head;
+	if (this->head != NO_NODE) {
+		this->nodes[this->head].prev = node;
+	} else {
+		this->tail = node;
+	}
+	this->head = node;
+}
+
+ShadowResult ShadowCache::access(uint64_t block, bool allocate) {
+	// a block that is not allocated is not seen either
+	uint64_t numKeys = this->numKeys;
+	uint32_t slot = this->find(block, allocate);
+	if (slot == NO_SLOT) {
+		return SHADOW_COLD;
+	}
+	uint32_t node = this->slots[slot].value;
+	if (node != NO_NODE) {
+		if (node != this->head) {
+			this->unlink(node);
+			this->pushFront(node);
+		}
+		return SHADOW_HIT;
+	}
+	ShadowResult result = this->numKeys != numKeys ? SHADOW_COLD : SHADOW_MISS;
+	if (this->size < this->capacity) {
+		node = this->size++;
+	} else {
+		// reuse the least recently used node
+		node = this->tail;
+		this->unlink(node);
+		this->slots[this->nodes[node].slot].value = NO_NODE;
+	}
+	this->nodes[node].slot = slot;
+	this->pushFront(node);
+	this->slots[slot].value = node;
+	return result;
+}
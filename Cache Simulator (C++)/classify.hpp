@@ -0,0 +1,201 @@
+#ifndef CLASSIFY_HPP
+#define CLASSIFY_HPP
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+#include <stdint.h>
+
+#include "cacheSim.hpp"
+
+using  namespace std;
+
+// 3C miss classification (Hill and Smith, 1989). Every level gets a shadow that sees the same
+// demand accesses it does: an infinite set of the blocks it ever allocated, and a fully
+// associative LRU cache of the same number of lines. A miss of the real level is
+//   compulsory - its block was never allocated in the level before
+//   capacity   - otherwise, if the fully associative shadow misses too
+//   conflict   - otherwise, the only misses more ways would remove
+// Conflict misses are also counted per set of the level's index function (the set of way 0 in
+// a skewed level), to find the sets that take them. The shadow keeps
+// one hash map entry per block ever seen, pointing at its node in an intrusive LRU list or at
+// none, so the infinite set and the shadow cost a single lookup per access. The map is open
+// addressed with linear probing and every node knows its slot, which keeps the mode around
+// twice the time of a plain run where std::unordered_map took closer to three times. Writes allocate
+// in the shadows only where they allocate in the real levels.
+#define CLASSIFY_TOP_SETS 8
+
+enum ShadowResult {
+    SHADOW_COLD = 0, // first allocation of the block
+    SHADOW_MISS = 1,
+    SHADOW_HIT = 2
+};
+
+// Fully associative LRU level over block addresses, remembering every block it ever held
+class ShadowCache {
+private:
+    struct Node {
+        uint32_t slot; // of its block in the map, so evictions need no second lookup
+        uint32_t prev, next; // towards the most and the least recently used line
+    };
+    uint32_t capacity;
+    uint32_t size;
+    uint32_t head, tail; // most and least recently used, NO_NODE when empty
+    // block -> node, NO_NODE once evicted. key holds block + 1, 0 marks a free slot
+    struct Slot {
+        uint64_t key;
+        uint32_t value;
+    };
+    vector<Node> nodes;
+    vector<Slot> slots;
+    uint64_t numKeys;
+    unsigned int hashShift; // 64 - log2 of the slots
+    // the slot of block, inserted with NO_NODE if missing and insert is set, NO_SLOT otherwise
+    uint32_t find(uint64_t block, bool insert);
+    void resize(size_t slots);
+    void unlink(uint32_t node);
+    void pushFront(uint32_t node);
+public:
+    ShadowCache();
+    void initShadow(uint32_t numLines);
+    // look up block, moving it to the front or inserting it if allocate is set
+    ShadowResult access(uint64_t block, bool allocate);
+};
+
+struct MissClasses {
+    uint64_t compulsory, capacity, conflict;
+    vector<pair<unsigned int, uint64_t> > topSets; // (set, conflict misses), most first
+};
+
+struct ClassifyStats {
+    MissClasses L1, L2;
+};
+
+// Drives a BasicCache and classifies the misses of both levels, telling from its counters
+// whether an access missed L1, reached L2 and missed there
+template <class Simulator>
+class MissClassifier {
+private:
+    struct Level {
+        ShadowCache shadow;
+        SetIndex index;
+        uint64_t compulsory, capacity, conflict;
+        vector<uint64_t> setConflicts;
+    };
+    Simulator& cache;
+    unsigned int BSize;
+    bool writeAllocate;
+    Level L1, L2;
+    void initLevel(Level& level, unsigned int size, unsigned int assoc, IndexKind indexing);
+    void classify(Level& level, uint64_t block, bool miss, bool allocate);
+    void finishLevel(Level& level, MissClasses& classes);
+    void access(uint64_t address, uint8_t operation); // ACCESS_READ, ACCESS_WRITE or ACCESS_FETCH
+public:
+    MissClassifier(Simulator& cache, const CacheConfig& config);
+    void readFromCache(uint64_t address);
+    void writeToCache(uint64_t address);
+    // into the one L1 with the data, an L1I (see L1I_OFF) is not classified
+    void fetchFromCache(uint64_t address);
+    void finish(ClassifyStats& stats);
+};
+
+/**********************************************************************************************/
+// MissClassifier definitions
+
+template <class Simulator>
+MissClassifier<Simulator>::MissClassifier(Simulator& cache, const CacheConfig& config) :
+		cache(cache), BSize(config.BSize), writeAllocate(config.WrAlloc == WRITE_ALLOCATE) {
+	this->initLevel(this->L1, config.L1Size, config.L1Assoc, config.L1Indexing);
+	this->initLevel(this->L2, config.L2Size, config.L2Assoc, config.L2Indexing);
+}
+
+template <class Simulator>
+void MissClassifier<Simulator>::initLevel(Level& level, unsigned int size, unsigned int assoc,
+										  IndexKind indexing) {
+	level.shadow.initShadow((uint32_t)1 << (size - this->BSize));
+	level.index.initIndex(indexing, size - this->BSize - assoc);
+	level.compulsory = level.capacity = level.conflict = 0;
+	level.setConflicts.assign((size_t)1 << level.index.indexBits, 0);
+}
+
+template <class Simulator>
+inline void MissClassifier<Simulator>::classify(Level& level, uint64_t block, bool miss, bool allocate) {
+	ShadowResult shadow = level.shadow.access(block, allocate);
+	if (!miss) {
+		return;
+	}
+	if (shadow == SHADOW_COLD) {
+		level.compulsory++;
+	} else if (shadow == SHADOW_MISS) {
+		level.capacity++;
+	} else {
+		level.conflict++;
+		level.setConflicts[level.index.set(block, 0)]++;
+	}
+}
+
+template <class Simulator>
+void MissClassifier<Simulator>::access(uint64_t address, uint8_t operation) {
+	uint64_t L1Misses = this->cache.getL1ReadMisses() + this->cache.getL1WriteMisses();
+	uint64_t L2Accesses = this->cache.getL2Reads() + this->cache.getL2Writes();
+	uint64_t L2Misses = this->cache.getL2ReadMisses() + this->cache.getL2WriteMisses();
+	if (operation == ACCESS_WRITE) {
+		this->cache.writeToCache(address);
+	} else if (operation == ACCESS_FETCH) {
+		this->cache.fetchFromCache(address);
+	} else {
+		this->cache.readFromCache(address);
+	}
+	// the block the levels see, with the address bits a tag keeps
+	uint64_t block = (uint64_t)(CacheTag)address >> this->BSize;
+	bool allocate = operation != ACCESS_WRITE || this->writeAllocate;
+	this->classify(this->L1, block,
+				   this->cache.getL1ReadMisses() + this->cache.getL1WriteMisses() != L1Misses, allocate);
+	if (this->cache.getL2Reads() + this->cache.getL2Writes() != L2Accesses) {
+		this->classify(this->L2, block,
+					   this->cache.getL2ReadMisses() + this->cache.getL2WriteMisses() != L2Misses, allocate);
+	}
+}
+
+template <class Simulator>
+void MissClassifier<Simulator>::readFromCache(uint64_t address) {
+	this->access(address, ACCESS_READ);
+}
+
+template <class Simulator>
+void MissClassifier<Simulator>::writeToCache(uint64_t address) {
+	this->access(address, ACCESS_WRITE);
+}
+
+template <class Simulator>
+void MissClassifier<Simulator>::fetchFromCache(uint64_t address) {
+	this->access(address, ACCESS_FETCH);
+}
+
+template <class Simulator>
+void MissClassifier<Simulator>::finishLevel(Level& level, MissClasses& classes) {
+	classes.compulsory = level.compulsory;
+	classes.capacity = level.capacity;
+	classes.conflict = level.conflict;
+	classes.topSets.clear();
+	for (size_t set = 0; set < level.setConflicts.size(); set++) {
+		if (level.setConflicts[set] != 0) {
+			classes.topSets.push_back(make_pair((unsigned int)set, level.setConflicts[set]));
+		}
+	}
+	// most conflicts first, lower sets first among equals
+	size_t top = min(classes.topSets.size(), (size_t)CLASSIFY_TOP_SETS);
+	partial_sort(classes.topSets.begin(), classes.topSets.begin() + top, classes.topSets.end(),
+				 [](const pair<unsigned int, uint64_t>& a, const pair<unsigned int, uint64_t>& b) {
+					 return a.second != b.second ? a.second > b.second : a.first < b.first;
+				 });
+	classes.topSets.resize(top);
+}
+
+template <class Simulator>
+void MissClassifier<Simulator>::finish(ClassifyStats& stats) {
+	this->finishLevel(this->L1, stats.L1);
+	this->finishLevel(this->L2, stats.L2);
+}
+
+#endif // CLASSIFY_HPP
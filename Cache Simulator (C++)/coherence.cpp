@@ -0,0 +1,310 @@
+#include "coherence.hpp"
+#include "stream.hpp"
+
+/**********************************************************************************************/
+// MultiCoreCache definitions
+template <class ReplacementPolicy>
+MultiCoreCache<ReplacementPolicy>::MultiCoreCache(const CacheConfig& config, unsigned int numCores) :
+		MemCyc(config.MemCyc), BSize(config.BSize), L1Cyc(config.L1Cyc), L2Cyc(config.L2Cyc),
+		WrAlloc(config.WrAlloc), numCores(numCores), invalidations(0), interventions(0),
+		backInvalidations(0) {
+	this->L1IndexBits = config.L1Size - config.BSize - config.L1Assoc;
+	this->L2IndexBits = config.L2Size - config.BSize - config.L2Assoc;
+	this->L1IndexMask = ((CacheTag)1 << this->L1IndexBits) - 1;
+	this->L2IndexMask = ((CacheTag)1 << this->L2IndexBits) - 1;
+	this->L1NumWays = 1 << config.L1Assoc;
+	this->L2NumWays = 1 << config.L2Assoc;
+	size_t L1Lines = (size_t)1 << (config.L1Size - config.BSize);
+	size_t L2Lines = (size_t)1 << (config.L2Size - config.BSize);
+
+	this->L1 = new CacheLevel<ReplacementPolicy>[numCores];
+	for (unsigned int core = 0; core < numCores; core++) {
+		this->L1[core].initLevel(1 << this->L1IndexBits, this->L1NumWays);
+	}
+	this->L2.initLevel(1 << this->L2IndexBits, this->L2NumWays);
+	this->L1State = new uint8_t[numCores * L1Lines]();
+	this->sharers = new uint64_t[L2Lines]();
+	this->lostTo = new uint64_t[L2Lines]();
+	this->stats = CacheStats();
+	this->cores.assign(numCores, CoreStats());
+}
+
+template <class ReplacementPolicy>
+MultiCoreCache<ReplacementPolicy>::~MultiCoreCache() {
+	delete[] this->L1;
+	delete[] this->L1State;
+	delete[] this->sharers;
+	delete[] this->lostTo;
+}
+
+template <class ReplacementPolicy>
+unsigned int MultiCoreCache<ReplacementPolicy>::getNumCores() {
+	return this->numCores;
+}
+
+template <class ReplacementPolicy>
+MultiCoreStats MultiCoreCache<ReplacementPolicy>::getStats() {
+	MultiCoreStats result;
+	result.total = this->stats;
+	result.cores = this->cores;
+	result.invalidations = this->invalidations;
+	result.interventions = this->interventions;
+	result.backInvalidations = this->backInvalidations;
+	return result;
+}
+
+template <class ReplacementPolicy>
+inline uint8_t& MultiCoreCache<ReplacementPolicy>::lineState(unsigned int core, unsigned int L1Index,
+															 unsigned int way) {
+	size_t lines = ((size_t)this->L1IndexMask + 1) * this->L1NumWays;
+	return this->L1State[core * lines + (size_t)L1Index * this->L1NumWays + way];
+}
+
+template <class ReplacementPolicy>
+inline void MultiCoreCache<ReplacementPolicy>::countCoherenceMiss(unsigned int core, size_t L2Line) {
+	uint64_t bit = (uint64_t)1 << core;
+	if (this->lostTo[L2Line] & bit) {
+		this->cores[core].coherenceMisses++;
+		this->lostTo[L2Line] &= ~bit;
+	}
+}
+
+// a read of core: every other Modified or Exclusive copy becomes Shared
+template <class ReplacementPolicy>
+void MultiCoreCache<ReplacementPolicy>::downgradeOthers(unsigned int core, unsigned int L1Index,
+														CacheTag L1Tag, size_t L2Line) {
+	uint64_t others = this->sharers[L2Line] & ~((uint64_t)1 << core);
+	while (others != 0) {
+		unsigned int other = __builtin_ctzll(others);
+		others &= others - 1;
+		unsigned int way = this->L1[other].findWay(L1Index, L1Tag);
+		uint8_t& state = this->lineState(other, L1Index, way);
+		if (state == MESI_MODIFIED) {
+			// the owner writes its data back to L2
+			this->L2.setDirty(L2Line / this->L2NumWays, L2Line % this->L2NumWays, true);
+		}
+		if (state != MESI_SHARED) {
+			state = MESI_SHARED;
+			this->interventions++;
+		}
+	}
+}
+
+// a write of core: every other copy is invalidated
+template <class ReplacementPolicy>
+void MultiCoreCache<ReplacementPolicy>::invalidateOthers(unsigned int core, unsigned int L1Index,
+														 CacheTag L1Tag, size_t L2Line) {
+	uint64_t others = this->sharers[L2Line] & ~((uint64_t)1 << core);
+	while (others != 0) {
+		unsigned int other = __builtin_ctzll(others);
+		others &= others - 1;
+		unsigned int way = this->L1[other].findWay(L1Index, L1Tag);
+		uint8_t& state = this->lineState(other, L1Index, way);
+		if (state == MESI_MODIFIED) {
+			this->L2.setDirty(L2Line / this->L2NumWays, L2Line % this->L2NumWays, true);
+		}
+		state = MESI_INVALID;
+		this->L1[other].removeLine(L1Index, way);
+		this->cores[other].invalidations++;
+		this->invalidations++;
+	}
+	this->lostTo[L2Line] |= this->sharers[L2Line] & ~((uint64_t)1 << core);
+	this->sharers[L2Line] &= (uint64_t)1 << core;
+}
+
+// insert a line into L2, back invalidating the victim in every L1 that holds it.
+// Returns the L2 line (set * ways + way) of the new line.
+template <class ReplacementPolicy>
+size_t MultiCoreCache<ReplacementPolicy>::fillL2(unsigned int L2Index, CacheTag L2Tag) {
+	unsigned int way = this->L2.insertLine(L2Index, L2Tag);
+	// L2 is full, need to evict
+	if (way == NO_WAY) {
+		unsigned int victimWay = this->L2.selectVictim(L2Index);
+		uint64_t victimSharers = this->sharers[(size_t)L2Index * this->L2NumWays + victimWay];
+		EvictedLine victim = this->L2.evictLine(L2Index, victimWay);
+		CacheTag victimBlock = (victim.tag << this->L2IndexBits) | L2Index;
+		unsigned int victimL1Index = (unsigned int)(victimBlock & this->L1IndexMask);
+		CacheTag victimL1Tag = victimBlock >> this->L1IndexBits;
+		while (victimSharers != 0) {
+			unsigned int core = __builtin_ctzll(victimSharers);
+			victimSharers &= victimSharers - 1;
+			unsigned int L1Way = this->L1[core].findWay(victimL1Index, victimL1Tag);
+			this->lineState(core, victimL1Index, L1Way) = MESI_INVALID;
+			this->L1[core].removeLine(victimL1Index, L1Way);
+			this->backInvalidations++;
+		}
+		// write to memeory the evicted line
+		way = this->L2.insertLine(L2Index, L2Tag);
+	}
+	size_t line = (size_t)L2Index * this->L2NumWays + way;
+	this->sharers[line] = 0;
+	this->lostTo[line] = 0;
+	return line;
+}
+
+// insert a line into the L1 of core in state, evicting a victim if the set is full
+template <class ReplacementPolicy>
+void MultiCoreCache<ReplacementPolicy>::fillL1(unsigned int core, unsigned int L1Index, CacheTag L1Tag,
+											   size_t L2Line, MESIState state) {
+	CacheLevel<ReplacementPolicy>& level = this->L1[core];
+	unsigned int way = level.insertLine(L1Index, L1Tag);
+	// L1 is full, need to evict
+	if (way == NO_WAY) {
+		unsigned int victimWay = level.selectVictim(L1Index);
+		uint8_t victimState = this->lineState(core, L1Index, victimWay);
+		EvictedLine victim = level.evictLine(L1Index, victimWay);
+		// the L2 copy exists by inclusion, drop core from its sharers
+		CacheTag victimBlock = (victim.tag << this->L1IndexBits) | L1Index;
+		unsigned int victimL2Index = (unsigned int)(victimBlock & this->L2IndexMask);
+		unsigned int victimL2Way = this->L2.findWay(victimL2Index, victimBlock >> this->L2IndexBits);
+		if (victimL2Way != NO_WAY) {
+			if (victimState == MESI_MODIFIED) {
+				// write back to L2
+				this->L2.touchLine(victimL2Index, victimL2Way);
+				this->L2.setDirty(victimL2Index, victimL2Way, true);
+			}
+			this->sharers[(size_t)victimL2Index * this->L2NumWays + victimL2Way] &= ~((uint64_t)1 << core);
+		}
+		way = level.insertLine(L1Index, L1Tag);
+	}
+	this->lineState(core, L1Index, way) = state;
+	this->sharers[L2Line] |= (uint64_t)1 << core;
+}
+
+template <class ReplacementPolicy>
+void MultiCoreCache<ReplacementPolicy>::readFromCache(unsigned int core, uint64_t address) {
+	ALLOCATION_FREE_SCOPE;
+	CoreStats& coreStats = this->cores[core];
+	CacheTag block = (CacheTag)address >> this->BSize;
+	unsigned int L1Index = (unsigned int)(block & this->L1IndexMask);
+	CacheTag L1Tag = block >> this->L1IndexBits;
+	// read from L1
+	coreStats.reads++;
+	coreStats.cycles += this->L1Cyc;
+	this->stats.L1Reads++;
+	this->stats.totalL1Cycles += this->L1Cyc;
+	unsigned int L1Way = this->L1[core].findWay(L1Index, L1Tag);
+	if (L1Way != NO_WAY) { // L1 hit, any valid state can be read
+		this->L1[core].touchLine(L1Index, L1Way);
+		return;
+	}
+	// L1 miss
+	coreStats.readMisses++;
+	this->stats.L1ReadMisses++;
+	unsigned int L2Index = (unsigned int)(block & this->L2IndexMask);
+	CacheTag L2Tag = block >> this->L2IndexBits;
+	// read from L2
+	coreStats.cycles += this->L2Cyc;
+	this->stats.L2Reads++;
+	this->stats.totalL2Cycles += this->L2Cyc;
+	unsigned int L2Way = this->L2.findWay(L2Index, L2Tag);
+	MESIState state = MESI_EXCLUSIVE;
+	size_t L2Line;
+	if (L2Way != NO_WAY) { // L2 hit
+		this->L2.touchLine(L2Index, L2Way);
+		L2Line = (size_t)L2Index * this->L2NumWays + L2Way;
+		this->countCoherenceMiss(core, L2Line);
+		if (this->sharers[L2Line] != 0) {
+			this->downgradeOthers(core, L1Index, L1Tag, L2Line);
+			state = MESI_SHARED;
+		}
+	} else { // L2 miss
+		coreStats.cycles += this->MemCyc;
+		this->stats.L2ReadMisses++;
+		this->stats.totalMemCycles += this->MemCyc;
+		L2Line = this->fillL2(L2Index, L2Tag);
+	}
+	this->fillL1(core, L1Index, L1Tag, L2Line, state);
+}
+
+template <class ReplacementPolicy>
+void MultiCoreCache<ReplacementPolicy>::writeToCache(unsigned int core, uint64_t address) {
+	ALLOCATION_FREE_SCOPE;
+	CoreStats& coreStats = this->cores[core];
+	CacheTag block = (CacheTag)address >> this->BSize;
+	unsigned int L1Index = (unsigned int)(block & this->L1IndexMask);
+	CacheTag L1Tag = block >> this->L1IndexBits;
+	unsigned int L2Index = (unsigned int)(block & this->L2IndexMask);
+	CacheTag L2Tag = block >> this->L2IndexBits;
+	// write to L1
+	coreStats.writes++;
+	coreStats.cycles += this->L1Cyc;
+	this->stats.L1Writes++;
+	this->stats.totalL1Cycles += this->L1Cyc;
+	unsigned int L1Way = this->L1[core].findWay(L1Index, L1Tag);
+	if (L1Way != NO_WAY) { // L1 hit
+		this->L1[core].touchLine(L1Index, L1Way);
+		uint8_t& state = this->lineState(core, L1Index, L1Way);
+		if (state == MESI_SHARED) {
+			// upgrade, the directory in L2 invalidates the other copies
+			coreStats.upgrades++;
+			coreStats.cycles += this->L2Cyc;
+			this->stats.totalL2Cycles += this->L2Cyc;
+			size_t L2Line = (size_t)L2Index * this->L2NumWays + this->L2.findWay(L2Index, L2Tag);
+			this->invalidateOthers(core, L1Index, L1Tag, L2Line);
+		}
+		state = MESI_MODIFIED;
+		return;
+	}
+	// L1 miss
+	coreStats.writeMisses++;
+	this->stats.L1WriteMisses++;
+	// write to L2
+	coreStats.cycles += this->L2Cyc;
+	this->stats.L2Writes++;
+	this->stats.totalL2Cycles += this->L2Cyc;
+	unsigned int L2Way = this->L2.findWay(L2Index, L2Tag);
+	size_t L2Line = (size_t)L2Index * this->L2NumWays + L2Way;
+	if (L2Way != NO_WAY) { // L2 hit, take the line away from the other cores
+		this->L2.touchLine(L2Index, L2Way);
+		this->countCoherenceMiss(core, L2Line);
+		this->invalidateOthers(core, L1Index, L1Tag, L2Line);
+	} else { // L2 miss
+		coreStats.cycles += this->MemCyc;
+		this->stats.L2WriteMisses++;
+		this->stats.totalMemCycles += this->MemCyc;
+	}
+	// if write allocate - bring the line into L1 (and L2) for ownership
+	if (this->WrAlloc == WRITE_ALLOCATE) {
+		if (L2Way == NO_WAY) {
+			L2Line = this->fillL2(L2Index, L2Tag);
+		}
+		this->fillL1(core, L1Index, L1Tag, L2Line, MESI_MODIFIED);
+	}
+	// no write allocate - the write stays in L2 if it has the line, or goes to memory
+	else if (L2Way != NO_WAY) {
+		this->L2.setDirty(L2Index, L2Way, true);
+	}
+}
+
+// every policy dispatchReplacementPolicy can pick
+template class MultiCoreCache<LRUPolicy>;
+template class MultiCoreCache<TreePLRUPolicy>;
+template class MultiCoreCache<SRRIPPolicy>;
+template class MultiCoreCache<BRRIPPolicy>;
+template class MultiCoreCache<FIFOPolicy>;
+template class MultiCoreCache<RandomPolicy>;
+
+/**********************************************************************************************/
+// Run time policy selection
+
+struct MultiCoreRunner {
+	typedef bool Result;
+	const char* path;
+	const CacheConfig& config;
+	unsigned int numCores;
+	MultiCoreStats& stats;
+	template <class ReplacementPolicy>
+	bool run() {
+		MultiCoreCache<ReplacementPolicy> cache(this->config, this->numCores);
+		bool ok = simulateTraceInput(this->path, cache);
+		this->stats = cache.getStats();
+		return ok;
+	}
+};
+
+bool simulateMultiCoreFile(const char* path, const CacheConfig& config, unsigned int numCores,
+						   MultiCoreStats& stats) {
+	MultiCoreRunner runner = {path, config, numCores, stats};
+	return dispatchReplacementPolicy(config.replacement, runner);
+}
@@ -0,0 +1,136 @@
+#ifndef COHERENCE_HPP
+#define COHERENCE_HPP
+
+#include <vector>
+#include <stdint.h>
+
+#include "cacheSim.hpp"
+#include "trace.hpp"
+
+using  namespace std;
+
+// Multi core mode, driven by traces with core ids (see trace.hpp). Every core has a private
+// L1 of the configured geometry and all of them share the inclusive L2. The L1s are kept
+// coherent with MESI through a directory in the L2: every L2 line has a sharer bit per core,
+// so coherence actions go only to the cores that hold the line.
+//   - A read miss takes the line from L2 or memory. A core holding it Modified or Exclusive is
+//     downgraded to Shared (an intervention, Modified data goes back to L2). The reader gets
+//     the line Exclusive if no other core has it and Shared otherwise.
+//   - A write to a Shared line is an upgrade. It costs an L2 access and invalidates the other
+//     copies. A write to an Exclusive line turns it Modified silently.
+//   - A write miss with write allocate fetches the line for ownership and invalidates every
+//     other copy. Without write allocate the write goes to L2 and still invalidates them.
+//   - An L2 eviction back invalidates the line in every sharer, like the single core model.
+// A miss is a coherence miss if the core lost its copy to another core's write and the L2
+// still has the line. Every L2 line remembers which cores lost it that way.
+// The L1s hold data and instructions alike (there is no L1I in this mode), so an instruction
+// fetch is a read of its core's L1 and counts as one.
+// With one core the model matches BasicCache counter for counter, except that fetches are not
+// counted apart from the reads.
+#define MAX_CORES 64 // sharer sets are 64-bit masks
+
+enum MESIState {
+    MESI_INVALID = 0,
+    MESI_SHARED = 1,
+    MESI_EXCLUSIVE = 2,
+    MESI_MODIFIED = 3
+};
+
+struct CoreStats {
+    uint64_t reads, readMisses, writes, writeMisses;
+    uint64_t coherenceMisses; // misses to lines a write of another core took away
+    uint64_t invalidations; // copies this core lost to writes of other cores
+    uint64_t upgrades; // writes to Shared lines
+    uint64_t cycles;
+};
+
+struct MultiCoreStats {
+    CacheStats total; // the L1 counters are summed over the cores
+    vector<CoreStats> cores;
+    uint64_t invalidations; // L1 copies invalidated by writes
+    uint64_t interventions; // Modified or Exclusive copies downgraded by reads
+    uint64_t backInvalidations; // L1 copies removed by L2 evictions
+};
+
+template <class ReplacementPolicy>
+class MultiCoreCache {
+private:
+    unsigned int MemCyc, BSize, L1Cyc, L2Cyc, WrAlloc;
+    unsigned int numCores;
+    unsigned int L1IndexBits, L2IndexBits;
+    CacheTag L1IndexMask, L2IndexMask;
+    unsigned int L1NumWays, L2NumWays;
+    CacheLevel<ReplacementPolicy>* L1; // one per core
+    CacheLevel<ReplacementPolicy> L2;
+    uint8_t* L1State; // MESIState of every line of every L1, core by core
+    uint64_t* sharers; // per L2 line, cores whose L1 holds it
+    uint64_t* lostTo; // per L2 line, cores whose copy a write of another core invalidated
+    CacheStats stats;
+    vector<CoreStats> cores;
+    uint64_t invalidations, interventions, backInvalidations;
+    MultiCoreCache(const MultiCoreCache&) = delete;
+    MultiCoreCache& operator=(const MultiCoreCache&) = delete;
+    uint8_t& lineState(unsigned int core, unsigned int L1Index, unsigned int way);
+    void countCoherenceMiss(unsigned int core, size_t L2Line);
+    void downgradeOthers(unsigned int core, unsigned int L1Index, CacheTag L1Tag, size_t L2Line);
+    void invalidateOthers(unsigned int core, unsigned int L1Index, CacheTag L1Tag, size_t L2Line);
+    size_t fillL2(unsigned int L2Index, CacheTag L2Tag);
+    void fillL1(unsigned int core, unsigned int L1Index, CacheTag L1Tag, size_t L2Line, MESIState state);
+public:
+    MultiCoreCache(const CacheConfig& config, unsigned int numCores);
+    ~MultiCoreCache();
+    unsigned int getNumCores();
+    MultiCoreStats getStats();
+    void readFromCache(unsigned int core, uint64_t address);
+    void writeToCache(unsigned int core, uint64_t address);
+};
+
+// Simulate a trace with core ids on numCores cores, using the replacement policy config
+// names. Fills stats and returns false on a trace error.
+bool simulateMultiCoreFile(const char* path, const CacheConfig& config, unsigned int numCores,
+                           MultiCoreStats& stats);
+
+/**********************************************************************************************/
+// Trace driver
+
+// simulateTrace for multi core caches, simulateTraceInput and simulateTraceFile pick this
+// overload for them and hand every access to the core it names
+template <class TraceReader, class ReplacementPolicy>
+bool simulateTrace(TraceReader& reader, MultiCoreCache<ReplacementPolicy>& sim) {
+	TraceAccess access;
+	TraceStatus status;
+#ifdef CACHESIM_ALLOC_CHECK
+	uint64_t allocationsBefore = getScopedAllocations();
+#endif
+	while ((status = reader.next(access)) == TRACE_OK) {
+		if (access.core >= sim.getNumCores()) {
+			cout << "Core id out of range" << endl;
+			return false;
+		}
+		if (access.operation == 'r' || access.operation == 'i') {
+			sim.readFromCache(access.core, access.address);
+		} else if (access.operation == 'w') {
+			sim.writeToCache(access.core, access.address);
+		} else {
+			// Operation appears in an Invalid format
+			cout << "Operation Format error" << endl;
+			return false;
+		}
+	}
+	if (status == TRACE_FORMAT_ERROR) {
+		// Operation appears in an Invalid format
+		cout << "Command Format error" << endl;
+		return false;
+	}
+#ifdef CACHESIM_ALLOC_CHECK
+	uint64_t allocations = getScopedAllocations() - allocationsBefore;
+	if (allocations != 0) {
+		cerr << "Allocation check failed: " << allocations
+			 << " heap allocations in the simulation loop" << endl;
+		exit(EXIT_FAILURE);
+	}
+#endif
+	return true;
+}
+
+#endif // COHERENCE_HPP
@@ -0,0 +1,254 @@
+#include "decompress.hpp"
+
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <zlib.h>
+
+extern char** environ;
+
+/**********************************************************************************************/
+
+TraceCompression traceCompression(const char* path) {
+	ifstream file(path, ios::binary);
+	unsigned char magic[4] = {0, 0, 0, 0};
+	if (!file.read((char*)magic, sizeof(magic))) {
+		return COMPRESSION_NONE;
+	}
+	if (magic[0] == 0x1F && magic[1] == 0x8B) {
+		return COMPRESSION_GZIP;
+	}
+	if (magic[0] == 0x28 && magic[1] == 0xB5 && magic[2] == 0x2F && magic[3] == 0xFD) {
+		return COMPRESSION_ZSTD;
+	}
+	return COMPRESSION_NONE;
+}
+
+/**********************************************************************************************/
+// Decompressor definitions
+Decompressor::Decompressor(int fd, TraceCompression compression) :
+		fd(fd), compression(compression), stream(nullptr), input(nullptr), memberEnded(false),
+		child(-1), pipeFd(-1), buffers(nullptr), head(0), tail(0), cursor(0), stopping(false) {
+	if (compression == COMPRESSION_GZIP) {
+		this->stream = new z_stream();
+		// 16 + MAX_WBITS reads the gzip wrapper
+		if (inflateInit2(this->stream, 16 + MAX_WBITS) != Z_OK) {
+			delete this->stream;
+			this->stream = nullptr;
+			return;
+		}
+		this->input = new unsigned char[DECOMPRESS_INPUT];
+	} else if (!this->startChild()) {
+		return;
+	}
+	this->buffers = new DecompressBuffer[DECOMPRESS_BUFFERS];
+	for (int i = 0; i < DECOMPRESS_BUFFERS; i++) {
+		this->buffers[i].data = new char[DECOMPRESS_BUFFER];
+	}
+	this->filler = thread(&Decompressor::fillLoop, this);
+}
+
+Decompressor::~Decompressor() {
+	this->stop();
+	if (this->filler.joinable()) {
+		this->filler.join();
+	}
+	if (this->child > 0) {
+		waitpid(this->child, nullptr, 0);
+	}
+	if (this->pipeFd >= 0) {
+		close(this->pipeFd);
+	}
+	if (this->stream != nullptr) {
+		inflateEnd(this->stream);
+		delete this->stream;
+	}
+	delete[] this->input;
+	if (this->buffers != nullptr) {
+		for (int i = 0; i < DECOMPRESS_BUFFERS; i++) {
+			delete[] this->buffers[i].data;
+		}
+		delete[] this->buffers;
+	}
+}
+
+bool Decompressor::isOpen() {
+	return this->buffers != nullptr;
+}
+
+// runs zstd with the compressed file as its stdin and a pipe to us as its stdout. Its stderr
+// goes to /dev/null, a corrupt file is reported once, by the trace reader.
+bool Decompressor::startChild() {
+	int pipeFds[2];
+	if (pipe2(pipeFds, O_CLOEXEC) != 0) {
+		return false;
+	}
+	posix_spawn_file_actions_t actions;
+	posix_spawn_file_actions_init(&actions);
+	posix_spawn_file_actions_adddup2(&actions, this->fd, STDIN_FILENO);
+	posix_spawn_file_actions_adddup2(&actions, pipeFds[1], STDOUT_FILENO);
+	posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null", O_WRONLY, 0);
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 34))
+	// descriptors of a program embedding the library that lack close on exec
+	posix_spawn_file_actions_addclosefrom_np(&actions, STDERR_FILENO + 1);
+#endif
+	char* argv[] = {(char*)"zstd", (char*)"-dcq", nullptr};
+	int error = posix_spawnp(&this->child, "zstd", &actions, nullptr, argv, environ);
+	posix_spawn_file_actions_destroy(&actions);
+	close(pipeFds[1]);
+	if (error != 0) {
+		close(pipeFds[0]);
+		this->child = -1;
+		cerr << "Cannot run zstd to decompress the trace" << endl;
+		return false;
+	}
+	this->pipeFd = pipeFds[0];
+	return true;
+}
+
+void Decompressor::stop() {
+	{
+		lock_guard<mutex> guard(this->lock);
+		this->stopping = true;
+		// a child still writing would keep the decompression thread in its read
+		if (this->child > 0) {
+			kill(this->child, SIGTERM);
+		}
+	}
+	this->notFull.notify_all();
+	this->notEmpty.notify_all();
+}
+
+long Decompressor::inflateSome(char* out, size_t size) {
+	z_stream& stream = *this->stream;
+	stream.next_out = (Bytef*)out;
+	stream.avail_out = size;
+	// until something comes out, an empty member or a header split across reads gives nothing
+	while (stream.avail_out == size) {
+		if (stream.avail_in == 0) {
+			ssize_t got = ::read(this->fd, this->input, DECOMPRESS_INPUT);
+			if (got < 0 && errno == EINTR) {
+				continue;
+			}
+			if (got <= 0) {
+				// a member cut off by the end of the file is corrupt input
+				return got == 0 && this->memberEnded ? 0 : -1;
+			}
+			stream.next_in = this->input;
+			stream.avail_in = got;
+		}
+		if (this->memberEnded) {
+			// more input after a finished member is the next member
+			inflateReset(&stream);
+			this->memberEnded = false;
+		}
+		int result = inflate(&stream, Z_NO_FLUSH);
+		if (result == Z_STREAM_END) {
+			this->memberEnded = true;
+		} else if (result != Z_OK && result != Z_BUF_ERROR) {
+			return -1;
+		}
+	}
+	return size - stream.avail_out;
+}
+
+long Decompressor::readChild(char* out, size_t size) {
+	while (true) {
+		ssize_t got = ::read(this->pipeFd, out, size);
+		if (got > 0) {
+			return got;
+		}
+		if (got < 0 && errno == EINTR) {
+			continue;
+		}
+		// zstd closed its output, its exit status tells a complete file from a corrupt one.
+		// Wait for it without the lock, so stop can still kill it, and without reaping it, so
+		// its pid cannot be reused before child is cleared under the lock.
+		pid_t pid;
+		{
+			lock_guard<mutex> guard(this->lock);
+			pid = this->child;
+		}
+		siginfo_t info;
+		while (waitid(P_PID, pid, &info, WEXITED | WNOWAIT) != 0 && errno == EINTR) {
+		}
+		lock_guard<mutex> guard(this->lock);
+		int status = 0;
+		bool exited = waitpid(pid, &status, 0) == pid;
+		this->child = -1;
+		return got == 0 && exited && WIFEXITED(status) && WEXITSTATUS(status) == 0 ? 0 : -1;
+	}
+}
+
+void Decompressor::fillLoop() {
+	TraceStatus status = TRACE_OK;
+	while (status == TRACE_OK) {
+		DecompressBuffer* buffer;
+		{
+			unique_lock<mutex> guard(this->lock);
+			while (this->tail - this->head == DECOMPRESS_BUFFERS && !this->stopping) {
+				this->notFull.wait(guard);
+			}
+			if (this->stopping) {
+				return;
+			}
+			buffer = &this->buffers[this->tail % DECOMPRESS_BUFFERS];
+		}
+		// whole buffers, so the parser gets few large chunks
+		buffer->size = 0;
+		while (status == TRACE_OK && buffer->size < DECOMPRESS_BUFFER) {
+			char* out = buffer->data + buffer->size;
+			size_t room = DECOMPRESS_BUFFER - buffer->size;
+			long got = this->compression == COMPRESSION_GZIP ? this->inflateSome(out, room)
+															 : this->readChild(out, room);
+			if (got <= 0) {
+				status = got == 0 ? TRACE_END : TRACE_FORMAT_ERROR;
+			} else {
+				buffer->size += got;
+			}
+		}
+		buffer->status = status;
+		{
+			lock_guard<mutex> guard(this->lock);
+			this->tail++;
+		}
+		this->notEmpty.notify_one();
+	}
+}
+
+long Decompressor::read(char* buffer, size_t size) {
+	while (true) {
+		DecompressBuffer* current;
+		{
+			unique_lock<mutex> guard(this->lock);
+			while (this->head == this->tail && !this->stopping) {
+				this->notEmpty.wait(guard);
+			}
+			if (this->stopping) {
+				return -1;
+			}
+			current = &this->buffers[this->head % DECOMPRESS_BUFFERS];
+		}
+		// the head buffer is ours until it is handed back, copy it without the lock
+		if (this->cursor < current->size) {
+			size_t count = min(size, current->size - this->cursor);
+			memcpy(buffer, current->data + this->cursor, count);
+			this->cursor += count;
+			return count;
+		}
+		if (current->status != TRACE_OK) {
+			return current->status == TRACE_END ? 0 : -1;
+		}
+		{
+			lock_guard<mutex> guard(this->lock);
+			this->head++;
+			this->cursor = 0;
+		}
+		this->notFull.notify_one();
+	}
+}
@@ -0,0 +1,79 @@
+#ifndef DECOMPRESS_HPP
+#define DECOMPRESS_HPP
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "trace.hpp"
+
+using  namespace std;
+
+// Compressed traces, gzip (.gz) and zstd (.zst) files of either trace format, recognized by
+// their magic bytes rather than by their name. They are read like streams (stream.hpp), with
+// one more stage in front of the parser: a decompression thread fills a ring of
+// DECOMPRESS_BUFFERS large buffers, the stream reader thread parses them and the simulation
+// consumes its batches, so decompression, parsing and simulation all overlap.
+// gzip is inflated in process with zlib, concatenated members (pigz, cat a.gz b.gz) included.
+// zstd is decoded by a `zstd -dcq` child process reading the file, whose output the
+// decompression thread collects into the same ring.
+// Only regular files are recognized, pipe compressed stdin through gzip -dc or zstd -dc.
+#define DECOMPRESS_BUFFER (1 << 20) // bytes of decompressed trace per ring buffer
+#define DECOMPRESS_BUFFERS 8
+#define DECOMPRESS_INPUT (1 << 18) // compressed bytes read from the file at a time
+
+enum TraceCompression {
+    COMPRESSION_NONE = 0,
+    COMPRESSION_GZIP = 1,
+    COMPRESSION_ZSTD = 2
+};
+
+// the compression of the regular file at path, COMPRESSION_NONE if it cannot be read
+TraceCompression traceCompression(const char* path);
+
+struct DecompressBuffer {
+    char* data; // DECOMPRESS_BUFFER bytes
+    size_t size;
+    TraceStatus status; // TRACE_OK, or how the input ends after the bytes of this buffer
+};
+
+struct z_stream_s;
+
+class Decompressor {
+private:
+    int fd; // the compressed file, owned by the caller
+    TraceCompression compression;
+    z_stream_s* stream; // gzip state
+    unsigned char* input; // DECOMPRESS_INPUT compressed bytes for zlib
+    bool memberEnded; // the last inflate finished a gzip member
+    pid_t child; // zstd process, -1 once it has been waited for
+    int pipeFd; // its output
+    DecompressBuffer* buffers;
+    uint64_t head, tail; // buffers consumed and published so far, guarded by lock
+    size_t cursor; // bytes of the head buffer already read
+    mutex lock;
+    condition_variable notEmpty, notFull;
+    bool stopping;
+    thread filler;
+    Decompressor(const Decompressor&) = delete;
+    Decompressor& operator=(const Decompressor&) = delete;
+    bool startChild();
+    // decompression thread side
+    void fillLoop();
+    // decompress up to size bytes, returns 0 at the end of the input and -1 on corrupt input
+    long inflateSome(char* out, size_t size);
+    long readChild(char* out, size_t size);
+public:
+    Decompressor(int fd, TraceCompression compression);
+    ~Decompressor();
+    bool isOpen();
+    // copy up to size decompressed bytes into buffer, returns 0 at the end of the input and -1
+    // on corrupt input or once stopped
+    long read(char* buffer, size_t size);
+    // wake and end both sides, read returns -1 from then on
+    void stop();
+};
+
+#endif // DECOMPRESS_HPP
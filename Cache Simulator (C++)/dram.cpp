@@ -0,0 +1,156 @@
+#include "dram.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+/**********************************************************************************************/
+// DramStats definitions
+DramStats& DramStats::operator+=(const DramStats& other) {
+	this->reads += other.reads;
+	this->writes += other.writes;
+	this->rowHits += other.rowHits;
+	this->rowMisses += other.rowMisses;
+	this->rowConflicts += other.rowConflicts;
+	this->queueCycles += other.queueCycles;
+	this->latencyCycles += other.latencyCycles;
+	for (int i = 0; i < MAX_DRAM_BANKS; i++) {
+		this->banks[i].accesses += other.banks[i].accesses;
+		this->banks[i].rowHits += other.banks[i].rowHits;
+		this->banks[i].rowConflicts += other.banks[i].rowConflicts;
+	}
+	return *this;
+}
+
+DramStats& DramStats::operator-=(const DramStats& other) {
+	this->reads -= other.reads;
+	this->writes -= other.writes;
+	this->rowHits -= other.rowHits;
+	this->rowMisses -= other.rowMisses;
+	this->rowConflicts -= other.rowConflicts;
+	this->queueCycles -= other.queueCycles;
+	this->latencyCycles -= other.latencyCycles;
+	for (int i = 0; i < MAX_DRAM_BANKS; i++) {
+		this->banks[i].accesses -= other.banks[i].accesses;
+		this->banks[i].rowHits -= other.banks[i].rowHits;
+		this->banks[i].rowConflicts -= other.banks[i].rowConflicts;
+	}
+	return *this;
+}
+
+/**********************************************************************************************/
+// DramModel definitions
+DramModel::DramModel() : MemCyc(0), columnBits(0), channelBits(0), rankBits(0), bankBits(0) {
+	memset(&this->config, 0, sizeof(this->config));
+	this->config.channels = DRAM_OFF;
+	for (int i = 0; i < MAX_DRAM_BANKS; i++) {
+		this->banks[i].openRow = DRAM_NO_ROW;
+		this->banks[i].ready = 0;
+	}
+}
+
+void DramModel::initDram(const DramConfig& config, unsigned int blockBits, unsigned int MemCyc) {
+	this->config = config;
+	this->MemCyc = MemCyc;
+	if (config.channels == DRAM_OFF) {
+		return;
+	}
+	this->columnBits = config.rowSize - blockBits;
+	this->channelBits = __builtin_ctz(config.channels);
+	this->rankBits = __builtin_ctz(config.ranks);
+	this->bankBits = __builtin_ctz(config.banks);
+}
+
+bool DramModel::isEnabled() {
+	return this->config.channels != DRAM_OFF;
+}
+
+unsigned int DramModel::mapBlock(uint64_t block, uint64_t& row) {
+	uint64_t rest = block;
+	if (this->config.mapping != DRAM_MAP_LINE) {
+		rest >>= this->columnBits;
+	}
+	uint64_t channel = rest & ((1 << this->channelBits) - 1);
+	rest >>= this->channelBits;
+	uint64_t bank = rest & ((1 << this->bankBits) - 1);
+	rest >>= this->bankBits;
+	uint64_t rank = rest & ((1 << this->rankBits) - 1);
+	rest >>= this->rankBits;
+	if (this->config.mapping == DRAM_MAP_LINE) {
+		rest >>= this->columnBits;
+	}
+	row = rest;
+	if (this->config.mapping == DRAM_MAP_XOR) {
+		bank ^= row & ((1 << this->bankBits) - 1);
+	}
+	return (unsigned int)((((channel << this->rankBits) | rank) << this->bankBits) | bank);
+}
+
+uint64_t DramModel::access(uint64_t block, bool write, uint64_t now, DramStats& stats) {
+	uint64_t row;
+	unsigned int index = this->mapBlock(block, row);
+	Bank& bank = this->banks[index];
+	DramBankStats& bankStats = stats.banks[index];
+	uint64_t start = max(now, bank.ready);
+	uint64_t service = this->config.tRCD + this->config.tCAS;
+	if (this->config.page == DRAM_CLOSED_PAGE) {
+		stats.rowMisses++;
+		bank.ready = start + service + this->config.tRP;
+	} else {
+		if (bank.openRow == row) {
+			service = this->config.tCAS;
+			stats.rowHits++;
+			bankStats.rowHits++;
+		} else if (bank.openRow == DRAM_NO_ROW) {
+			stats.rowMisses++;
+		} else {
+			service += this->config.tRP;
+			stats.rowConflicts++;
+			bankStats.rowConflicts++;
+		}
+		bank.openRow = row;
+		bank.ready = start + service;
+	}
+	uint64_t latency = start - now + service + this->MemCyc;
+	if (write) {
+		stats.writes++;
+	} else {
+		stats.reads++;
+	}
+	stats.queueCycles += start - now;
+	stats.latencyCycles += latency;
+	bankStats.accesses++;
+	return latency;
+}
+
+void DramModel::saveState(CheckpointWriter& checkpoint) {
+	checkpoint.write(this->banks, sizeof(this->banks));
+}
+
+bool DramModel::restoreState(CheckpointReader& checkpoint) {
+	return checkpoint.read(this->banks, sizeof(this->banks));
+}
+
+/**********************************************************************************************/
+
+static const char* pageNames[] = {"open", "closed"};
+static const char* mappingNames[] = {"page", "line", "xor"};
+
+bool parseDramPagePolicy(const string& name, DramPagePolicy& page) {
+	for (int i = 0; i < (int)(sizeof(pageNames) / sizeof(pageNames[0])); i++) {
+		if (name == pageNames[i]) {
+			page = (DramPagePolicy)i;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool parseDramMapping(const string& name, DramMapping& mapping) {
+	for (int i = 0; i < (int)(sizeof(mappingNames) / sizeof(mappingNames[0])); i++) {
+		if (name == mappingNames[i]) {
+			mapping = (DramMapping)i;
+			return true;
+		}
+	}
+	return false;
+}
@@ -0,0 +1,92 @@
+#ifndef DRAM_HPP
+#define DRAM_HPP
+
+#include <string>
+#include <stdint.h>
+
+#include "checkpoint.hpp"
+
+using  namespace std;
+
+// DRAM behind L2, in place of the flat MemCyc of every memory access. Memory is channels x
+// ranks x banks independent banks, each with one row buffer of 2^rowSize bytes. A block goes
+// to a bank and a row by the address mapping, and costs, on top of MemCyc (the controller and
+// the bus):
+//   row hit      - the row is open in the bank: tCAS
+//   row miss     - the bank is precharged: tRCD + tCAS
+//   row conflict - another row is open: tRP + tRCD + tCAS
+// An open page bank keeps its row open for the next access, a closed page bank precharges
+// right after every access, so it never hits and never conflicts but is busy for tRP more.
+// An access to a bank that is still busy, with a write-back or a prefetch, waits for it
+// first. Times are on the serial clock of the cache (see BasicCache::getNow).
+// The mappings, from the low block address bits up:
+//   page - column, channel, bank, rank, row: a row holds consecutive blocks
+//   line - channel, bank, rank, column, row: consecutive blocks go to different banks
+//   xor  - page, with the bank bits XORed with the low row bits (Zhang et al., MICRO 2000),
+//          so rows that conflict in one bank under page spread over the banks
+#define DRAM_OFF 0 // channels, the flat MemCyc model
+#define MAX_DRAM_BANKS 64 // channels x ranks x banks
+#define DRAM_NO_ROW (~(uint64_t)0)
+
+enum DramPagePolicy {
+    DRAM_OPEN_PAGE = 0,
+    DRAM_CLOSED_PAGE = 1
+};
+
+enum DramMapping {
+    DRAM_MAP_PAGE = 0,
+    DRAM_MAP_LINE = 1,
+    DRAM_MAP_XOR = 2
+};
+
+struct DramConfig {
+    unsigned int channels; // DRAM_OFF, or a power of two as are ranks and banks
+    unsigned int ranks, banks; // per channel and per rank
+    unsigned int rowSize; // log2 of the bytes of a row buffer, at least one block
+    unsigned int tRCD, tCAS, tRP; // in cycles
+    DramPagePolicy page;
+    DramMapping mapping;
+};
+
+// "open" or "closed", and "page", "line" or "xor", return false for anything else
+bool parseDramPagePolicy(const string& name, DramPagePolicy& page);
+bool parseDramMapping(const string& name, DramMapping& mapping);
+
+struct DramBankStats {
+    uint64_t accesses;
+    uint64_t rowHits, rowConflicts;
+};
+
+struct DramStats {
+    uint64_t reads, writes; // blocks read (demand and prefetch) and written back
+    uint64_t rowHits, rowMisses, rowConflicts;
+    uint64_t queueCycles; // waiting for a busy bank
+    uint64_t latencyCycles; // of every access, MemCyc included
+    DramBankStats banks[MAX_DRAM_BANKS]; // by channel, then rank, then bank
+    DramStats& operator+=(const DramStats& other);
+    DramStats& operator-=(const DramStats& other);
+};
+
+class DramModel {
+private:
+    struct Bank {
+        uint64_t openRow; // DRAM_NO_ROW when precharged
+        uint64_t ready; // cycle the bank takes its next access
+    };
+    DramConfig config;
+    unsigned int MemCyc;
+    unsigned int columnBits, channelBits, rankBits, bankBits;
+    Bank banks[MAX_DRAM_BANKS];
+    // the bank (as in DramStats::banks) and row of block
+    unsigned int mapBlock(uint64_t block, uint64_t& row);
+public:
+    DramModel();
+    void initDram(const DramConfig& config, unsigned int blockBits, unsigned int MemCyc);
+    bool isEnabled();
+    // an access to block issued at cycle now, returns its latency, MemCyc included
+    uint64_t access(uint64_t block, bool write, uint64_t now, DramStats& stats);
+    void saveState(CheckpointWriter& checkpoint);
+    bool restoreState(CheckpointReader& checkpoint);
+};
+
+#endif // DRAM_HPP
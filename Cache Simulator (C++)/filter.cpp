@@ -0,0 +1,234 @@
+#include "filter.hpp"
+#include "stream.hpp"
+
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**********************************************************************************************/
+
+FilteredTraceHeader makeFilteredTraceHeader(const CacheConfig& config) {
+	FilteredTraceHeader header;
+	header.magic = FILTER_MAGIC;
+	header.version = FILTER_VERSION;
+	header.tagBits = FULL_TAG_SIZE;
+	uint32_t fields[10] = {config.BSize, config.L1Size, config.L1Assoc, config.L1Cyc, config.WrAlloc,
+						   (uint32_t)config.L1Indexing, config.L1ISize, config.L1IAssoc, config.L1ICyc,
+						   (uint32_t)config.replacement};
+	memcpy(header.config, fields, sizeof(fields));
+	header.numAccesses = 0;
+	header.numRecords = 0;
+	return header;
+}
+
+bool isReplayableConfig(const FilteredTraceHeader& header, const CacheConfig& config) {
+	FilteredTraceHeader expected = makeFilteredTraceHeader(config);
+	// every L1 field but the replacement policy, which the replay leaves to L2
+	if (header.tagBits != expected.tagBits ||
+		memcmp(header.config, expected.config, 9 * sizeof(header.config[0])) != 0) {
+		return false;
+	}
+	return config.victimEntries == VICTIM_OFF && config.L1Prefetch.kind == PREFETCH_NONE &&
+		   config.tlb.L1Entries == TLB_OFF;
+}
+
+unsigned int filteredEvictionShift(const FilteredTraceHeader& header, bool L1I) {
+	// BSize, and the L1I's size and associativity in place of the L1's
+	const uint32_t* c = header.config;
+	if (c[5] != INDEX_MODULO) {
+		return 0;
+	}
+	if (L1I) {
+		return c[6] == L1I_OFF ? 0 : c[6] - c[0] - c[7];
+	}
+	return c[1] - c[0] - c[2];
+}
+
+/**********************************************************************************************/
+// FilteredTraceWriter definitions
+FilteredTraceWriter::FilteredTraceWriter(const char* path, const FilteredTraceHeader& header) :
+		file(path, ios::binary | ios::trunc), header(header), lastBlock(0), used(0) {
+	this->shifts[0] = filteredEvictionShift(header, false);
+	this->shifts[1] = filteredEvictionShift(header, true);
+	// the header is rewritten with the final counts on close
+	this->file.write((const char*)&this->header, sizeof(this->header));
+}
+
+FilteredTraceWriter::~FilteredTraceWriter() {
+	if (this->file.is_open()) {
+		this->file.close();
+	}
+}
+
+bool FilteredTraceWriter::isOpen() {
+	return this->file.is_open() && this->file.good();
+}
+
+void FilteredTraceWriter::flush() {
+	this->file.write(this->buffer, this->used);
+	this->used = 0;
+}
+
+void FilteredTraceWriter::append(const FilteredRecord& record) {
+	if (this->used + FILTER_MAX_RECORD > sizeof(this->buffer)) {
+		this->flush();
+	}
+	this->used += encodeFilteredRecord((uint8_t*)this->buffer + this->used, record, this->lastBlock,
+									   this->shifts[record.operation == FILTER_FETCH]);
+	this->header.numRecords++;
+}
+
+bool FilteredTraceWriter::close(uint64_t numAccesses) {
+	this->flush();
+	this->header.numAccesses = numAccesses;
+	this->file.seekp(0);
+	this->file.write((const char*)&this->header, sizeof(this->header));
+	bool ok = this->file.good();
+	this->file.close();
+	return ok && !this->file.fail();
+}
+
+/**********************************************************************************************/
+// FilteredTraceReader definitions
+FilteredTraceReader::FilteredTraceReader(const char* path) : data(nullptr), size(0), records(nullptr),
+															 cursor(nullptr), end(nullptr), lastBlock(0) {
+	memset(&this->header, 0, sizeof(this->header));
+	this->shifts[0] = this->shifts[1] = 0;
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		return;
+	}
+	struct stat st;
+	if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(FilteredTraceHeader)) {
+		void* mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (mapped != MAP_FAILED) {
+			madvise(mapped, st.st_size, MADV_SEQUENTIAL);
+			this->data = (const uint8_t*)mapped;
+			this->size = st.st_size;
+		}
+	}
+	close(fd);
+	if (this->data == nullptr) {
+		return;
+	}
+	memcpy(&this->header, this->data, sizeof(this->header));
+	if (this->header.magic != FILTER_MAGIC || this->header.version != FILTER_VERSION) {
+		munmap((void*)this->data, this->size);
+		this->data = nullptr;
+		return;
+	}
+	this->shifts[0] = filteredEvictionShift(this->header, false);
+	this->shifts[1] = filteredEvictionShift(this->header, true);
+	this->records = this->data + sizeof(FilteredTraceHeader);
+	this->cursor = this->records;
+	this->end = this->data + this->size;
+}
+
+FilteredTraceReader::FilteredTraceReader(const FilteredTraceHeader& header, const uint8_t* records,
+										 const uint8_t* end) :
+		data(nullptr), size(0), header(header), records(records), cursor(records), end(end), lastBlock(0) {
+	this->shifts[0] = filteredEvictionShift(header, false);
+	this->shifts[1] = filteredEvictionShift(header, true);
+}
+
+FilteredTraceReader::~FilteredTraceReader() {
+	if (this->data != nullptr) {
+		munmap((void*)this->data, this->size);
+	}
+}
+
+bool FilteredTraceReader::isOpen() {
+	return this->records != nullptr;
+}
+
+const FilteredTraceHeader& FilteredTraceReader::getHeader() {
+	return this->header;
+}
+
+const uint8_t* FilteredTraceReader::getRecords() {
+	return this->records;
+}
+
+const uint8_t* FilteredTraceReader::getRecordsEnd() {
+	return this->end;
+}
+
+/**********************************************************************************************/
+
+bool isFilteredTrace(const char* path) {
+	ifstream file(path, ios::binary);
+	uint32_t magic = 0;
+	if (!file.read((char*)&magic, sizeof(magic))) {
+		return false;
+	}
+	return magic == FILTER_MAGIC;
+}
+
+struct FilterRunner {
+	typedef bool Result;
+	const char* inputPath;
+	FilteredTraceWriter& writer;
+	const CacheConfig& config;
+	uint64_t& numAccesses;
+	template <class ReplacementPolicy>
+	bool run() {
+		L1Filter<ReplacementPolicy> filter(this->writer, this->config);
+		bool ok = simulateTraceInput(this->inputPath, filter);
+		filter.finish();
+		this->numAccesses = filter.getNumAccesses();
+		return ok;
+	}
+};
+
+bool recordFilteredTrace(const char* inputPath, const char* outputPath, const CacheConfig& config,
+						 uint64_t& numAccesses, uint64_t& numRecords) {
+	FilteredTraceWriter writer(outputPath, makeFilteredTraceHeader(config));
+	if (!writer.isOpen()) {
+		cerr << "Cannot create " << outputPath << endl;
+		return false;
+	}
+	FilterRunner runner = {inputPath, writer, config, numAccesses};
+	if (!dispatchReplacementPolicy(config.replacement, runner)) {
+		return false;
+	}
+	numRecords = writer.getNumRecords();
+	if (!writer.close(numAccesses)) {
+		cerr << "Cannot write " << outputPath << endl;
+		return false;
+	}
+	return true;
+}
+
+struct ReplayRunner {
+	typedef bool Result;
+	FilteredTraceReader& reader;
+	const CacheConfig& config;
+	CacheStats& stats;
+	template <class ReplacementPolicy>
+	bool run() {
+		BasicCache<ReplacementPolicy> cache(this->config);
+		bool ok = replayFilteredTrace(this->reader, cache);
+		this->stats = cache.getStats();
+		return ok;
+	}
+};
+
+bool simulateFilteredConfig(FilteredTraceReader& reader, const CacheConfig& config, CacheStats& stats) {
+	ReplayRunner runner = {reader, config, stats};
+	return dispatchReplacementPolicy(config.replacement, runner);
+}
+
+bool simulateFilteredFile(const char* path, const CacheConfig& config, CacheStats& stats) {
+	FilteredTraceReader reader(path);
+	if (!reader.isOpen()) {
+		cerr << "File not found" << endl;
+		return false;
+	}
+	if (!isReplayableConfig(reader.getHeader(), config)) {
+		cerr << "The filtered trace was recorded with another L1" << endl;
+		return false;
+	}
+	return simulateFilteredConfig(reader, config, stats);
+}
@@ -0,0 +1,447 @@
+#ifndef FILTER_HPP
+#define FILTER_HPP
+
+#include <fstream>
+#include <stdint.h>
+
+#include "cacheSim.hpp"
+#include "trace.hpp"
+
+using  namespace std;
+
+// L1-filtered traces, for studies that only change L2 and what is below it.
+//
+// cacheSim --filter runs the L1 of one configuration alone over a trace and keeps the
+// accesses that get past it: L1 misses, with the L1 line the miss evicted (whose write-back is
+// L2's business), and the first write to a clean L1 line, which makes it dirty. Hits leave only
+// their number. The L1 is simulated without an L2, so the recorded L1 never loses lines to L2
+// evictions.
+//
+// Given as the trace of a run (or of a sweep), a filtered trace is replayed: the misses go to
+// the cache as the accesses they were and the hits are counted with their L1 cycles. The
+// replayed L1 holds exactly the lines the recorded one held, it takes the misses in the same
+// order and every fill evicts the recorded line (see BasicCache::replayEviction) instead of
+// asking the replacement policy, which is left to L2 (--repl). A replayed write makes its line
+// dirty as in a full run. L2 evictions still back-invalidate the replayed L1, merging dirty
+// lines into their write-back, and a back-invalidated line is not written back again when the
+// recording evicts it.
+// The replay matches a full run counter for counter until L2 back-invalidates a line the L1
+// goes on to hit: the full run misses again there, the replay keeps counting the recorded hits.
+// Inclusion victims are rare when L2 is much larger than L1, but they do happen.
+//
+// The L1 geometry, latency, write policy and index function (and an L1I's) are fixed by the
+// recording and checked against the replaying configuration. The L1 side models (victim
+// cache, L1 prefetcher, TLB) see every access and cannot be replayed, and neither can the
+// modes that need the accesses (multi core, shards, sampling, intervals, MSHRs, classify,
+// checkpoints). A skewed L1 places lines by their age and is not filtered either.
+//
+// Layout (little endian):
+//   header  - FilteredTraceHeader below
+//   records - one per access past the L1, then one FILTER_END record with the hits after the
+//             last of them. Block addresses (address >> BSize) are deltas from the previous
+//             record's block, zigzag encoded, packed with the operation as a varint:
+//             byte 0:  bits 0-2 = operation, bit 3 = evicts, bits 4-6 = low 3 delta bits,
+//                      bit 7 = more
+//             byte 1+: 7 delta bits each, bit 7 = more
+//             then, if evicts, the evicted block as a zigzag delta from the record's block,
+//             in units of the sets of the L1 it was in when that is indexed by mod (the delta
+//             of the tags), then the hits since the previous record: the read hits shifted
+//             left by 2, bit 1 set if write hits follow and bit 0 if fetch hits follow, and
+//             those. Every number past byte 0 is a varint (7 bits per byte, bit 7 = more).
+#define FILTER_MAGIC 0x464C5343 // "CSLF"
+#define FILTER_VERSION 1
+#define FILTER_MAX_RECORD 50 // five varints of up to 10 bytes
+
+enum FilterOperation {
+    FILTER_READ = 0, // read miss
+    FILTER_WRITE = 1, // write miss
+    FILTER_FETCH = 2, // instruction fetch miss
+    FILTER_DIRTY = 3, // write hit to a clean line
+    FILTER_END = 4 // the hits after the last record, no block
+};
+
+struct FilteredTraceHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t tagBits; // FULL_TAG_SIZE of the recording build, evicted blocks are L1 blocks
+    // BSize, L1Size, L1Assoc, L1Cyc, WrAlloc, L1Indexing, L1ISize, L1IAssoc, L1ICyc and the
+    // recorded replacement policy
+    uint32_t config[10];
+    uint64_t numAccesses; // of the original trace
+    uint64_t numRecords; // FILTER_END included
+};
+
+struct FilteredRecord {
+    FilterOperation operation;
+    bool evicts; // the fill evicted the L1 (or L1I) line of evicted
+    uint64_t block, evicted;
+    uint64_t readHits, writeHits, fetchHits; // L1 hits since the previous record
+};
+
+// the header a recording of config starts with
+FilteredTraceHeader makeFilteredTraceHeader(const CacheConfig& config);
+
+// true if a filtered trace of header can be replayed with config, see above
+bool isReplayableConfig(const FilteredTraceHeader& header, const CacheConfig& config);
+
+// the bits the evicted blocks of header's L1 (L1I if set) are shifted by in the records, the
+// index bits of a level indexed by mod, 0 otherwise
+unsigned int filteredEvictionShift(const FilteredTraceHeader& header, bool L1I);
+
+// Writes the filtered format, the header is rewritten with the counts on close
+class FilteredTraceWriter {
+private:
+    ofstream file;
+    FilteredTraceHeader header;
+    uint64_t lastBlock;
+    unsigned int shifts[2]; // filteredEvictionShift of L1 and of an L1I
+    char buffer[1 << 16];
+    size_t used;
+    void flush();
+public:
+    FilteredTraceWriter(const char* path, const FilteredTraceHeader& header);
+    ~FilteredTraceWriter();
+    bool isOpen();
+    void append(const FilteredRecord& record);
+    uint64_t getNumRecords() { return this->header.numRecords; }
+    // writes the header, returns false if anything failed
+    bool close(uint64_t numAccesses);
+};
+
+// Maps a filtered trace and decodes it in place, or reads records someone else keeps alive
+// (the threads of a sweep share one mapping)
+class FilteredTraceReader {
+private:
+    const uint8_t* data; // the mapping, nullptr when reading records owned by someone else
+    size_t size;
+    FilteredTraceHeader header;
+    const uint8_t* records;
+    const uint8_t* cursor;
+    const uint8_t* end;
+    uint64_t lastBlock;
+    unsigned int shifts[2]; // filteredEvictionShift of L1 and of an L1I
+    FilteredTraceReader(const FilteredTraceReader&) = delete;
+    FilteredTraceReader& operator=(const FilteredTraceReader&) = delete;
+public:
+    FilteredTraceReader(const char* path);
+    FilteredTraceReader(const FilteredTraceHeader& header, const uint8_t* records, const uint8_t* end);
+    ~FilteredTraceReader();
+    bool isOpen();
+    const FilteredTraceHeader& getHeader();
+    const uint8_t* getRecords();
+    const uint8_t* getRecordsEnd();
+    TraceStatus next(FilteredRecord& record);
+};
+
+// true if the file at path starts with the filtered trace magic
+bool isFilteredTrace(const char* path);
+
+// run the L1 of config over the trace at inputPath (a file or a stream) and write the
+// filtered trace to outputPath. Prints the reason and returns false on any error.
+bool recordFilteredTrace(const char* inputPath, const char* outputPath, const CacheConfig& config,
+                         uint64_t& numAccesses, uint64_t& numRecords);
+
+// replay a filtered trace with config, which has to be isReplayableConfig. Returns false on a
+// format error.
+bool simulateFilteredConfig(FilteredTraceReader& reader, const CacheConfig& config, CacheStats& stats);
+
+// simulateFilteredConfig for the file at path, printing the reason of any error
+bool simulateFilteredFile(const char* path, const CacheConfig& config, CacheStats& stats);
+
+/**********************************************************************************************/
+// The recording L1
+
+// A Simulator (see trace.hpp) of the L1 alone, appending the accesses it does not hit to a
+// FilteredTraceWriter
+template <class ReplacementPolicy>
+class L1Filter {
+private:
+    FilteredTraceWriter& writer;
+    unsigned int BSize;
+    unsigned int WrAlloc;
+    bool split; // fetches go to the L1I
+    CacheLevel<ReplacementPolicy> L1, L1I;
+    FilteredRecord pending; // the hits since the last record, and its block
+    uint64_t numAccesses;
+    // look block up in level, filling it into record on a miss and into level as well if
+    // allocate is set. Returns the way it hit in with its set, or NO_WAY.
+    unsigned int access(CacheLevel<ReplacementPolicy>& level, uint64_t block, bool allocate,
+                        FilteredRecord& record, unsigned int& set);
+    void append(FilteredRecord& record);
+public:
+    L1Filter(FilteredTraceWriter& writer, const CacheConfig& config);
+    void readFromCache(uint64_t address);
+    void writeToCache(uint64_t address);
+    void fetchFromCache(uint64_t address);
+    // append the FILTER_END record
+    void finish();
+    uint64_t getNumAccesses() { return this->numAccesses; }
+};
+
+template <class ReplacementPolicy>
+L1Filter<ReplacementPolicy>::L1Filter(FilteredTraceWriter& writer, const CacheConfig& config) :
+		writer(writer), BSize(config.BSize), WrAlloc(config.WrAlloc), split(config.L1ISize != L1I_OFF),
+		pending(), numAccesses(0) {
+	this->L1.initLevel(1 << (config.L1Size - config.BSize - config.L1Assoc), 1 << config.L1Assoc,
+					   config.L1Indexing);
+	if (this->split) {
+		this->L1I.initLevel(1 << (config.L1ISize - config.BSize - config.L1IAssoc), 1 << config.L1IAssoc,
+							config.L1Indexing);
+	}
+}
+
+template <class ReplacementPolicy>
+inline unsigned int L1Filter<ReplacementPolicy>::access(CacheLevel<ReplacementPolicy>& level, uint64_t block,
+														bool allocate, FilteredRecord& record, unsigned int& set) {
+	// the level sees the block with the address bits a tag keeps, as in BasicCache
+	CacheTag cacheBlock = (CacheTag)(block << this->BSize) >> this->BSize;
+	unsigned int way = level.findBlock(cacheBlock, set);
+	if (way != NO_WAY) {
+		level.touchLine(set, way);
+		return way;
+	}
+	record.block = block;
+	record.evicts = false;
+	if (!allocate) {
+		return NO_WAY;
+	}
+	way = level.insertBlock(cacheBlock, set);
+	if (way == NO_WAY) {
+		EvictedLine victim = level.evictLine(set, level.selectBlockVictim(cacheBlock, set));
+		record.evicts = true;
+		record.evicted = level.getBlock(victim.tag, set);
+		way = level.insertBlock(cacheBlock, set);
+	}
+	if (record.operation == FILTER_WRITE) {
+		level.setDirty(set, way, true);
+	}
+	return NO_WAY;
+}
+
+template <class ReplacementPolicy>
+inline void L1Filter<ReplacementPolicy>::append(FilteredRecord& record) {
+	record.readHits = this->pending.readHits;
+	record.writeHits = this->pending.writeHits;
+	record.fetchHits = this->pending.fetchHits;
+	this->writer.append(record);
+	this->pending = FilteredRecord();
+	this->pending.block = record.block;
+}
+
+template <class ReplacementPolicy>
+void L1Filter<ReplacementPolicy>::readFromCache(uint64_t address) {
+	this->numAccesses++;
+	FilteredRecord record;
+	record.operation = FILTER_READ;
+	unsigned int set;
+	if (this->access(this->L1, address >> this->BSize, true, record, set) != NO_WAY) {
+		this->pending.readHits++;
+		return;
+	}
+	this->append(record);
+}
+
+template <class ReplacementPolicy>
+void L1Filter<ReplacementPolicy>::writeToCache(uint64_t address) {
+	this->numAccesses++;
+	FilteredRecord record;
+	record.operation = FILTER_WRITE;
+	unsigned int set;
+	unsigned int way = this->access(this->L1, address >> this->BSize, this->WrAlloc == WRITE_ALLOCATE,
+									record, set);
+	if (way == NO_WAY) {
+		this->append(record);
+		return;
+	}
+	if (this->L1.getDirty(set, way)) {
+		this->pending.writeHits++;
+		return;
+	}
+	// the replay sees the write that makes the line dirty
+	this->L1.setDirty(set, way, true);
+	record.operation = FILTER_DIRTY;
+	record.block = address >> this->BSize;
+	record.evicts = false;
+	this->append(record);
+}
+
+template <class ReplacementPolicy>
+void L1Filter<ReplacementPolicy>::fetchFromCache(uint64_t address) {
+	this->numAccesses++;
+	FilteredRecord record;
+	record.operation = FILTER_FETCH;
+	unsigned int set;
+	if (this->access(this->split ? this->L1I : this->L1, address >> this->BSize, true, record, set) != NO_WAY) {
+		this->pending.fetchHits++;
+		return;
+	}
+	this->append(record);
+}
+
+template <class ReplacementPolicy>
+void L1Filter<ReplacementPolicy>::finish() {
+	// at the block of the last record, a delta of 0
+	FilteredRecord record = this->pending;
+	record.operation = FILTER_END;
+	record.evicts = false;
+	this->append(record);
+}
+
+/**********************************************************************************************/
+// Replay
+
+// feed the filtered trace of reader into cache, a BasicCache of a replayable configuration.
+// Returns false on a format error.
+template <class Cache>
+bool replayFilteredTrace(FilteredTraceReader& reader, Cache& cache) {
+	unsigned int BSize = reader.getHeader().config[0];
+	FilteredRecord record;
+	bool ended = false;
+#ifdef CACHESIM_ALLOC_CHECK
+	uint64_t allocationsBefore = getScopedAllocations();
+#endif
+	while (!ended && reader.next(record) == TRACE_OK) {
+		cache.replayHits(record.readHits, record.writeHits, record.fetchHits);
+		if (record.evicts) {
+			cache.replayEviction((CacheTag)record.evicted);
+		}
+		uint64_t address = record.block << BSize;
+		if (record.operation == FILTER_READ) {
+			cache.readFromCache(address);
+		} else if (record.operation == FILTER_WRITE || record.operation == FILTER_DIRTY) {
+			cache.writeToCache(address);
+		} else if (record.operation == FILTER_FETCH) {
+			cache.fetchFromCache(address);
+		} else {
+			ended = true;
+		}
+	}
+	// a recording that did not finish has no FILTER_END record
+	if (!ended) {
+		cout << "Command Format error" << endl;
+		return false;
+	}
+#ifdef CACHESIM_ALLOC_CHECK
+	uint64_t allocations = getScopedAllocations() - allocationsBefore;
+	if (allocations != 0) {
+		cerr << "Allocation check failed: " << allocations
+			 << " heap allocations in the simulation loop" << endl;
+		exit(EXIT_FAILURE);
+	}
+#endif
+	return true;
+}
+
+/**********************************************************************************************/
+// Record encoding and the FilteredTraceReader hot path
+
+inline size_t encodeFilterVarint(uint8_t* out, uint64_t value) {
+	size_t length = 0;
+	while (value >= 0x80) {
+		out[length++] = (uint8_t)(value | 0x80);
+		value >>= 7;
+	}
+	out[length++] = (uint8_t)value;
+	return length;
+}
+
+// returns false if the varint is cut off by end or longer than 64 bits
+inline bool decodeFilterVarint(const uint8_t*& p, const uint8_t* end, uint64_t& value) {
+	value = 0;
+	unsigned int shift = 0;
+	uint8_t byte;
+	do {
+		if (p == end || shift > 63) {
+			return false;
+		}
+		byte = *p++;
+		value |= (uint64_t)(byte & 0x7F) << shift;
+		shift += 7;
+	} while (byte & 0x80);
+	return true;
+}
+
+inline uint64_t zigzagEncode(uint64_t delta) {
+	return (delta << 1) ^ (0 - (delta >> 63));
+}
+
+inline uint64_t zigzagDecode(uint64_t zigzag) {
+	return (zigzag >> 1) ^ (0 - (zigzag & 1));
+}
+
+// encode record after lastBlock into out (at least FILTER_MAX_RECORD bytes), its evicted
+// block shifted right by shift. Returns its length.
+inline size_t encodeFilteredRecord(uint8_t* out, const FilteredRecord& record, uint64_t& lastBlock,
+								   unsigned int shift) {
+	uint64_t zigzag = zigzagEncode(record.block - lastBlock);
+	lastBlock = record.block;
+	size_t length = 0;
+	uint8_t byte = (uint8_t)record.operation | (record.evicts ? 0x08 : 0) | (uint8_t)((zigzag & 0x07) << 4);
+	zigzag >>= 3;
+	if (zigzag != 0) {
+		byte |= 0x80;
+	}
+	out[length++] = byte;
+	if (zigzag != 0) {
+		length += encodeFilterVarint(out + length, zigzag);
+	}
+	if (record.evicts) {
+		// both blocks are in one set, the low shift bits of the delta are 0
+		int64_t delta = (int64_t)(record.evicted - record.block) >> shift;
+		length += encodeFilterVarint(out + length, zigzagEncode((uint64_t)delta));
+	}
+	length += encodeFilterVarint(out + length, (record.readHits << 2) | (record.writeHits != 0 ? 2 : 0) |
+											   (record.fetchHits != 0 ? 1 : 0));
+	if (record.writeHits != 0) {
+		length += encodeFilterVarint(out + length, record.writeHits);
+	}
+	if (record.fetchHits != 0) {
+		length += encodeFilterVarint(out + length, record.fetchHits);
+	}
+	return length;
+}
+
+inline TraceStatus FilteredTraceReader::next(FilteredRecord& record) {
+	if (this->cursor == this->end) {
+		return TRACE_END;
+	}
+	const uint8_t* p = this->cursor;
+	uint8_t byte = *p++;
+	uint64_t zigzag = (byte >> 4) & 0x07;
+	if (byte & 0x80) {
+		uint64_t rest;
+		if (!decodeFilterVarint(p, this->end, rest) || rest > (~(uint64_t)0 >> 3)) {
+			return TRACE_FORMAT_ERROR;
+		}
+		zigzag |= rest << 3;
+	}
+	record.operation = (FilterOperation)(byte & 0x07);
+	record.evicts = (byte & 0x08) != 0;
+	if (record.operation > FILTER_END) {
+		return TRACE_FORMAT_ERROR;
+	}
+	record.block = this->lastBlock + zigzagDecode(zigzag);
+	if (record.evicts) {
+		uint64_t delta;
+		if (!decodeFilterVarint(p, this->end, delta)) {
+			return TRACE_FORMAT_ERROR;
+		}
+		record.evicted = record.block + (zigzagDecode(delta) << this->shifts[record.operation == FILTER_FETCH]);
+	}
+	uint64_t hits;
+	if (!decodeFilterVarint(p, this->end, hits)) {
+		return TRACE_FORMAT_ERROR;
+	}
+	record.readHits = hits >> 2;
+	record.writeHits = 0;
+	record.fetchHits = 0;
+	if (((hits & 2) && !decodeFilterVarint(p, this->end, record.writeHits)) ||
+		((hits & 1) && !decodeFilterVarint(p, this->end, record.fetchHits))) {
+		return TRACE_FORMAT_ERROR;
+	}
+	this->lastBlock = record.block;
+	this->cursor = p;
+	return TRACE_OK;
+}
+
+#endif // FILTER_HPP
@@ -0,0 +1,37 @@
+#include "index.hpp"
+
+void SetIndex::initIndex(IndexKind indexKind, unsigned int bits) {
+	this->kind = indexKind;
+	this->indexBits = bits;
+	this->mask = ((uint64_t)1 << bits) - 1;
+	// the largest prime no larger than the number of sets, 1 for a single set
+	this->prime = this->mask + 1;
+	while (this->prime > 2) {
+		bool isPrime = true;
+		for (uint64_t divisor = 2; divisor * divisor <= this->prime && isPrime; divisor++) {
+			isPrime = this->prime % divisor != 0;
+		}
+		if (isPrime) {
+			break;
+		}
+		this->prime--;
+	}
+}
+
+/**********************************************************************************************/
+
+static const char* indexNames[] = {"mod", "xor", "prime", "skew"};
+
+bool parseIndexKind(const string& name, IndexKind& kind) {
+	for (int i = 0; i < (int)(sizeof(indexNames) / sizeof(indexNames[0])); i++) {
+		if (name == indexNames[i]) {
+			kind = (IndexKind)i;
+			return true;
+		}
+	}
+	return false;
+}
+
+const char* indexKindName(IndexKind kind) {
+	return indexNames[kind];
+}
@@ -0,0 +1,77 @@
+#ifndef INDEX_HPP
+#define INDEX_HPP
+
+#include <string>
+#include <stdint.h>
+
+using  namespace std;
+
+// Set index functions, picked per level with --l1-index and --l2-index. A block address (the
+// address without the offset bits) goes to
+//   mod   - its low index bits, the original model
+//   xor   - its low index bits XORed with every higher group of index bits, so power of two
+//           strides spread over the sets instead of aliasing into a few
+//   prime - the block modulo the largest prime no larger than the number of sets, the sets
+//           above it stay empty
+//   skew  - a different set in every way, a skewed associative cache (Seznec, ISCA 1993).
+//           Way w XORs the low bits with the xor fold of the higher ones rotated left by w, so
+//           blocks that meet in one way are spread in the others.
+// Only mod rebuilds a block from its tag and set. The others keep the whole block address as
+// the tag, which is what the back-invalidations need to find a victim in the other level.
+enum IndexKind {
+    INDEX_MODULO = 0,
+    INDEX_XOR = 1,
+    INDEX_PRIME = 2,
+    INDEX_SKEW = 3
+};
+
+// "mod", "xor", "prime" or "skew", returns false for anything else
+bool parseIndexKind(const string& name, IndexKind& kind);
+const char* indexKindName(IndexKind kind);
+
+// The index function of one level with 2^indexBits sets
+struct SetIndex {
+    IndexKind kind;
+    unsigned int indexBits;
+    uint64_t mask; // 2^indexBits - 1
+    uint64_t prime; // INDEX_PRIME only
+    void initIndex(IndexKind kind, unsigned int indexBits);
+    // way only matters for INDEX_SKEW
+    unsigned int set(uint64_t block, unsigned int way) const;
+    uint64_t tag(uint64_t block) const;
+    uint64_t block(uint64_t tag, unsigned int set) const;
+};
+
+/**********************************************************************************************/
+// SetIndex hot path
+
+inline unsigned int SetIndex::set(uint64_t block, unsigned int way) const {
+	if (this->kind == INDEX_MODULO) {
+		return (unsigned int)(block & this->mask);
+	}
+	if (this->kind == INDEX_PRIME) {
+		return (unsigned int)(block % this->prime);
+	}
+	if (this->indexBits == 0) {
+		return 0;
+	}
+	uint64_t fold = 0;
+	for (uint64_t high = block >> this->indexBits; high != 0; high >>= this->indexBits) {
+		fold ^= high & this->mask;
+	}
+	if (this->kind == INDEX_SKEW) {
+		unsigned int shift = way % this->indexBits;
+		fold = ((fold << shift) | (fold >> (this->indexBits - shift))) & this->mask;
+	}
+	return (unsigned int)((block ^ fold) & this->mask);
+}
+
+inline uint64_t SetIndex::tag(uint64_t block) const {
+	return this->kind == INDEX_MODULO ? block >> this->indexBits : block;
+}
+
+inline uint64_t SetIndex::block(uint64_t tag, unsigned int set) const {
+	return this->kind == INDEX_MODULO ? (tag << this->indexBits) | set : tag;
+}
+
+#endif // INDEX_HPP
@@ -0,0 +1,123 @@
+#ifndef INTERVAL_HPP
+#define INTERVAL_HPP
+
+#include <cstdio>
+#include <stdint.h>
+
+#include "cacheSim.hpp"
+
+// Interval statistics, to see program phases a whole run average hides. IntervalReporter
+// sits between a trace driver and a BasicCache and prints one JSON line per interval:
+//   {"interval":0,"firstAccess":0,"accesses":100000,"cycles":713245,
+//    "L1miss":0.051,"L2miss":0.402,"AccTimeAvg":7.132,"memReadBW":1.845,"memWriteBW":0.297}
+// An interval ends every intervalAccesses accesses, or once at least intervalCycles simulated
+// cycles passed since it started (an access is never split). The rates are those of the
+// interval alone, L2miss is 0 for an interval without L2 accesses. The memory bandwidths
+// are bytes per cycle of the interval (see the traffic counters of CacheStats).
+template <class Simulator>
+class IntervalReporter {
+private:
+    Simulator& cache;
+    uint64_t intervalAccesses, intervalCycles; // exactly one of them is non zero
+    uint64_t interval;
+    uint64_t accesses; // since the run started
+    uint64_t pending; // accesses of the current interval
+    uint64_t nextCycles; // cycle count that ends the current interval
+    CacheStats last; // counters when the current interval started
+    uint64_t getCycles();
+    void check();
+    void report();
+public:
+    IntervalReporter(Simulator& cache, uint64_t intervalAccesses, uint64_t intervalCycles);
+    void readFromCache(uint64_t address);
+    void writeToCache(uint64_t address);
+    void fetchFromCache(uint64_t address);
+    // report the last, partial interval
+    void finish();
+};
+
+/**********************************************************************************************/
+// IntervalReporter definitions
+
+template <class Simulator>
+IntervalReporter<Simulator>::IntervalReporter(Simulator& cache, uint64_t intervalAccesses,
+											  uint64_t intervalCycles) :
+		cache(cache), intervalAccesses(intervalAccesses), intervalCycles(intervalCycles),
+		interval(0), accesses(0), pending(0), nextCycles(intervalCycles) {
+	this->last = cache.getStats();
+}
+
+template <class Simulator>
+inline uint64_t IntervalReporter<Simulator>::getCycles() {
+	return this->cache.getTotalL1Cycles() + this->cache.getTotalL2Cycles() +
+		   this->cache.getTotalMemCycles();
+}
+
+template <class Simulator>
+inline void IntervalReporter<Simulator>::check() {
+	this->pending++;
+	if (this->intervalAccesses != 0 ? this->pending == this->intervalAccesses
+									: this->getCycles() >= this->nextCycles) {
+		this->report();
+		this->nextCycles = this->getCycles() + this->intervalCycles;
+	}
+}
+
+template <class Simulator>
+void IntervalReporter<Simulator>::report() {
+	CacheStats now = this->cache.getStats();
+	uint64_t L1Accesses = (now.L1Reads + now.L1Writes) - (this->last.L1Reads + this->last.L1Writes);
+	uint64_t L1Misses = (now.L1ReadMisses + now.L1WriteMisses) -
+						(this->last.L1ReadMisses + this->last.L1WriteMisses);
+	uint64_t L2Accesses = (now.L2Reads + now.L2Writes) - (this->last.L2Reads + this->last.L2Writes);
+	uint64_t L2Misses = (now.L2ReadMisses + now.L2WriteMisses) -
+						(this->last.L2ReadMisses + this->last.L2WriteMisses);
+	uint64_t cycles = (now.totalL1Cycles + now.totalL2Cycles + now.totalMemCycles) -
+					  (this->last.totalL1Cycles + this->last.totalL2Cycles + this->last.totalMemCycles);
+	uint64_t memReadBytes = now.memReadBytes - this->last.memReadBytes;
+	uint64_t memWriteBytes = now.memWriteBytes - this->last.memWriteBytes;
+	printf("{\"interval\":%llu,\"firstAccess\":%llu,\"accesses\":%llu,\"cycles\":%llu,"
+		   "\"L1miss\":%.03f,\"L2miss\":%.03f,\"AccTimeAvg\":%.03f,\"memReadBW\":%.03f,"
+		   "\"memWriteBW\":%.03f}\n",
+		   (unsigned long long)this->interval, (unsigned long long)(this->accesses - this->pending),
+		   (unsigned long long)this->pending, (unsigned long long)cycles,
+		   L1Accesses ? (double)L1Misses / L1Accesses : 0.0,
+		   L2Accesses ? (double)L2Misses / L2Accesses : 0.0,
+		   L1Accesses ? (double)cycles / L1Accesses : 0.0,
+		   cycles ? (double)memReadBytes / cycles : 0.0, cycles ? (double)memWriteBytes / cycles : 0.0);
+	// a live trace is watched as it runs
+	fflush(stdout);
+	this->last = now;
+	this->interval++;
+	this->pending = 0;
+}
+
+template <class Simulator>
+void IntervalReporter<Simulator>::readFromCache(uint64_t address) {
+	this->cache.readFromCache(address);
+	this->accesses++;
+	this->check();
+}
+
+template <class Simulator>
+void IntervalReporter<Simulator>::writeToCache(uint64_t address) {
+	this->cache.writeToCache(address);
+	this->accesses++;
+	this->check();
+}
+
+template <class Simulator>
+void IntervalReporter<Simulator>::fetchFromCache(uint64_t address) {
+	this->cache.fetchFromCache(address);
+	this->accesses++;
+	this->check();
+}
+
+template <class Simulator>
+void IntervalReporter<Simulator>::finish() {
+	if (this->pending > 0) {
+		this->report();
+	}
+}
+
+#endif // INTERVAL_HPP
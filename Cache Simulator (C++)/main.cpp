@@ -0,0 +1,597 @@
+#include "cacheSim.hpp"
+#include "trace.hpp"
+#include "stackDistance.hpp"
+#include "sweep.hpp"
+#include "stream.hpp"
+#include "timing.hpp"
+#include "filter.hpp"
+#include "simulator.hpp"
+
+#include <cstring>
+
+/**********************************************************************************************/
+
+// Stack distance mode:
+// cacheSim --stack-dist <trace> <out.csv> --bsize <B> --max-size <S> [--min-size <S>] [--max-assoc <A>]
+static int stackDistanceMain(int argc, char **argv) {
+	if (argc < 8) {
+		cerr << "Not enough arguments" << endl;
+		return 0;
+	}
+	int BSize = -1, minSize = -1, maxSize = -1, maxAssoc = -1;
+	for (int i = 4; i + 1 < argc; i += 2) {
+		string s(argv[i]);
+		if (s == "--bsize") {
+			BSize = atoi(argv[i + 1]);
+		} else if (s == "--min-size") {
+			minSize = atoi(argv[i + 1]);
+		} else if (s == "--max-size") {
+			maxSize = atoi(argv[i + 1]);
+		} else if (s == "--max-assoc") {
+			maxAssoc = atoi(argv[i + 1]);
+		} else {
+			cerr << "Error in arguments" << endl;
+			return 0;
+		}
+	}
+	if (BSize < 0 || maxSize < BSize || (argc - 4) % 2 != 0) {
+		cerr << "Error in arguments" << endl;
+		return 0;
+	}
+	if (minSize < BSize) {
+		minSize = BSize;
+	}
+	if (maxAssoc < 0 || maxAssoc > maxSize - BSize) {
+		maxAssoc = maxSize - BSize; // up to fully associative
+	}
+
+	StackDistanceProfiler profiler(BSize, minSize, maxSize, maxAssoc);
+	if (!simulateTraceInput(argv[2], profiler)) {
+		return 0;
+	}
+	if (!profiler.writeCSV(argv[3])) {
+		cerr << "Cannot create " << argv[3] << endl;
+	}
+	return 0;
+}
+
+// Parallel design space sweep, every cache parameter takes a comma separated list:
+// cacheSim --sweep <trace> <out.csv> [--threads <N>] [--repl <lru,plru,..>] --mem-cyc <a,b,..> --bsize <..> ...
+static int sweepMain(int argc, char **argv) {
+	// option names in Cache constructor order
+	static const char* names[9] = {"--mem-cyc", "--bsize", "--l1-size", "--l2-size", "--l1-assoc",
+								   "--l2-assoc", "--l1-cyc", "--l2-cyc", "--wr-alloc"};
+	vector<unsigned int> lists[9];
+	vector<ReplacementPolicyKind> policies;
+	unsigned int numThreads = 0;
+	if ((argc - 4) % 2 != 0) {
+		cerr << "Error in arguments" << endl;
+		return 0;
+	}
+	for (int i = 4; i + 1 < argc; i += 2) {
+		string s(argv[i]);
+		if (s == "--threads") {
+			numThreads = atoi(argv[i + 1]);
+			continue;
+		}
+		if (s == "--repl") {
+			stringstream names(argv[i + 1]);
+			string name;
+			ReplacementPolicyKind kind;
+			while (getline(names, name, ',')) {
+				if (!parseReplacementPolicy(name, kind)) {
+					cerr << "Error in arguments" << endl;
+					return 0;
+				}
+				policies.push_back(kind);
+			}
+			continue;
+		}
+		int param = 0;
+		while (param < 9 && s != names[param]) {
+			param++;
+		}
+		if (param == 9) {
+			cerr << "Error in arguments" << endl;
+			return 0;
+		}
+		stringstream values(argv[i + 1]);
+		string value;
+		while (getline(values, value, ',')) {
+			lists[param].push_back(atoi(value.c_str()));
+		}
+	}
+	for (int param = 0; param < 9; param++) {
+		if (lists[param].empty()) {
+			cerr << "Not enough arguments" << endl;
+			return 0;
+		}
+	}
+
+	if (policies.empty()) {
+		policies.push_back(REPLACEMENT_LRU);
+	}
+	Sweep sweep;
+	unsigned int skipped = sweep.addGrid(lists, policies);
+	if (skipped > 0) {
+		cerr << "Skipped " << skipped << " configurations with no sets" << endl;
+	}
+	if (!isStreamPath(argv[2]) && isFilteredTrace(argv[2])) {
+		// L2 sweeps of an L1-filtered trace, see filter.hpp
+		FilteredTraceReader trace(argv[2]);
+		if (!trace.isOpen()) {
+			cerr << "File not found" << endl;
+			return 0;
+		}
+		skipped = sweep.keepReplayable(trace);
+		if (skipped > 0) {
+			cerr << "Skipped " << skipped << " configurations with another L1 than the filtered trace" << endl;
+		}
+		sweep.run(trace, numThreads);
+	} else {
+		TraceImage trace;
+		if (!trace.load(argv[2])) {
+			return 0;
+		}
+		sweep.run(trace, numThreads);
+	}
+	if (!sweep.writeCSV(argv[3])) {
+		cerr << "Cannot create " << argv[3] << endl;
+	}
+	return 0;
+}
+
+// L1-filtered trace recording, see filter.hpp:
+// cacheSim --filter <trace> <out> --bsize <B> --l1-size <S> --l1-assoc <A> --l1-cyc <C> --wr-alloc <W>
+//          [--repl <policy>] [--l1-index <kind>] [--l1i-size <S> --l1i-assoc <A> --l1i-cyc <C>]
+static int filterMain(int argc, char **argv) {
+	if (argc < 14) {
+		cerr << "Not enough arguments" << endl;
+		return 0;
+	}
+	CacheConfig config = defaultCacheConfig();
+	int given = 0; // bit per required option
+	for (int i = 4; i + 1 < argc; i += 2) {
+		string s(argv[i]);
+		if (s == "--bsize") {
+			config.BSize = atoi(argv[i + 1]);
+			given |= 1;
+		} else if (s == "--l1-size") {
+			config.L1Size = atoi(argv[i + 1]);
+			given |= 2;
+		} else if (s == "--l1-assoc") {
+			config.L1Assoc = atoi(argv[i + 1]);
+			given |= 4;
+		} else if (s == "--l1-cyc") {
+			config.L1Cyc = atoi(argv[i + 1]);
+			given |= 8;
+		} else if (s == "--wr-alloc") {
+			config.WrAlloc = atoi(argv[i + 1]);
+			given |= 16;
+		} else if (s == "--l1i-size") {
+			config.L1ISize = atoi(argv[i + 1]);
+		} else if (s == "--l1i-assoc") {
+			config.L1IAssoc = atoi(argv[i + 1]);
+		} else if (s == "--l1i-cyc") {
+			config.L1ICyc = atoi(argv[i + 1]);
+		} else if (s == "--repl") {
+			if (!parseReplacementPolicy(argv[i + 1], config.replacement)) {
+				cerr << "Error in arguments" << endl;
+				return 0;
+			}
+		} else if (s == "--l1-index") {
+			if (!parseIndexKind(argv[i + 1], config.L1Indexing)) {
+				cerr << "Error in arguments" << endl;
+				return 0;
+			}
+		} else {
+			cerr << "Error in arguments" << endl;
+			return 0;
+		}
+	}
+	// the L1 checks of CacheSimulator::isValidConfig, and no skewed L1
+	if (given != 31 || (argc - 4) % 2 != 0 || config.BSize >= FULL_TAG_SIZE ||
+		config.L1Size >= FULL_TAG_SIZE || config.L1Size < config.BSize + config.L1Assoc ||
+		config.WrAlloc > WRITE_ALLOCATE || config.L1Indexing == INDEX_SKEW ||
+		(config.L1ISize != L1I_OFF &&
+		 (config.L1ISize >= FULL_TAG_SIZE || config.L1ISize < config.BSize + config.L1IAssoc))) {
+		cerr << "Error in arguments" << endl;
+		return 0;
+	}
+
+	uint64_t accesses = 0, records = 0;
+	if (!recordFilteredTrace(argv[2], argv[3], config, accesses, records)) {
+		return 0;
+	}
+	printf("accesses=%llu records=%llu reduction=%.01f\n", (unsigned long long)accesses,
+		   (unsigned long long)records, records ? (double)accesses / records : 0.0);
+	return 0;
+}
+
+int main(int argc, char **argv) {
+
+	// Text to binary trace conversion: cacheSim --convert <trace.txt> <trace.bin>
+	if (argc == 4 && string(argv[1]) == "--convert") {
+		return convertTextTrace(argv[2], argv[3]) ? 0 : 1;
+	}
+	if (argc > 1 && string(argv[1]) == "--stack-dist") {
+		return stackDistanceMain(argc, argv);
+	}
+	if (argc > 1 && string(argv[1]) == "--sweep") {
+		return sweepMain(argc, argv);
+	}
+	if (argc > 1 && string(argv[1]) == "--filter") {
+		return filterMain(argc, argv);
+	}
+
+	if (argc < 19) {
+		cerr << "Not enough arguments" << endl;
+		return 0;
+	}
+
+	// Get input arguments
+
+	// File
+	// Assuming it is the first argument, either a text trace or a binary one (see trace.hpp).
+	// "-" reads stdin, and FIFOs and pipes are streamed as they are written (see stream.hpp).
+	char* fileString = argv[1];
+
+	// every size, associativity and latency is required, the optional models are off unless
+	// their options turn them on, see defaultCacheConfig
+	CacheConfig config = defaultCacheConfig();
+	// --shards, --interval, --interval-cycles, --cores, --sample <period,warmup,detail>,
+	// --fast-forward, --mshr <L1,L2[,memory]>, --issue-cycles, --classify, --restore,
+	// --checkpoint and --checkpoint-at, see simulator.hpp
+	RunModes modes = defaultRunModes();
+	bool traffic = false; // --traffic 1 prints the traffic counters
+	// --dram <channels,ranks,banks>, --dram-timing <tRCD,tCAS,tRP>, --dram-page, --dram-map and
+	// --dram-row (log2 bytes), see dram.hpp. 8KB rows, 8 banks and 40 cycle timings by default
+	config.dram.ranks = 1;
+	config.dram.banks = 8;
+	config.dram.rowSize = 13;
+	config.dram.tRCD = config.dram.tCAS = config.dram.tRP = 40;
+	config.dram.page = DRAM_OPEN_PAGE;
+	config.dram.mapping = DRAM_MAP_PAGE;
+	// --tlb <L1entries,L1ways,L2entries,L2ways>, --tlb-cyc <L2TlbCyc,walkCyc>, --pwc <entries>
+	// and --page 4k|2m, see tlb.hpp. A 7 cycle L2 TLB and 20 cycle page table reads by default
+	config.tlb.L2TlbCyc = 7;
+	config.tlb.walkCyc = 20;
+	config.tlb.pageSize = TLB_PAGE_4K;
+	// --write-buffer (see cacheSim.hpp), --l1-prefetch, --l2-prefetch (prefetch.hpp), --victim,
+	// --victim-cyc, --l1-index, --l2-index (index.hpp), --repl and --l1i-size, --l1i-assoc,
+	// --l1i-cyc, a split L1 for the "i" accesses (cacheSim.hpp)
+	bool checkpointAtGiven = false;
+
+	for (int i = 2; i < argc; i += 2) {
+		string s(argv[i]);
+		if (i + 1 == argc) {
+			cerr << "Error in arguments" << endl;
+			return 0;
+		} else if (s == "--mem-cyc") {
+			config.MemCyc = atoi(argv[i + 1]);
+		} else if (s == "--bsize") {
+			config.BSize = atoi(argv[i + 1]);
+		} else if (s == "--l1-size") {
+			config.L1Size = atoi(argv[i + 1]);
+		} else if (s == "--l2-size") {
+			config.L2Size = atoi(argv[i + 1]);
+		} else if (s == "--l1-cyc") {
+			config.L1Cyc = atoi(argv[i + 1]);
+		} else if (s == "--l1i-size") {
+			config.L1ISize = atoi(argv[i + 1]);
+		} else if (s == "--l1i-assoc") {
+			config.L1IAssoc = atoi(argv[i + 1]);
+		} else if (s == "--l1i-cyc") {
+			config.L1ICyc = atoi(argv[i + 1]);
+		} else if (s == "--l2-cyc") {
+			config.L2Cyc = atoi(argv[i + 1]);
+		} else if (s == "--l1-assoc") {
+			config.L1Assoc = atoi(argv[i + 1]);
+		} else if (s == "--l2-assoc") {
+			config.L2Assoc = atoi(argv[i + 1]);
+		} else if (s == "--wr-alloc") {
+			config.WrAlloc = atoi(argv[i + 1]);
+		} else if (s == "--shards") {
+			modes.numShards = atoi(argv[i + 1]);
+		} else if (s == "--cores") {
+			modes.numCores = atoi(argv[i + 1]);
+			if (modes.numCores == 0) {
+				cerr << "Error in arguments" << endl;
+				return 0;
+			}
+		} else if (s == "--sample") {
+			unsigned long long period = 0, warmup = 0, detail = 0;
+			if (sscanf(argv[i + 1], "%llu,%llu,%llu", &period, &warmup, &detail) != 3 ||
+				detail == 0 || warmup + detail > period) {
+				cerr << "Error in arguments" << endl;
+				return 0;
+			}
+			modes.sampling.period = period;
+			modes.sampling.warmup = warmup;
+			modes.sampling.detail = detail;
+		} else if (s == "--fast-forward") {
+			string mode(argv[i + 1]);
+			if (mode != "skip" && mode != "warm") {
+				cerr << "Error in arguments" << endl;
+				return 0;
+			}
+			modes.sampling.warmFastForward = mode == "warm";
+		} else if (s == "--interval") {
+			modes.intervalAccesses = strtoull(argv[i + 1], NULL, 10);
+		} else if (s == "--interval-cycles") {
+			modes.intervalCycles = strtoull(argv[i + 1], NULL, 10);
+		} else if (s == "--mshr") {
+			unsigned int L1MSHRs = 0, L2MSHRs = 0, memChannels = 0;
+			int fields = sscanf(argv[i + 1], "%u,%u,%u", &L1MSHRs, &L2MSHRs, &memChannels);
+			if (fields == 2) {
+				memChannels = L2MSHRs;
+			}
+			if (fields < 2 || L1MSHRs == 0 || L1MSHRs > MAX_MSHRS || L2MSHRs == 0 ||
+				L2MSHRs > MAX_MSHRS || memChannels == 0 || memChannels > MAX_MSHRS) {
+				cerr << "Error in arguments" << endl;
+				return 0;
+			}
+			modes.timing.L1MSHRs = L1MSHRs;
+			modes.timing.L2MSHRs = L2MSHRs;
+			modes.timing.memChannels = memChannels;
+		} else if (s == "--issue-cycles") {
+			modes.timing.issueCycles = atoi(argv[i + 1]);
+		} else if (s == "--write-buffer") {
+			config.writeBufferDepth = atoi(argv[i + 1]);
+			if (config.writeBufferDepth < 0 || config.writeBufferDepth > MAX_WRITE_BUFFER) {
+				cerr << "Error in arguments" << endl;
+				return 0;
+			}
+			traffic = true;
+		} else if (s == "--traffic") {
+			traffic = atoi(argv[i + 1]) != 0;
+		} else if (s == "--classify") {
+			modes.classify = atoi(argv[i + 1]) != 0;
+		} else if (s == "--l1-prefetch" || s == "--l2-prefetch") {
+			PrefetchConfig& prefetch = s == "--l1-prefetch" ? config.L1Prefetch : config.L2Prefetch;
+			if (!parsePrefetchConfig(argv[i + 1], prefetch)) {
+				cerr << "Error in arguments" << endl;
+				return 0;
+			}
+		} else if (s == "--l1-index" || s == "--l2-index") {
+			if (!parseIndexKind(argv[i + 1], s == "--l1-index" ? config.L1Indexing : config.L2Indexing)) {
+				cerr << "Error in arguments" << endl;
+				return 0;
+			}
+		} else if (s == "--dram") {
+			DramConfig& dram = config.dram;
+			if (sscanf(argv[i + 1], "%u,%u,%u", &dram.channels, &dram.ranks, &dram.banks) != 3 ||
+				dram.channels == DRAM_OFF) {
+				cerr << "Error in arguments" << endl;
+				return 0;
+			}
+		} else if (s == "--dram-timing") {
+			DramConfig& dram = config.dram;
+			if (sscanf(argv[i + 1], "%u,%u,%u", &dram.tRCD, &dram.tCAS, &dram.tRP) != 3) {
+				cerr << "Error in arguments" << endl;
+				return 0;
+			}
+		} else if (s == "--dram-page") {
+			if (!parseDramPagePolicy(argv[i + 1], config.dram.page)) {
+				cerr << "Error in arguments" << endl;
+				return 0;
+			}
+		} else if (s == "--dram-map") {
+			if (!parseDramMapping(argv[i + 1], config.dram.mapping)) {
+				cerr << "Error in arguments" << endl;
+				return 0;
+			}
+		} else if (s == "--dram-row") {
+			config.dram.rowSize = atoi(argv[i + 1]);
+		} else if (s == "--tlb") {
+			TlbConfig& tlb = config.tlb;
+			if (sscanf(argv[i + 1], "%u,%u,%u,%u", &tlb.L1Entries, &tlb.L1Ways, &tlb.L2Entries,
+					   &tlb.L2Ways) != 4 || tlb.L1Entries == TLB_OFF) {
+				cerr << "Error in arguments" << endl;
+				return 0;
+			}
+		} else if (s == "--tlb-cyc") {
+			if (sscanf(argv[i + 1], "%u,%u", &config.tlb.L2TlbCyc, &config.tlb.walkCyc) != 2) {
+				cerr << "Error in arguments" << endl;
+				return 0;
+			}
+		} else if (s == "--pwc") {
+			config.tlb.pwcEntries = atoi(argv[i + 1]);
+		} else if (s == "--page") {
+			if (!parseTlbPageSize(argv[i + 1], config.tlb.pageSize)) {
+				cerr << "Error in arguments" << endl;
+				return 0;
+			}
+		} else if (s == "--victim") {
+			config.victimEntries = atoi(argv[i + 1]);
+		} else if (s == "--victim-cyc") {
+			config.VictimCyc = atoi(argv[i + 1]);
+		} else if (s == "--checkpoint") {
+			modes.checkpointPath = argv[i + 1];
+		} else if (s == "--checkpoint-at") {
+			modes.checkpointAt = strtoull(argv[i + 1], NULL, 10);
+			checkpointAtGiven = true;
+		} else if (s == "--restore") {
+			modes.restorePath = argv[i + 1];
+		} else if (s == "--repl") {
+			if (!parseReplacementPolicy(argv[i + 1], config.replacement)) {
+				cerr << "Error in arguments" << endl;
+				return 0;
+			}
+		} else {
+			cerr << "Error in arguments" << endl;
+			return 0;
+		}
+	}
+
+	if (!CacheSimulator::isValidConfig(config)) {
+		cerr << "Error in arguments" << endl;
+		return 0;
+	}
+	// the multi core model has no traffic counters
+	if (!isValidRun(fileString, config, modes) || (traffic && modes.numCores != 0) ||
+		(modes.checkpointPath != NULL) != checkpointAtGiven) {
+		cerr << "Error in arguments" << endl;
+		return 0;
+	}
+	RunResults results;
+	if (!simulateRun(fileString, config, modes, results)) {
+		return 0;
+	}
+	const CacheStats& stats = results.stats;
+	if (modes.sampling.period != 0) {
+		// the estimates with their confidence intervals before the usual summary, see sampling.hpp.
+		// They are ratios of the sample totals, which the summary prints again
+		const SampledStats& sampled = results.sampled;
+		printf("samples=%zu measured=%llu accesses=%llu\n", sampled.samples.size(),
+			   (unsigned long long)(stats.L1Reads + stats.L1Writes), (unsigned long long)sampled.accesses);
+		printf("L1miss=%.03f+-%.03f L2miss=%.03f+-%.03f AccTimeAvg=%.03f+-%.03f\n",
+			   sampled.L1MissRate.value, sampled.L1MissRate.error, sampled.L2MissRate.value,
+			   sampled.L2MissRate.error, sampled.avgAccTime.value, sampled.avgAccTime.error);
+	} else if (modes.numCores != 0) {
+		// per core lines and the coherence counters before the usual summary
+		const MultiCoreStats& multiCore = results.multiCore;
+		for (unsigned int core = 0; core < modes.numCores; core++) {
+			const CoreStats& c = multiCore.cores[core];
+			double accesses = (double)c.reads + c.writes;
+			printf("core=%u L1miss=%.03f AccTimeAvg=%.03f coherenceMisses=%llu invalidations=%llu "
+				   "upgrades=%llu\n", core, accesses ? (c.readMisses + c.writeMisses) / accesses : 0.0,
+				   accesses ? c.cycles / accesses : 0.0, (unsigned long long)c.coherenceMisses,
+				   (unsigned long long)c.invalidations, (unsigned long long)c.upgrades);
+		}
+		printf("invalidations=%llu interventions=%llu backInvalidations=%llu\n",
+			   (unsigned long long)multiCore.invalidations, (unsigned long long)multiCore.interventions,
+			   (unsigned long long)multiCore.backInvalidations);
+	} else if (modes.timing.L1MSHRs != 0) {
+		// latencies of the non-blocking model before the usual (serial) summary
+		const TimingStats& timed = results.timing;
+		printf("cycles=%llu latencyAvg=%.03f latencyP50=%llu latencyP99=%llu merged=%llu "
+			   "stallCycles=%llu\n", (unsigned long long)timed.cycles,
+			   timed.accesses ? (double)timed.totalLatency / timed.accesses : 0.0,
+			   (unsigned long long)timed.latencyP50, (unsigned long long)timed.latencyP99,
+			   (unsigned long long)timed.merged, (unsigned long long)timed.stallCycles);
+		printf("L1MSHROccupancy=%.03f L2MSHROccupancy=%.03f memOccupancy=%.03f\n",
+			   timed.L1MSHROccupancy, timed.L2MSHROccupancy, timed.memOccupancy);
+	} else if (modes.classify) {
+		// compulsory, capacity and conflict misses of both levels before the usual summary
+		const MissClasses* levels[2] = {&results.classes.L1, &results.classes.L2};
+		for (int level = 0; level < 2; level++) {
+			const MissClasses& c = *levels[level];
+			printf("L%dcompulsory=%llu L%dcapacity=%llu L%dconflict=%llu L%dconflictSets=", level + 1,
+				   (unsigned long long)c.compulsory, level + 1, (unsigned long long)c.capacity,
+				   level + 1, (unsigned long long)c.conflict, level + 1);
+			for (size_t i = 0; i < c.topSets.size(); i++) {
+				printf("%s%u:%llu", i ? "," : "", c.topSets[i].first,
+					   (unsigned long long)c.topSets[i].second);
+			}
+			printf("\n");
+		}
+	}
+
+	if (traffic) {
+		double cycles = (double)(stats.totalL1Cycles + stats.totalL2Cycles + stats.totalMemCycles);
+		printf("L1WriteBacks=%llu L2WriteBacks=%llu L2ReadBytes=%llu L2WriteBytes=%llu "
+			   "memReadBytes=%llu memWriteBytes=%llu memReadBW=%.03f memWriteBW=%.03f "
+			   "writeBufferStallCycles=%llu\n", (unsigned long long)stats.L1WriteBacks,
+			   (unsigned long long)stats.L2WriteBacks, (unsigned long long)stats.L2ReadBytes,
+			   (unsigned long long)stats.L2WriteBytes, (unsigned long long)stats.memReadBytes,
+			   (unsigned long long)stats.memWriteBytes, cycles ? stats.memReadBytes / cycles : 0.0,
+			   cycles ? stats.memWriteBytes / cycles : 0.0,
+			   (unsigned long long)stats.writeBufferStallCycles);
+	}
+
+	bool victim = config.victimEntries != VICTIM_OFF;
+	bool dramModel = config.dram.channels != DRAM_OFF;
+	bool translation = config.tlb.L1Entries != TLB_OFF;
+	bool split = config.L1ISize != L1I_OFF;
+
+	// coverage is the share of the misses the prefetcher would have had that it removed
+	const PrefetchStats* levels[2] = {&stats.L1Prefetch, &stats.L2Prefetch};
+	uint64_t levelMisses[2] = {stats.L1ReadMisses + stats.L1WriteMisses - (split ? stats.L1FetchMisses : 0),
+							   stats.L2ReadMisses + stats.L2WriteMisses};
+	PrefetchKind kinds[2] = {config.L1Prefetch.kind, config.L2Prefetch.kind};
+	for (int level = 0; level < 2; level++) {
+		if (kinds[level] == PREFETCH_NONE) {
+			continue;
+		}
+		const PrefetchStats& p = *levels[level];
+		printf("L%dprefetch issued=%llu useful=%llu late=%llu accuracy=%.03f coverage=%.03f "
+			   "lateness=%.03f evictedUsed=%llu evictedUnused=%llu\n", level + 1,
+			   (unsigned long long)p.issued, (unsigned long long)p.useful, (unsigned long long)p.late,
+			   p.issued ? (double)p.useful / p.issued : 0.0,
+			   p.useful + levelMisses[level] ? (double)p.useful / (p.useful + levelMisses[level]) : 0.0,
+			   p.useful ? (double)p.late / p.useful : 0.0, (unsigned long long)p.evictedUsed,
+			   (unsigned long long)p.evictedUnused);
+	}
+
+	// the share of the L1 misses the victim cache served
+	if (victim) {
+		uint64_t probes = stats.victimHits + stats.victimMisses;
+		printf("victimHits=%llu victimMisses=%llu victimHitRate=%.03f victimCycles=%llu\n",
+			   (unsigned long long)stats.victimHits, (unsigned long long)stats.victimMisses,
+			   probes ? (double)stats.victimHits / probes : 0.0, (unsigned long long)stats.victimCycles);
+	}
+
+	// row buffer outcomes of every DRAM access, then of every bank
+	if (dramModel) {
+		const DramStats& d = stats.dram;
+		uint64_t accesses = d.reads + d.writes;
+		printf("dramReads=%llu dramWrites=%llu rowHits=%llu rowMisses=%llu rowConflicts=%llu "
+			   "rowHitRate=%.03f dramLatencyAvg=%.03f dramQueueCycles=%llu\n",
+			   (unsigned long long)d.reads, (unsigned long long)d.writes, (unsigned long long)d.rowHits,
+			   (unsigned long long)d.rowMisses, (unsigned long long)d.rowConflicts,
+			   accesses ? (double)d.rowHits / accesses : 0.0,
+			   accesses ? (double)d.latencyCycles / accesses : 0.0, (unsigned long long)d.queueCycles);
+		unsigned int bank = 0;
+		for (unsigned int channel = 0; channel < config.dram.channels; channel++) {
+			for (unsigned int rank = 0; rank < config.dram.ranks; rank++) {
+				for (unsigned int i = 0; i < config.dram.banks; i++, bank++) {
+					const DramBankStats& b = d.banks[bank];
+					printf("bank=%u.%u.%u accesses=%llu rowHits=%llu rowConflicts=%llu rowHitRate=%.03f\n",
+						   channel, rank, i, (unsigned long long)b.accesses, (unsigned long long)b.rowHits,
+						   (unsigned long long)b.rowConflicts, b.accesses ? (double)b.rowHits / b.accesses : 0.0);
+				}
+			}
+		}
+	}
+
+	// instruction fetches apart from the data reads and writes, at L1 (L1I when split) and L2
+	if (split || stats.L1Fetches != 0) {
+		uint64_t reads = stats.L1Reads - stats.L1Fetches, readMisses = stats.L1ReadMisses - stats.L1FetchMisses;
+		uint64_t data = reads + stats.L1Writes;
+		printf("L1Fetches=%llu L1FetchMisses=%llu L1Imiss=%.03f L1Reads=%llu L1ReadMisses=%llu "
+			   "L1Writes=%llu L1WriteMisses=%llu L1Dmiss=%.03f L2Fetches=%llu L2FetchMisses=%llu\n",
+			   (unsigned long long)stats.L1Fetches, (unsigned long long)stats.L1FetchMisses,
+			   stats.L1Fetches ? (double)stats.L1FetchMisses / stats.L1Fetches : 0.0,
+			   (unsigned long long)reads, (unsigned long long)readMisses,
+			   (unsigned long long)stats.L1Writes, (unsigned long long)stats.L1WriteMisses,
+			   data ? (double)(readMisses + stats.L1WriteMisses) / data : 0.0,
+			   (unsigned long long)stats.L2Fetches, (unsigned long long)stats.L2FetchMisses);
+	}
+
+	// TLB misses per data access (fetches are not translated) and L2 TLB misses (page walks)
+	// per L1 TLB miss
+	if (translation) {
+		const TlbStats& t = stats.tlb;
+		uint64_t accesses = stats.L1Reads - stats.L1Fetches + stats.L1Writes;
+		printf("tlbL1Misses=%llu tlbL2Misses=%llu tlbL1MissRate=%.03f tlbL2MissRate=%.03f "
+			   "walkReads=%llu pwcHits=%llu tlbCycles=%llu\n",
+			   (unsigned long long)t.L1Misses, (unsigned long long)t.L2Misses,
+			   accesses ? (double)t.L1Misses / accesses : 0.0,
+			   t.L1Misses ? (double)t.L2Misses / t.L1Misses : 0.0, (unsigned long long)t.walkReads,
+			   (unsigned long long)t.pwcHits, (unsigned long long)t.cycles);
+	}
+
+	// Calculate L1MissRate, L2MissRate, avgAccTime
+	double L1MissRate = (double)(stats.L1ReadMisses + stats.L1WriteMisses) / 
+						(stats.L1Reads + stats.L1Writes);
+	double L2MissRate = (double)(stats.L2ReadMisses + stats.L2WriteMisses) / 
+						(stats.L2Reads + stats.L2Writes);
+	double avgAccTime = (double)(stats.totalL1Cycles + stats.totalL2Cycles + stats.totalMemCycles) / 
+						(stats.L1Reads + stats.L1Writes);
+
+	printf("L1miss=%.03f ", L1MissRate);
+	printf("L2miss=%.03f ", L2MissRate);
+	printf("AccTimeAvg=%.03f\n", avgAccTime);
+	return 0;
+}
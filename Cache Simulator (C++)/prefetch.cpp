@@ -0,0 +1,175 @@
+#include "prefetch.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+/**********************************************************************************************/
+// PrefetchStats definitions
+PrefetchStats& PrefetchStats::operator+=(const PrefetchStats& other) {
+	this->issued += other.issued;
+	this->useful += other.useful;
+	this->late += other.late;
+	this->lateCycles += other.lateCycles;
+	this->evictedUsed += other.evictedUsed;
+	this->evictedUnused += other.evictedUnused;
+	return *this;
+}
+
+PrefetchStats& PrefetchStats::operator-=(const PrefetchStats& other) {
+	this->issued -= other.issued;
+	this->useful -= other.useful;
+	this->late -= other.late;
+	this->lateCycles -= other.lateCycles;
+	this->evictedUsed -= other.evictedUsed;
+	this->evictedUnused -= other.evictedUnused;
+	return *this;
+}
+
+/**********************************************************************************************/
+// Prefetcher definitions
+Prefetcher::Prefetcher() : regionShift(0), clock(0) {
+	this->config.kind = PREFETCH_NONE;
+	this->config.degree = 0;
+	memset(this->strides, 0, sizeof(this->strides));
+	memset(this->streams, 0, sizeof(this->streams));
+}
+
+void Prefetcher::initPrefetcher(const PrefetchConfig& config, unsigned int blockBits) {
+	this->config = config;
+	this->regionShift = blockBits < STRIDE_REGION_BITS ? STRIDE_REGION_BITS - blockBits : 0;
+}
+
+PrefetchKind Prefetcher::getKind() {
+	return this->config.kind;
+}
+
+unsigned int Prefetcher::train(uint64_t block, bool miss, bool prefetchHit, uint64_t* blocks) {
+	if (this->config.kind == PREFETCH_NEXT_LINE) {
+		if (!miss && !prefetchHit) {
+			return 0;
+		}
+		for (unsigned int i = 0; i < this->config.degree; i++) {
+			blocks[i] = block + i + 1;
+		}
+		return this->config.degree;
+	}
+	// stride, a direct mapped table of regions
+	uint64_t region = block >> this->regionShift;
+	StrideEntry& entry = this->strides[region % STRIDE_TABLE_SIZE];
+	if (!entry.valid || entry.region != region) {
+		StrideEntry fresh = {region, block, 0, 0, 1};
+		entry = fresh;
+		return 0;
+	}
+	int64_t stride = (int64_t)(block - entry.lastBlock);
+	if (stride == 0) {
+		return 0;
+	}
+	if (stride == entry.stride) {
+		if (entry.confidence < STRIDE_CONFIDENCE) {
+			entry.confidence++;
+		}
+	} else {
+		entry.stride = stride;
+		entry.confidence = 0;
+	}
+	entry.lastBlock = block;
+	if (entry.confidence < STRIDE_CONFIDENCE) {
+		return 0;
+	}
+	for (unsigned int i = 0; i < this->config.degree; i++) {
+		blocks[i] = block + (uint64_t)(stride * (int64_t)(i + 1));
+	}
+	return this->config.degree;
+}
+
+int Prefetcher::findStream(uint64_t block) {
+	for (int buffer = 0; buffer < STREAM_BUFFERS; buffer++) {
+		StreamBuffer& stream = this->streams[buffer];
+		if (stream.count > 0 && stream.blocks[stream.head] == block) {
+			stream.lastUse = ++this->clock;
+			return buffer;
+		}
+	}
+	return -1;
+}
+
+uint64_t Prefetcher::popStream(int buffer) {
+	StreamBuffer& stream = this->streams[buffer];
+	uint64_t ready = stream.ready[stream.head];
+	stream.head = (stream.head + 1) % this->config.degree;
+	stream.count--;
+	return ready;
+}
+
+int Prefetcher::restartStream(uint64_t block, unsigned int& dropped) {
+	int oldest = 0;
+	for (int buffer = 1; buffer < STREAM_BUFFERS; buffer++) {
+		if (this->streams[buffer].lastUse < this->streams[oldest].lastUse) {
+			oldest = buffer;
+		}
+	}
+	StreamBuffer& stream = this->streams[oldest];
+	dropped = stream.count;
+	stream.head = 0;
+	stream.count = 0;
+	stream.nextBlock = block + 1;
+	stream.lastUse = ++this->clock;
+	return oldest;
+}
+
+bool Prefetcher::streamFull(int buffer) {
+	return this->streams[buffer].count == this->config.degree;
+}
+
+uint64_t Prefetcher::nextStreamBlock(int buffer) {
+	return this->streams[buffer].nextBlock;
+}
+
+void Prefetcher::pushStream(int buffer, uint64_t ready) {
+	StreamBuffer& stream = this->streams[buffer];
+	unsigned int tail = (stream.head + stream.count) % this->config.degree;
+	stream.blocks[tail] = stream.nextBlock++;
+	stream.ready[tail] = ready;
+	stream.count++;
+}
+
+void Prefetcher::saveState(CheckpointWriter& checkpoint) {
+	checkpoint.write(this->strides, sizeof(this->strides));
+	checkpoint.write(this->streams, sizeof(this->streams));
+	checkpoint.writeArray(&this->clock, 1);
+}
+
+bool Prefetcher::restoreState(CheckpointReader& checkpoint) {
+	return checkpoint.read(this->strides, sizeof(this->strides)) &&
+		   checkpoint.read(this->streams, sizeof(this->streams)) &&
+		   checkpoint.readArray(&this->clock, 1);
+}
+
+/**********************************************************************************************/
+
+static const char* prefetchNames[] = {"none", "next", "stride", "stream"};
+
+bool parsePrefetchConfig(const string& text, PrefetchConfig& config) {
+	string name = text.substr(0, text.find(':'));
+	for (int i = 0; i < (int)(sizeof(prefetchNames) / sizeof(prefetchNames[0])); i++) {
+		if (name != prefetchNames[i]) {
+			continue;
+		}
+		config.kind = (PrefetchKind)i;
+		config.degree = config.kind == PREFETCH_NONE ? 0 : config.kind == PREFETCH_STREAM ? 4 : 1;
+		if (name.size() == text.size()) {
+			return true;
+		}
+		unsigned int degree = 0;
+		char rest;
+		if (config.kind == PREFETCH_NONE ||
+			sscanf(text.c_str() + name.size() + 1, "%u%c", &degree, &rest) != 1 ||
+			degree == 0 || degree > MAX_PREFETCH_DEGREE) {
+			return false;
+		}
+		config.degree = degree;
+		return true;
+	}
+	return false;
+}
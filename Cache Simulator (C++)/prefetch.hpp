@@ -0,0 +1,100 @@
+#ifndef PREFETCH_HPP
+#define PREFETCH_HPP
+
+#include <string>
+#include <stdint.h>
+
+#include "checkpoint.hpp"
+
+using  namespace std;
+
+// Hardware prefetchers, BasicCache attaches one to L1 and/or one to L2. A prefetcher sees the
+// demand accesses of its level as block addresses (address >> BSize) and picks blocks to
+// bring into that level:
+//   next:N   - on a miss, or on the first use of a prefetched line, the next N blocks
+//   stride:N - there are no program counters in the traces, so a table of STRIDE_TABLE_SIZE
+//              entries keyed by STRIDE_REGION_BITS regions learns the stride of every region.
+//              Once a region repeats its stride STRIDE_CONFIDENCE times, the next N blocks
+//              along it are fetched on every access.
+//   stream:N - STREAM_BUFFERS stream buffers (Jouppi, ISCA 1990) of N blocks, outside the
+//              cache. A miss that finds its block at the head of a buffer takes the line from
+//              there and the buffer fetches one more, any other miss restarts the least
+//              recently used buffer after the missing block.
+// Prefetched lines are tagged in the cache (see CacheLevel), which is what PrefetchStats
+// counts from.
+#define MAX_PREFETCH_DEGREE 16
+#define STRIDE_TABLE_SIZE 64
+#define STRIDE_REGION_BITS 12 // 4KB regions
+#define STRIDE_CONFIDENCE 2
+#define STREAM_BUFFERS 4
+
+enum PrefetchKind {
+    PREFETCH_NONE = 0,
+    PREFETCH_NEXT_LINE = 1,
+    PREFETCH_STRIDE = 2,
+    PREFETCH_STREAM = 3
+};
+
+struct PrefetchConfig {
+    PrefetchKind kind;
+    unsigned int degree; // blocks per prefetch or stream buffer depth, 1 .. MAX_PREFETCH_DEGREE
+};
+
+// "none", or "next", "stride" or "stream" with an optional ":<degree>" (1 by default, 4 for
+// stream buffers), returns false for anything else
+bool parsePrefetchConfig(const string& text, PrefetchConfig& config);
+
+struct PrefetchStats {
+    uint64_t issued; // blocks fetched by the prefetcher
+    uint64_t useful; // prefetched blocks a demand access used
+    uint64_t late; // useful ones the demand access had to wait for
+    uint64_t lateCycles; // cycles spent waiting, counted in totalMemCycles
+    uint64_t evictedUsed, evictedUnused; // prefetched lines evicted after use and without
+    PrefetchStats& operator+=(const PrefetchStats& other);
+    PrefetchStats& operator-=(const PrefetchStats& other);
+};
+
+class Prefetcher {
+private:
+    struct StrideEntry {
+        uint64_t region;
+        uint64_t lastBlock;
+        int64_t stride;
+        uint32_t confidence;
+        uint32_t valid;
+    };
+    struct StreamBuffer {
+        uint64_t blocks[MAX_PREFETCH_DEGREE];
+        uint64_t ready[MAX_PREFETCH_DEGREE]; // cycle every block arrives
+        unsigned int head, count;
+        uint64_t nextBlock; // the block the buffer fetches next
+        uint64_t lastUse;
+    };
+    PrefetchConfig config;
+    unsigned int regionShift; // log2 of the blocks in a stride region
+    StrideEntry strides[STRIDE_TABLE_SIZE];
+    StreamBuffer streams[STREAM_BUFFERS];
+    uint64_t clock; // stream buffer uses
+public:
+    Prefetcher();
+    void initPrefetcher(const PrefetchConfig& config, unsigned int blockBits);
+    PrefetchKind getKind();
+    // next line and stride: a demand access to block, returns how many blocks to prefetch
+    // and writes them to blocks (MAX_PREFETCH_DEGREE at most)
+    unsigned int train(uint64_t block, bool miss, bool prefetchHit, uint64_t* blocks);
+    // stream buffers: the buffer with block at its head, or -1
+    int findStream(uint64_t block);
+    // removes the head of buffer, returns the cycle it arrives
+    uint64_t popStream(int buffer);
+    // restarts the least recently used buffer after block, returns it and the number of
+    // blocks it dropped unused
+    int restartStream(uint64_t block, unsigned int& dropped);
+    bool streamFull(int buffer);
+    // the block buffer fetches next, then pushStream adds it with the cycle it arrives
+    uint64_t nextStreamBlock(int buffer);
+    void pushStream(int buffer, uint64_t ready);
+    void saveState(CheckpointWriter& checkpoint);
+    bool restoreState(CheckpointReader& checkpoint);
+};
+
+#endif // PREFETCH_HPP
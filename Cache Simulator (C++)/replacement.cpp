@@ -0,0 +1,65 @@
+#include "replacement.hpp"
+
+/**********************************************************************************************/
+// TreePLRUPolicy definitions
+TreePLRUPolicy::TreePLRUPolicy() : numWays(0), levels(0), words(0), bits(nullptr) {
+}
+
+TreePLRUPolicy::~TreePLRUPolicy() {
+	delete[] this->bits;
+}
+
+void TreePLRUPolicy::initPolicy(unsigned int numSets, unsigned int numOfWays) {
+	this->numWays = numOfWays;
+	this->levels = 0;
+	while ((1u << this->levels) < numOfWays) {
+		this->levels++;
+	}
+	// nodes are numbered 1 .. numWays - 1
+	this->words = (numOfWays + 63) / 64;
+	this->bits = new uint64_t[(size_t)numSets * this->words]();
+}
+
+void TreePLRUPolicy::saveState(CheckpointWriter& checkpoint, unsigned int numSets) {
+	checkpoint.writeArray(this->bits, (size_t)numSets * this->words);
+}
+
+bool TreePLRUPolicy::restoreState(CheckpointReader& checkpoint, unsigned int numSets) {
+	return checkpoint.readArray(this->bits, (size_t)numSets * this->words);
+}
+
+/**********************************************************************************************/
+// RandomPolicy definitions
+void RandomPolicy::initPolicy(unsigned int numSets, unsigned int numOfWays) {
+	this->numWays = numOfWays;
+	this->state = new uint64_t[numSets];
+	for (unsigned int set = 0; set < numSets; set++) {
+		this->state[set] = RANDOM_POLICY_SEED;
+	}
+}
+
+void RandomPolicy::saveState(CheckpointWriter& checkpoint, unsigned int numSets) {
+	checkpoint.writeArray(this->state, numSets);
+}
+
+bool RandomPolicy::restoreState(CheckpointReader& checkpoint, unsigned int numSets) {
+	return checkpoint.readArray(this->state, numSets);
+}
+
+/**********************************************************************************************/
+
+static const char* policyNames[] = {"lru", "plru", "srrip", "brrip", "fifo", "random"};
+
+bool parseReplacementPolicy(const string& name, ReplacementPolicyKind& kind) {
+	for (int i = 0; i < (int)(sizeof(policyNames) / sizeof(policyNames[0])); i++) {
+		if (name == policyNames[i]) {
+			kind = (ReplacementPolicyKind)i;
+			return true;
+		}
+	}
+	return false;
+}
+
+const char* replacementPolicyName(ReplacementPolicyKind kind) {
+	return policyNames[kind];
+}
@@ -0,0 +1,308 @@
+#ifndef REPLACEMENT_HPP
+#define REPLACEMENT_HPP
+
+#include <string>
+#include <stdint.h>
+
+#include "checkpoint.hpp"
+
+using  namespace std;
+
+// Replacement policies, plugged into CacheLevel as a template parameter so the hot path has
+// no virtual calls. Every policy keeps its state in flat per-level arrays and implements:
+//   initPolicy(numSets, numWays)
+//   touch(set, way)   - hit on way
+//   insert(set, way)  - way was just filled
+//   remove(set, way)  - way was invalidated
+//   victim(set)       - way to evict, only asked when every way of the set is valid
+//   age(set, way)     - when the line was last touched on a clock shared by the whole level,
+//                       how a skewed level (index.hpp) compares lines of different sets. 0 in
+//                       the policies without such a clock
+//   saveState(checkpoint, numSets), restoreState(checkpoint, numSets) - for checkpoints
+// The number of ways is always a power of two. Any state beyond the lines themselves is kept
+// per set and starts the same in every set, so a policy never depends on how sets are
+// numbered and set-sharded runs (shard.hpp) match serial ones.
+
+enum ReplacementPolicyKind {
+    REPLACEMENT_LRU = 0,
+    REPLACEMENT_PLRU = 1,
+    REPLACEMENT_SRRIP = 2,
+    REPLACEMENT_BRRIP = 3,
+    REPLACEMENT_FIFO = 4,
+    REPLACEMENT_RANDOM = 5
+};
+
+// "lru", "plru", "srrip", "brrip", "fifo" or "random", returns false for anything else
+bool parseReplacementPolicy(const string& name, ReplacementPolicyKind& kind);
+const char* replacementPolicyName(ReplacementPolicyKind kind);
+
+// Every line remembers when it was last used (UpdateOnHit, true LRU) or filled (FIFO), the
+// victim is the oldest one. Hits cost one store, the O(ways) scan only happens on evictions.
+template <bool UpdateOnHit>
+class AgePolicy {
+private:
+    unsigned int numWays;
+    uint64_t* stamps;
+    uint64_t clock;
+    AgePolicy(const AgePolicy&) = delete;
+    AgePolicy& operator=(const AgePolicy&) = delete;
+public:
+    AgePolicy() : numWays(0), stamps(nullptr), clock(0) {}
+    ~AgePolicy() { delete[] this->stamps; }
+    void initPolicy(unsigned int numSets, unsigned int numOfWays);
+    void touch(unsigned int set, unsigned int way);
+    void insert(unsigned int set, unsigned int way);
+    void remove(unsigned int, unsigned int) {}
+    unsigned int victim(unsigned int set);
+    uint64_t age(unsigned int set, unsigned int way) { return this->stamps[(size_t)set * this->numWays + way]; }
+    void saveState(CheckpointWriter& checkpoint, unsigned int numSets);
+    bool restoreState(CheckpointReader& checkpoint, unsigned int numSets);
+};
+
+typedef AgePolicy<true> LRUPolicy;
+typedef AgePolicy<false> FIFOPolicy;
+
+// Tree pseudo LRU, one bit per node of a binary tree over the ways (heap order, node 1 is the
+// root, bit 1 means the victim is on the right). Updates and victim selection are O(log ways).
+class TreePLRUPolicy {
+private:
+    unsigned int numWays;
+    unsigned int levels; // log2(numWays)
+    unsigned int words; // 64-bit words of node bits per set
+    uint64_t* bits;
+    TreePLRUPolicy(const TreePLRUPolicy&) = delete;
+    TreePLRUPolicy& operator=(const TreePLRUPolicy&) = delete;
+public:
+    TreePLRUPolicy();
+    ~TreePLRUPolicy();
+    void initPolicy(unsigned int numSets, unsigned int numOfWays);
+    void touch(unsigned int set, unsigned int way);
+    void insert(unsigned int set, unsigned int way);
+    void remove(unsigned int, unsigned int) {}
+    unsigned int victim(unsigned int set);
+    uint64_t age(unsigned int, unsigned int) { return 0; }
+    void saveState(CheckpointWriter& checkpoint, unsigned int numSets);
+    bool restoreState(CheckpointReader& checkpoint, unsigned int numSets);
+};
+
+// Re-reference interval prediction (Jaleel et al., ISCA 2010) with 2-bit RRPVs. Hits predict
+// near re-reference (0). SRRIP fills with a long interval (2), BRRIP (Bimodal) fills with a
+// distant one (3) and only every BRRIP_THROTTLE-th fill of a set with a long one.
+#define RRPV_MAX 3
+#define BRRIP_THROTTLE 32
+
+template <bool Bimodal>
+class RRIPPolicy {
+private:
+    unsigned int numWays;
+    uint8_t* rrpv;
+    uint8_t* fills; // per set fill counter for the bimodal throttle
+    RRIPPolicy(const RRIPPolicy&) = delete;
+    RRIPPolicy& operator=(const RRIPPolicy&) = delete;
+public:
+    RRIPPolicy() : numWays(0), rrpv(nullptr), fills(nullptr) {}
+    ~RRIPPolicy() { delete[] this->rrpv; delete[] this->fills; }
+    void initPolicy(unsigned int numSets, unsigned int numOfWays);
+    void touch(unsigned int set, unsigned int way);
+    void insert(unsigned int set, unsigned int way);
+    void remove(unsigned int, unsigned int) {}
+    unsigned int victim(unsigned int set);
+    uint64_t age(unsigned int, unsigned int) { return 0; }
+    void saveState(CheckpointWriter& checkpoint, unsigned int numSets);
+    bool restoreState(CheckpointReader& checkpoint, unsigned int numSets);
+};
+
+typedef RRIPPolicy<false> SRRIPPolicy;
+typedef RRIPPolicy<true> BRRIPPolicy;
+
+// Uniformly random victim, every set runs its own generator from a fixed seed so runs are
+// reproducible
+#define RANDOM_POLICY_SEED 0x9E3779B97F4A7C15ull
+
+class RandomPolicy {
+private:
+    unsigned int numWays;
+    uint64_t* state; // xorshift64 per set
+    RandomPolicy(const RandomPolicy&) = delete;
+    RandomPolicy& operator=(const RandomPolicy&) = delete;
+public:
+    RandomPolicy() : numWays(0), state(nullptr) {}
+    ~RandomPolicy() { delete[] this->state; }
+    void initPolicy(unsigned int numSets, unsigned int numOfWays);
+    void touch(unsigned int, unsigned int) {}
+    void insert(unsigned int, unsigned int) {}
+    void remove(unsigned int, unsigned int) {}
+    unsigned int victim(unsigned int set);
+    uint64_t age(unsigned int, unsigned int) { return 0; }
+    void saveState(CheckpointWriter& checkpoint, unsigned int numSets);
+    bool restoreState(CheckpointReader& checkpoint, unsigned int numSets);
+};
+
+// Calls runner.template run<Policy>() with the policy class kind names. Runner::Result is
+// the return type, this is how the command line modes pick an instantiation at run time.
+template <class Runner>
+typename Runner::Result dispatchReplacementPolicy(ReplacementPolicyKind kind, Runner& runner) {
+	switch (kind) {
+	case REPLACEMENT_PLRU:
+		return runner.template run<TreePLRUPolicy>();
+	case REPLACEMENT_SRRIP:
+		return runner.template run<SRRIPPolicy>();
+	case REPLACEMENT_BRRIP:
+		return runner.template run<BRRIPPolicy>();
+	case REPLACEMENT_FIFO:
+		return runner.template run<FIFOPolicy>();
+	case REPLACEMENT_RANDOM:
+		return runner.template run<RandomPolicy>();
+	default:
+		return runner.template run<LRUPolicy>();
+	}
+}
+
+/**********************************************************************************************/
+// AgePolicy definitions
+
+template <bool UpdateOnHit>
+void AgePolicy<UpdateOnHit>::initPolicy(unsigned int numSets, unsigned int numOfWays) {
+	this->numWays = numOfWays;
+	this->stamps = new uint64_t[(size_t)numSets * numOfWays]();
+}
+
+template <bool UpdateOnHit>
+void AgePolicy<UpdateOnHit>::saveState(CheckpointWriter& checkpoint, unsigned int numSets) {
+	checkpoint.writeArray(this->stamps, (size_t)numSets * this->numWays);
+	checkpoint.writeArray(&this->clock, 1);
+}
+
+template <bool UpdateOnHit>
+bool AgePolicy<UpdateOnHit>::restoreState(CheckpointReader& checkpoint, unsigned int numSets) {
+	return checkpoint.readArray(this->stamps, (size_t)numSets * this->numWays) &&
+		   checkpoint.readArray(&this->clock, 1);
+}
+
+template <bool UpdateOnHit>
+inline void AgePolicy<UpdateOnHit>::touch(unsigned int set, unsigned int way) {
+	if (UpdateOnHit) {
+		this->stamps[(size_t)set * this->numWays + way] = ++this->clock;
+	}
+}
+
+template <bool UpdateOnHit>
+inline void AgePolicy<UpdateOnHit>::insert(unsigned int set, unsigned int way) {
+	this->stamps[(size_t)set * this->numWays + way] = ++this->clock;
+}
+
+template <bool UpdateOnHit>
+inline unsigned int AgePolicy<UpdateOnHit>::victim(unsigned int set) {
+	const uint64_t* setStamps = this->stamps + (size_t)set * this->numWays;
+	unsigned int oldest = 0;
+	for (unsigned int way = 1; way < this->numWays; way++) {
+		if (setStamps[way] < setStamps[oldest]) {
+			oldest = way;
+		}
+	}
+	return oldest;
+}
+
+/**********************************************************************************************/
+// TreePLRUPolicy definitions
+
+inline void TreePLRUPolicy::touch(unsigned int set, unsigned int way) {
+	// walk from the root to way and point every node on the path away from it
+	uint64_t* setBits = this->bits + (size_t)set * this->words;
+	unsigned int node = 1;
+	for (unsigned int level = this->levels; level > 0; level--) {
+		unsigned int right = (way >> (level - 1)) & 1;
+		uint64_t bit = (uint64_t)1 << (node & 63);
+		if (right) {
+			setBits[node >> 6] &= ~bit;
+		} else {
+			setBits[node >> 6] |= bit;
+		}
+		node = 2 * node + right;
+	}
+}
+
+inline void TreePLRUPolicy::insert(unsigned int set, unsigned int way) {
+	this->touch(set, way);
+}
+
+inline unsigned int TreePLRUPolicy::victim(unsigned int set) {
+	const uint64_t* setBits = this->bits + (size_t)set * this->words;
+	unsigned int node = 1;
+	while (node < this->numWays) {
+		node = 2 * node + ((setBits[node >> 6] >> (node & 63)) & 1);
+	}
+	return node - this->numWays;
+}
+
+/**********************************************************************************************/
+// RRIPPolicy definitions
+
+template <bool Bimodal>
+void RRIPPolicy<Bimodal>::initPolicy(unsigned int numSets, unsigned int numOfWays) {
+	this->numWays = numOfWays;
+	this->rrpv = new uint8_t[(size_t)numSets * numOfWays];
+	for (size_t line = 0; line < (size_t)numSets * numOfWays; line++) {
+		this->rrpv[line] = RRPV_MAX;
+	}
+	this->fills = new uint8_t[numSets]();
+}
+
+template <bool Bimodal>
+void RRIPPolicy<Bimodal>::saveState(CheckpointWriter& checkpoint, unsigned int numSets) {
+	checkpoint.writeArray(this->rrpv, (size_t)numSets * this->numWays);
+	checkpoint.writeArray(this->fills, numSets);
+}
+
+template <bool Bimodal>
+bool RRIPPolicy<Bimodal>::restoreState(CheckpointReader& checkpoint, unsigned int numSets) {
+	return checkpoint.readArray(this->rrpv, (size_t)numSets * this->numWays) &&
+		   checkpoint.readArray(this->fills, numSets);
+}
+
+template <bool Bimodal>
+inline void RRIPPolicy<Bimodal>::touch(unsigned int set, unsigned int way) {
+	this->rrpv[(size_t)set * this->numWays + way] = 0;
+}
+
+template <bool Bimodal>
+inline void RRIPPolicy<Bimodal>::insert(unsigned int set, unsigned int way) {
+	uint8_t value = RRPV_MAX - 1;
+	if (Bimodal && (++this->fills[set] % BRRIP_THROTTLE) != 0) {
+		value = RRPV_MAX;
+	}
+	this->rrpv[(size_t)set * this->numWays + way] = value;
+}
+
+template <bool Bimodal>
+inline unsigned int RRIPPolicy<Bimodal>::victim(unsigned int set) {
+	// the first way with the largest RRPV, after ageing the set until that RRPV is RRPV_MAX
+	uint8_t* setRRPV = this->rrpv + (size_t)set * this->numWays;
+	unsigned int victimWay = 0;
+	for (unsigned int way = 1; way < this->numWays; way++) {
+		if (setRRPV[way] > setRRPV[victimWay]) {
+			victimWay = way;
+		}
+	}
+	uint8_t age = RRPV_MAX - setRRPV[victimWay];
+	if (age != 0) {
+		for (unsigned int way = 0; way < this->numWays; way++) {
+			setRRPV[way] += age;
+		}
+	}
+	return victimWay;
+}
+
+/**********************************************************************************************/
+// RandomPolicy definitions
+
+inline unsigned int RandomPolicy::victim(unsigned int set) {
+	uint64_t x = this->state[set];
+	x ^= x << 13;
+	x ^= x >> 7;
+	x ^= x << 17;
+	this->state[set] = x;
+	return (unsigned int)(x >> 32) & (this->numWays - 1);
+}
+
+#endif // REPLACEMENT_HPP
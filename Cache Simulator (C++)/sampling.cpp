@@ -0,0 +1,48 @@
+#include "sampling.hpp"
+
+#include <cmath>
+
+#define CONFIDENCE_Z 1.96 // 95% two sided, normal approximation
+
+// ratio estimate sum(y) / sum(x) over the samples, the interval uses the variance of the
+// residuals y - R * x (the usual ratio estimator, for equal x it is the plain mean)
+static SampleEstimate ratioEstimate(const vector<double>& y, const vector<double>& x) {
+	SampleEstimate estimate = {0.0, 0.0};
+	size_t n = y.size();
+	double sumY = 0, sumX = 0;
+	for (size_t i = 0; i < n; i++) {
+		sumY += y[i];
+		sumX += x[i];
+	}
+	if (sumX == 0) {
+		return estimate;
+	}
+	estimate.value = sumY / sumX;
+	if (n < 2) {
+		return estimate;
+	}
+	double squares = 0;
+	for (size_t i = 0; i < n; i++) {
+		double residual = y[i] - estimate.value * x[i];
+		squares += residual * residual;
+	}
+	double meanX = sumX / n;
+	estimate.error = CONFIDENCE_Z * sqrt(squares / (n - 1) / n) / meanX;
+	return estimate;
+}
+
+void estimateSampledStats(SampledStats& stats) {
+	size_t n = stats.samples.size();
+	vector<double> L1Accesses(n), L1Misses(n), L2Accesses(n), L2Misses(n), cycles(n);
+	for (size_t i = 0; i < n; i++) {
+		const CacheStats& s = stats.samples[i];
+		L1Accesses[i] = (double)s.L1Reads + s.L1Writes;
+		L1Misses[i] = (double)s.L1ReadMisses + s.L1WriteMisses;
+		L2Accesses[i] = (double)s.L2Reads + s.L2Writes;
+		L2Misses[i] = (double)s.L2ReadMisses + s.L2WriteMisses;
+		cycles[i] = (double)s.totalL1Cycles + s.totalL2Cycles + s.totalMemCycles;
+	}
+	stats.L1MissRate = ratioEstimate(L1Misses, L1Accesses);
+	stats.L2MissRate = ratioEstimate(L2Misses, L2Accesses);
+	stats.avgAccTime = ratioEstimate(cycles, L1Accesses);
+}
@@ -0,0 +1,125 @@
+#ifndef SAMPLING_HPP
+#define SAMPLING_HPP
+
+#include <vector>
+#include <stdint.h>
+
+#include "cacheSim.hpp"
+
+using  namespace std;
+
+// Sampled simulation in the style of SMARTS (Wunderlich et al., ISCA 2003). The trace is cut
+// into periods of `period` accesses, each of them ends with a warm-up of `warmup` accesses and
+// a measured sample of `detail` accesses, both simulated in detail. The accesses before them
+// are fast-forwarded: either skipped, or only used to warm the tags and replacement state
+// through Cache::warmAccess, which keeps long lived lines correct at a fraction of the cost.
+// Only the samples are counted. The run wide rates are estimated from them as ratios of the
+// sample totals, with a 95% confidence interval from the spread between samples.
+//
+// SimPoint style selection needs basic block vectors, which need the program counter of
+// every access. The trace formats only have data addresses, so periodic sampling is the only
+// choice here.
+
+struct SamplingConfig {
+    uint64_t period, warmup, detail; // warmup + detail <= period
+    bool warmFastForward; // false skips the fast-forwarded accesses entirely
+};
+
+// an estimated rate and the half width of its 95% confidence interval
+struct SampleEstimate {
+    double value;
+    double error;
+};
+
+struct SampledStats {
+    uint64_t accesses; // the whole trace
+    vector<CacheStats> samples; // counters of every complete sample
+    SampleEstimate L1MissRate, L2MissRate, avgAccTime;
+};
+
+// fill the estimates of stats from stats.samples
+void estimateSampledStats(SampledStats& stats);
+
+// Drives a BasicCache through the phases of every period, collecting a CacheStats per sample
+template <class Simulator>
+class SampledSimulator {
+private:
+    Simulator& cache;
+    SamplingConfig config;
+    uint64_t position; // accesses seen in the current period
+    uint64_t accesses;
+    CacheStats sampleStart; // counters when the current sample started
+    vector<CacheStats> samples;
+    void access(uint64_t address, uint8_t operation); // ACCESS_READ, ACCESS_WRITE or ACCESS_FETCH
+public:
+    SampledSimulator(Simulator& cache, const SamplingConfig& config);
+    void readFromCache(uint64_t address);
+    void writeToCache(uint64_t address);
+    void fetchFromCache(uint64_t address);
+    // move the samples (an unfinished last one is dropped) into stats and estimate the rates
+    void finish(SampledStats& stats);
+};
+
+/**********************************************************************************************/
+// SampledSimulator definitions
+
+template <class Simulator>
+SampledSimulator<Simulator>::SampledSimulator(Simulator& cache, const SamplingConfig& config) :
+		cache(cache), config(config), position(0), accesses(0) {
+	this->sampleStart = CacheStats();
+}
+
+template <class Simulator>
+inline void SampledSimulator<Simulator>::access(uint64_t address, uint8_t operation) {
+	uint64_t detailStart = this->config.period - this->config.detail;
+	uint64_t warmupStart = detailStart - this->config.warmup;
+	if (this->position < warmupStart) { // fast-forward
+		if (this->config.warmFastForward && operation == ACCESS_FETCH) {
+			this->cache.warmFetch(address);
+		} else if (this->config.warmFastForward) {
+			this->cache.warmAccess(address, operation == ACCESS_WRITE);
+		}
+	} else {
+		if (this->position == detailStart) {
+			this->sampleStart = this->cache.getStats();
+		}
+		if (operation == ACCESS_WRITE) {
+			this->cache.writeToCache(address);
+		} else if (operation == ACCESS_FETCH) {
+			this->cache.fetchFromCache(address);
+		} else {
+			this->cache.readFromCache(address);
+		}
+	}
+	this->accesses++;
+	if (++this->position == this->config.period) {
+		CacheStats sample = this->cache.getStats();
+		sample -= this->sampleStart;
+		this->samples.push_back(sample);
+		this->position = 0;
+	}
+}
+
+template <class Simulator>
+void SampledSimulator<Simulator>::readFromCache(uint64_t address) {
+	this->access(address, ACCESS_READ);
+}
+
+template <class Simulator>
+void SampledSimulator<Simulator>::writeToCache(uint64_t address) {
+	this->access(address, ACCESS_WRITE);
+}
+
+template <class Simulator>
+void SampledSimulator<Simulator>::fetchFromCache(uint64_t address) {
+	this->access(address, ACCESS_FETCH);
+}
+
+template <class Simulator>
+void SampledSimulator<Simulator>::finish(SampledStats& stats) {
+	stats.accesses = this->accesses;
+	stats.samples.swap(this->samples);
+	estimateSampledStats(stats);
+}
+
+#endif // SAMPLING_HPP
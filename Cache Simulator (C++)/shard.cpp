@@ -0,0 +1,73 @@
+#include "shard.hpp"
+
+#include <thread>
+
+/**********************************************************************************************/
+
+void splitTrace(TraceImage& trace, unsigned int BSize, unsigned int shardBits, vector<ShardImage>& shards) {
+	shards.assign((size_t)1 << shardBits, ShardImage());
+	vector<uint64_t> lastAddresses(shards.size(), 0);
+	BinaryTraceReader reader(trace.getRecords(), trace.getRecordsEnd(), trace.getNumAccesses(),
+							 trace.getFlags());
+	CacheTag shardMask = ((CacheTag)1 << shardBits) - 1;
+	uint64_t offsetMask = ((uint64_t)1 << BSize) - 1;
+	uint8_t record[TRACE_MAX_RECORD];
+	TraceAccess access;
+	while (reader.next(access) == TRACE_OK) {
+		CacheTag block = (CacheTag)access.address >> BSize;
+		size_t shard = block & shardMask;
+		access.address = ((uint64_t)(block >> shardBits) << BSize) | (access.address & offsetMask);
+		size_t length = encodeTraceRecord(record, access, lastAddresses[shard], TRACE_FLAG_FETCHES);
+		shards[shard].records.insert(shards[shard].records.end(), record, record + length);
+		shards[shard].numAccesses++;
+	}
+}
+
+/**********************************************************************************************/
+
+unsigned int maxShardBits(const CacheConfig& config) {
+	unsigned int L1IndexBits = config.L1Size - config.BSize - config.L1Assoc;
+	unsigned int L2IndexBits = config.L2Size - config.BSize - config.L2Assoc;
+	unsigned int bits = L1IndexBits < L2IndexBits ? L1IndexBits : L2IndexBits;
+	if (config.L1ISize != L1I_OFF) {
+		unsigned int L1IIndexBits = config.L1ISize - config.BSize - config.L1IAssoc;
+		bits = L1IIndexBits < bits ? L1IIndexBits : bits;
+	}
+	return bits;
+}
+
+CacheStats simulateSharded(TraceImage& trace, const CacheConfig& config, unsigned int numShards) {
+	if (numShards == 0) {
+		numShards = thread::hardware_concurrency();
+	}
+	unsigned int shardBits = 0;
+	while ((2u << shardBits) <= numShards && shardBits < maxShardBits(config)) {
+		shardBits++;
+	}
+	numShards = 1u << shardBits;
+
+	vector<ShardImage> shards;
+	splitTrace(trace, config.BSize, shardBits, shards);
+	vector<CacheStats> shardStats(numShards);
+	vector<thread> workers;
+	for (unsigned int shard = 0; shard < numShards; shard++) {
+		workers.push_back(thread([&shards, &config, &shardStats, shardBits, shard]() {
+			CacheConfig shardConfig = config;
+			shardConfig.L1Size -= shardBits;
+			shardConfig.L2Size -= shardBits;
+			if (config.L1ISize != L1I_OFF) {
+				shardConfig.L1ISize -= shardBits;
+			}
+			const vector<uint8_t>& records = shards[shard].records;
+			BinaryTraceReader reader(records.data(), records.data() + records.size(),
+									 shards[shard].numAccesses, TRACE_FLAG_FETCHES);
+			simulateConfig(reader, shardConfig, shardStats[shard]);
+		}));
+	}
+	CacheStats total = CacheStats();
+	for (unsigned int shard = 0; shard < numShards; shard++) {
+		workers[shard].join();
+		total += shardStats[shard];
+	}
+	return total;
+}
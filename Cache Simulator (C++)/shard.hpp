@@ -0,0 +1,39 @@
+#ifndef SHARD_HPP
+#define SHARD_HPP
+
+#include <vector>
+
+#include "cacheSim.hpp"
+#include "trace.hpp"
+
+// Set sharded simulation of one configuration.
+//
+// Both levels (and an L1I) index with the low bits of the block address, so the lowest
+// min(L1IndexBits, L2IndexBits) block bits (and L1I's) pick the same shard for a block in
+// every level.
+// An L2 victim and the L1 line it back-invalidates are the same block, so every interaction
+// between the levels stays inside one shard. Each shard is simulated by its own Cache with
+// the shard bits removed from the block address and from the sizes, which maps the shard's
+// sets one to one onto the smaller cache and gives exactly the serial statistics when summed.
+
+// The accesses of one shard with the shard bits removed, in the binary record format. The
+// trace image is decoded once and split into one of these per shard, so every shard thread
+// reads only its own accesses.
+struct ShardImage {
+    vector<uint8_t> records;
+    uint64_t numAccesses;
+};
+
+// split the accesses of trace into 1 << shardBits shard images, by the low bits of the block
+// address as the Cache computes it (a CacheTag, so 32-bit builds drop the same high bits).
+// The shard records always carry the fetch op (TRACE_FLAG_FETCHES).
+void splitTrace(TraceImage& trace, unsigned int BSize, unsigned int shardBits, vector<ShardImage>& shards);
+
+// largest number of shard bits config allows
+unsigned int maxShardBits(const CacheConfig& config);
+
+// simulate trace with config on numShards threads (rounded down to a power of two and to the
+// most the geometry allows, 0 picks one per hardware thread) and return the merged counters
+CacheStats simulateSharded(TraceImage& trace, const CacheConfig& config, unsigned int numShards);
+
+#endif // SHARD_HPP
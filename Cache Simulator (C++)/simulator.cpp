@@ -0,0 +1,475 @@
+#include "simulator.hpp"
+#include "interval.hpp"
+#include "shard.hpp"
+#include "stream.hpp"
+
+/**********************************************************************************************/
+// CacheModel, a BasicCache of any policy behind one interface
+
+class CacheModel {
+public:
+	virtual ~CacheModel() {}
+	virtual void readFromCache(uint64_t address) = 0;
+	virtual void writeToCache(uint64_t address) = 0;
+	virtual void fetchFromCache(uint64_t address) = 0;
+	virtual bool accessBatch(const uint64_t* addresses, const uint8_t* operations, size_t count) = 0;
+	virtual CacheStats getStats() = 0;
+};
+
+template <class ReplacementPolicy>
+class PolicyCacheModel : public CacheModel {
+private:
+	BasicCache<ReplacementPolicy> cache;
+public:
+	explicit PolicyCacheModel(const CacheConfig& config) : cache(config) {}
+	void readFromCache(uint64_t address) { this->cache.readFromCache(address); }
+	void writeToCache(uint64_t address) { this->cache.writeToCache(address); }
+	void fetchFromCache(uint64_t address) { this->cache.fetchFromCache(address); }
+	bool accessBatch(const uint64_t* addresses, const uint8_t* operations, size_t count) {
+		return this->cache.accessBatch(addresses, operations, count);
+	}
+	CacheStats getStats() { return this->cache.getStats(); }
+};
+
+struct ModelRunner {
+	typedef CacheModel* Result;
+	const CacheConfig& config;
+	template <class ReplacementPolicy>
+	CacheModel* run() {
+		return new PolicyCacheModel<ReplacementPolicy>(this->config);
+	}
+};
+
+/**********************************************************************************************/
+// CacheSimulator definitions
+CacheSimulator::CacheSimulator(const CacheConfig& config, size_t layout) : model(nullptr) {
+	if (layout != CACHESIM_LAYOUT) {
+		cerr << "libcachesim was built with another CacheConfig or CacheStats, rebuild against its "
+				"simulator.hpp" << endl;
+		exit(EXIT_FAILURE);
+	}
+	ModelRunner runner = {config};
+	this->model = dispatchReplacementPolicy(config.replacement, runner);
+}
+
+CacheSimulator::~CacheSimulator() {
+	delete this->model;
+}
+
+bool CacheSimulator::isValidConfig(const CacheConfig& config) {
+	// every level has at least one set, and the offset and index bits fit in a tag
+	if (config.BSize >= FULL_TAG_SIZE || config.L1Size >= FULL_TAG_SIZE ||
+		config.L2Size >= FULL_TAG_SIZE || config.L1Size < config.BSize + config.L1Assoc ||
+		config.L2Size < config.BSize + config.L2Assoc) {
+		return false;
+	}
+	if (config.WrAlloc > WRITE_ALLOCATE || config.replacement < REPLACEMENT_LRU ||
+		config.replacement > REPLACEMENT_RANDOM || config.writeBufferDepth < WRITE_BUFFER_OFF ||
+		config.writeBufferDepth > MAX_WRITE_BUFFER) {
+		return false;
+	}
+	const PrefetchConfig* prefetch[2] = {&config.L1Prefetch, &config.L2Prefetch};
+	for (int level = 0; level < 2; level++) {
+		if (prefetch[level]->kind < PREFETCH_NONE || prefetch[level]->kind > PREFETCH_STREAM ||
+			(prefetch[level]->kind != PREFETCH_NONE &&
+			 (prefetch[level]->degree == 0 || prefetch[level]->degree > MAX_PREFETCH_DEGREE))) {
+			return false;
+		}
+	}
+	// a skewed level compares the ages of lines in different sets, which only LRU and FIFO keep
+	const IndexKind indexing[2] = {config.L1Indexing, config.L2Indexing};
+	for (int level = 0; level < 2; level++) {
+		if (indexing[level] < INDEX_MODULO || indexing[level] > INDEX_SKEW ||
+			(indexing[level] == INDEX_SKEW && config.replacement != REPLACEMENT_LRU &&
+			 config.replacement != REPLACEMENT_FIFO)) {
+			return false;
+		}
+	}
+	if (config.victimEntries != VICTIM_OFF &&
+		(config.victimEntries < MIN_VICTIM_ENTRIES || config.victimEntries > MAX_VICTIM_ENTRIES)) {
+		return false;
+	}
+	// power of two channels, ranks and banks, and rows of whole blocks
+	const DramConfig& dram = config.dram;
+	if (dram.channels != DRAM_OFF &&
+		((dram.channels & (dram.channels - 1)) != 0 || dram.ranks == 0 ||
+		 (dram.ranks & (dram.ranks - 1)) != 0 || dram.banks == 0 || (dram.banks & (dram.banks - 1)) != 0 ||
+		 (uint64_t)dram.channels * dram.ranks * dram.banks > MAX_DRAM_BANKS ||
+		 dram.rowSize < config.BSize || dram.rowSize >= FULL_TAG_SIZE ||
+		 dram.page < DRAM_OPEN_PAGE || dram.page > DRAM_CLOSED_PAGE ||
+		 dram.mapping < DRAM_MAP_PAGE || dram.mapping > DRAM_MAP_XOR)) {
+		return false;
+	}
+	// power of two entries and ways, no more ways than entries
+	const TlbConfig& tlb = config.tlb;
+	if (tlb.L1Entries != TLB_OFF &&
+		(tlb.L1Entries > MAX_TLB_ENTRIES || (tlb.L1Entries & (tlb.L1Entries - 1)) != 0 ||
+		 tlb.L1Ways == 0 || (tlb.L1Ways & (tlb.L1Ways - 1)) != 0 || tlb.L1Ways > tlb.L1Entries ||
+		 tlb.L2Entries > MAX_TLB_ENTRIES || (tlb.L2Entries & (tlb.L2Entries - 1)) != 0 ||
+		 (tlb.L2Entries != 0 && (tlb.L2Ways == 0 || (tlb.L2Ways & (tlb.L2Ways - 1)) != 0 ||
+								 tlb.L2Ways > tlb.L2Entries)) ||
+		 tlb.pwcEntries > MAX_PWC_ENTRIES || tlb.pageSize < TLB_PAGE_4K || tlb.pageSize > TLB_PAGE_2M)) {
+		return false;
+	}
+	// an L1I has at least one set, like the other levels
+	if (config.L1ISize != L1I_OFF &&
+		(config.L1ISize >= FULL_TAG_SIZE || config.L1ISize < config.BSize + config.L1IAssoc)) {
+		return false;
+	}
+	return true;
+}
+
+void CacheSimulator::readFromCache(uint64_t address) {
+	this->model->readFromCache(address);
+}
+
+void CacheSimulator::writeToCache(uint64_t address) {
+	this->model->writeToCache(address);
+}
+
+void CacheSimulator::fetchFromCache(uint64_t address) {
+	this->model->fetchFromCache(address);
+}
+
+bool CacheSimulator::accessBatch(const uint64_t* addresses, const uint8_t* operations, size_t count) {
+	return this->model->accessBatch(addresses, operations, count);
+}
+
+CacheStats CacheSimulator::getStats() {
+	return this->model->getStats();
+}
+
+/**********************************************************************************************/
+// Library drivers of the command line modes
+
+struct IntervalRunner {
+	typedef bool Result;
+	const char* path;
+	const CacheConfig& config;
+	uint64_t intervalAccesses, intervalCycles;
+	CacheStats& stats;
+	template <class ReplacementPolicy>
+	bool run() {
+		BasicCache<ReplacementPolicy> cache(this->config);
+		IntervalReporter<BasicCache<ReplacementPolicy> > reporter(cache, this->intervalAccesses,
+																  this->intervalCycles);
+		bool ok = simulateTraceInput(this->path, reporter);
+		reporter.finish();
+		this->stats = cache.getStats();
+		return ok;
+	}
+};
+
+struct SampledRunner {
+	typedef bool Result;
+	const char* path;
+	const CacheConfig& config;
+	const SamplingConfig& sampling;
+	SampledStats& stats;
+	template <class ReplacementPolicy>
+	bool run() {
+		BasicCache<ReplacementPolicy> cache(this->config);
+		SampledSimulator<BasicCache<ReplacementPolicy> > sampler(cache, this->sampling);
+		bool ok = simulateTraceInput(this->path, sampler);
+		sampler.finish(this->stats);
+		return ok;
+	}
+};
+
+struct TimingRunner {
+	typedef bool Result;
+	const char* path;
+	const CacheConfig& config;
+	const TimingConfig& timing;
+	CacheStats& stats;
+	TimingStats& timingStats;
+	template <class ReplacementPolicy>
+	bool run() {
+		BasicCache<ReplacementPolicy> cache(this->config);
+		TimingSimulator<BasicCache<ReplacementPolicy> > timer(cache, this->config, this->timing);
+		bool ok = simulateTraceInput(this->path, timer);
+		timer.finish(this->timingStats);
+		this->stats = cache.getStats();
+		return ok;
+	}
+};
+
+struct ClassifyRunner {
+	typedef bool Result;
+	const char* path;
+	const CacheConfig& config;
+	CacheStats& stats;
+	ClassifyStats& classes;
+	template <class ReplacementPolicy>
+	bool run() {
+		BasicCache<ReplacementPolicy> cache(this->config);
+		MissClassifier<BasicCache<ReplacementPolicy> > classifier(cache, this->config);
+		bool ok = simulateTraceInput(this->path, classifier);
+		classifier.finish(this->classes);
+		this->stats = cache.getStats();
+		return ok;
+	}
+};
+
+// Restores restorePath (if any), runs up to access checkpointAt and saves checkpointPath there
+// (if any), then simulates the rest of the trace
+struct CheckpointRunner {
+	typedef bool Result;
+	const char* path;
+	const CacheConfig& config;
+	const char* restorePath;
+	const char* checkpointPath;
+	uint64_t checkpointAt;
+	CacheStats& stats;
+	template <class ReplacementPolicy>
+	bool run() {
+		BasicCache<ReplacementPolicy> cache(this->config);
+		bool ok;
+		if (isStreamPath(this->path)) {
+			StreamTraceReader reader(this->path);
+			ok = this->simulate(cache, reader, TRACE_KIND_STREAM);
+		} else if (isBinaryTrace(this->path)) {
+			BinaryTraceReader reader(this->path);
+			ok = this->simulate(cache, reader, TRACE_KIND_BINARY);
+		} else {
+			TextTraceReader reader(this->path);
+			ok = this->simulate(cache, reader, TRACE_KIND_TEXT);
+		}
+		this->stats = cache.getStats();
+		return ok;
+	}
+	template <class Cache, class TraceReader>
+	bool restore(Cache& cache, TraceReader& reader, TraceKind kind, uint64_t& accesses) {
+		CheckpointReader checkpoint(this->restorePath);
+		CheckpointHeader header;
+		if (!checkpoint.isOpen() || !checkpoint.read(&header, sizeof(header)) ||
+			header.magic != CHECKPOINT_MAGIC || header.version != CHECKPOINT_VERSION) {
+			cerr << "Invalid checkpoint" << endl;
+			return false;
+		}
+		if (!isCheckpointOf(header, this->config)) {
+			cerr << "The checkpoint was saved with another configuration" << endl;
+			return false;
+		}
+		if (!cache.restoreState(checkpoint) || !checkpoint.atEnd()) {
+			cerr << "Invalid checkpoint" << endl;
+			return false;
+		}
+		// seek to the saved offset in the same kind of trace, otherwise read up to it
+		TracePosition position = {(TraceKind)header.traceKind, header.accesses, header.offset,
+								  header.lastAddress};
+		if (position.kind != kind || kind == TRACE_KIND_STREAM || !reader.seek(position)) {
+			LimitedTraceReader<TraceReader> skipped(reader, header.accesses);
+			TraceAccess access;
+			TraceStatus status;
+			while ((status = skipped.next(access)) == TRACE_OK) {
+			}
+			if (status == TRACE_FORMAT_ERROR) {
+				cout << "Command Format error" << endl;
+				return false;
+			}
+			if (skipped.getRemaining() != 0) {
+				cerr << "The trace ends before the checkpoint" << endl;
+				return false;
+			}
+		}
+		accesses = header.accesses;
+		return true;
+	}
+	template <class Cache, class TraceReader>
+	bool save(Cache& cache, TraceReader& reader, TraceKind kind, uint64_t accesses) {
+		CheckpointHeader header = makeCheckpointHeader(this->config);
+		header.traceKind = kind;
+		header.accesses = accesses;
+		TracePosition position = {kind, accesses, 0, 0};
+		if (kind != TRACE_KIND_STREAM && reader.tell(position)) {
+			header.offset = position.offset;
+			header.lastAddress = position.lastAddress;
+		} else {
+			header.traceKind = TRACE_KIND_STREAM;
+		}
+		CheckpointWriter checkpoint(this->checkpointPath);
+		if (!checkpoint.isOpen()) {
+			cerr << "Cannot create " << this->checkpointPath << endl;
+			return false;
+		}
+		checkpoint.write(&header, sizeof(header));
+		cache.saveState(checkpoint);
+		if (!checkpoint.close()) {
+			cerr << "Cannot write " << this->checkpointPath << endl;
+			return false;
+		}
+		return true;
+	}
+	template <class Cache, class TraceReader>
+	bool simulate(Cache& cache, TraceReader& reader, TraceKind kind) {
+		if (!reader.isOpen()) {
+			cerr << "File not found" << endl;
+			return false;
+		}
+		uint64_t accesses = 0;
+		if (this->restorePath != NULL && !this->restore(cache, reader, kind, accesses)) {
+			return false;
+		}
+		if (this->checkpointPath != NULL) {
+			if (this->checkpointAt < accesses) {
+				cerr << "The checkpoint is before the restored one" << endl;
+				return false;
+			}
+			LimitedTraceReader<TraceReader> limited(reader, this->checkpointAt - accesses);
+			if (!simulateTrace(limited, cache)) {
+				return false;
+			}
+			if (limited.getRemaining() != 0) {
+				cerr << "The trace ends before the checkpoint" << endl;
+				return false;
+			}
+			if (!this->save(cache, reader, kind, this->checkpointAt)) {
+				return false;
+			}
+		}
+		return simulateTrace(reader, cache);
+	}
+};
+
+/**********************************************************************************************/
+
+bool simulateConfigFile(const char* path, const CacheConfig& config, CacheStats& stats) {
+	CacheSimulator sim(config);
+	AccessBatcher<CacheSimulator> batcher(sim);
+	bool ok = simulateTraceInput(path, batcher);
+	batcher.finish();
+	stats = sim.getStats();
+	return ok;
+}
+
+bool simulateCheckpointedFile(const char* path, const CacheConfig& config, const char* restorePath,
+							  const char* checkpointPath, uint64_t checkpointAt, CacheStats& stats) {
+	CheckpointRunner runner = {path, config, restorePath, checkpointPath, checkpointAt, stats};
+	return dispatchReplacementPolicy(config.replacement, runner);
+}
+
+bool simulateIntervalFile(const char* path, const CacheConfig& config, uint64_t intervalAccesses,
+						  uint64_t intervalCycles, CacheStats& stats) {
+	IntervalRunner runner = {path, config, intervalAccesses, intervalCycles, stats};
+	return dispatchReplacementPolicy(config.replacement, runner);
+}
+
+bool simulateSampledFile(const char* path, const CacheConfig& config, const SamplingConfig& sampling,
+						 SampledStats& stats) {
+	SampledRunner runner = {path, config, sampling, stats};
+	return dispatchReplacementPolicy(config.replacement, runner);
+}
+
+bool simulateTimedFile(const char* path, const CacheConfig& config, const TimingConfig& timing,
+					   CacheStats& stats, TimingStats& timingStats) {
+	TimingRunner runner = {path, config, timing, stats, timingStats};
+	return dispatchReplacementPolicy(config.replacement, runner);
+}
+
+bool simulateClassifiedFile(const char* path, const CacheConfig& config, CacheStats& stats,
+							ClassifyStats& classes) {
+	ClassifyRunner runner = {path, config, stats, classes};
+	return dispatchReplacementPolicy(config.replacement, runner);
+}
+
+/**********************************************************************************************/
+
+static bool isFilteredPath(const char* path) {
+	return !isStreamPath(path) && isFilteredTrace(path);
+}
+
+bool isValidRun(const char* path, const CacheConfig& config, const RunModes& modes) {
+	bool checkpoints = modes.restorePath != NULL || modes.checkpointPath != NULL;
+	bool sampling = modes.sampling.period != 0;
+	bool cores = modes.numCores != 0;
+	bool timing = modes.timing.L1MSHRs != 0;
+	bool intervals = modes.intervalAccesses != 0 || modes.intervalCycles != 0;
+	bool shards = modes.numShards != 1;
+	if (modes.numCores > MAX_CORES || (modes.intervalAccesses != 0 && modes.intervalCycles != 0)) {
+		return false;
+	}
+	// one mode at a time, but for checkpoints, which only run the default mode
+	if ((checkpoints && (sampling || cores || intervals || shards)) ||
+		(timing && (checkpoints || sampling || cores || intervals || shards)) ||
+		(sampling && (cores || shards || intervals)) || (cores && (shards || intervals)) ||
+		(intervals && shards)) {
+		return false;
+	}
+	// the multi core model has no prefetchers, victim caches, index functions, DRAM, TLBs or
+	// L1Is, shards run on clocks of their own and would each see a part of the blocks a
+	// prefetcher trains on, a victim cache holds, a DRAM bank serves or a TLB maps, and split
+	// the sets by the plain index
+	bool prefetching = config.L1Prefetch.kind != PREFETCH_NONE || config.L2Prefetch.kind != PREFETCH_NONE;
+	bool victim = config.victimEntries != VICTIM_OFF;
+	bool hashed = config.L1Indexing != INDEX_MODULO || config.L2Indexing != INDEX_MODULO;
+	bool dramModel = config.dram.channels != DRAM_OFF;
+	bool translation = config.tlb.L1Entries != TLB_OFF;
+	bool split = config.L1ISize != L1I_OFF;
+	if (((prefetching || victim || hashed || dramModel || translation || split) && cores) ||
+		((config.writeBufferDepth != WRITE_BUFFER_OFF || prefetching || victim || hashed || dramModel ||
+		  translation) && shards)) {
+		return false;
+	}
+	// the classifier shadows one L1
+	if (modes.classify && (checkpoints || sampling || cores || timing || intervals || shards || split)) {
+		return false;
+	}
+	// an L1-filtered trace only replays what gets past the L1, see filter.hpp
+	if (isFilteredPath(path) &&
+		(checkpoints || sampling || cores || timing || intervals || shards || modes.classify || victim ||
+		 config.L1Prefetch.kind != PREFETCH_NONE || translation)) {
+		return false;
+	}
+	return true;
+}
+
+bool simulateRun(const char* path, const CacheConfig& config, const RunModes& modes, RunResults& results) {
+	results.stats = CacheStats();
+	if (modes.sampling.period != 0) {
+		if (!simulateSampledFile(path, config, modes.sampling, results.sampled)) {
+			return false;
+		}
+		if (results.sampled.samples.empty()) {
+			cerr << "The trace is shorter than one sampling period" << endl;
+			return false;
+		}
+		for (size_t sample = 0; sample < results.sampled.samples.size(); sample++) {
+			results.stats += results.sampled.samples[sample];
+		}
+		return true;
+	}
+	if (modes.numCores != 0) {
+		if (!simulateMultiCoreFile(path, config, modes.numCores, results.multiCore)) {
+			return false;
+		}
+		results.stats = results.multiCore.total;
+		return true;
+	}
+	if (modes.timing.L1MSHRs != 0) {
+		return simulateTimedFile(path, config, modes.timing, results.stats, results.timing);
+	}
+	if (modes.classify) {
+		return simulateClassifiedFile(path, config, results.stats, results.classes);
+	}
+	if (modes.restorePath != NULL || modes.checkpointPath != NULL) {
+		return simulateCheckpointedFile(path, config, modes.restorePath, modes.checkpointPath,
+										modes.checkpointAt, results.stats);
+	}
+	if (modes.intervalAccesses != 0 || modes.intervalCycles != 0) {
+		return simulateIntervalFile(path, config, modes.intervalAccesses, modes.intervalCycles,
+									results.stats);
+	}
+	if (isFilteredPath(path)) {
+		return simulateFilteredFile(path, config, results.stats);
+	}
+	if (modes.numShards != 1) {
+		TraceImage trace;
+		if (!trace.load(path)) {
+			return false;
+		}
+		results.stats = simulateSharded(trace, config, modes.numShards);
+		return true;
+	}
+	return simulateConfigFile(path, config, results.stats);
+}
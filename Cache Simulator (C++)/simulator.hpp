@@ -0,0 +1,183 @@
+#ifndef SIMULATOR_HPP
+#define SIMULATOR_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "cacheSim.hpp"
+#include "classify.hpp"
+#include "coherence.hpp"
+#include "filter.hpp"
+#include "sampling.hpp"
+#include "timing.hpp"
+
+using  namespace std;
+
+// The library interface, built into libcachesim.a and libcachesim.so by `make lib`. A program
+// that produces accesses as it runs (a tracer, an emulator) links the library, builds a
+// CacheSimulator from a CacheConfig and pushes its accesses one at a time or, faster, in
+// batches. The replacement policy is picked at run time from the config. Trace files run
+// through simulateRun, with the modes of the command line.
+// This is not a stable ABI: CacheConfig and CacheStats are plain structs that grow with the
+// simulator, and cacheSim.hpp comes along with them. A program is rebuilt against the
+// simulator.hpp of the library it links, and the CacheSimulator constructor ends one built
+// against another layout instead of reading a CacheConfig of the wrong size. A config started
+// from defaultCacheConfig and filled in by field name keeps that rebuild a recompile, the
+// fields added in between come out off.
+#define ACCESS_BATCH_SIZE 1024 // accesses AccessBatcher collects per accessBatch call
+// The CacheConfig and CacheStats layout a program was compiled with
+#define CACHESIM_LAYOUT (((size_t)sizeof(CacheConfig) << 16) | sizeof(CacheStats))
+
+class CacheModel; // the BasicCache behind a CacheSimulator, see simulator.cpp
+
+class CacheSimulator {
+private:
+    CacheModel* model;
+    CacheSimulator(const CacheSimulator&) = delete;
+    CacheSimulator& operator=(const CacheSimulator&) = delete;
+public:
+    // config has to pass isValidConfig. layout is left to its default, a layout other than the
+    // library's ends the program.
+    explicit CacheSimulator(const CacheConfig& config, size_t layout = CACHESIM_LAYOUT);
+    ~CacheSimulator();
+    // false for a geometry or an option the simulator cannot build
+    static bool isValidConfig(const CacheConfig& config);
+    void readFromCache(uint64_t address);
+    void writeToCache(uint64_t address);
+    void fetchFromCache(uint64_t address);
+    // operations[i] is ACCESS_READ, ACCESS_WRITE or ACCESS_FETCH, see BasicCache::accessBatch
+    bool accessBatch(const uint64_t* addresses, const uint8_t* operations, size_t count);
+    CacheStats getStats();
+};
+
+// Every size, associativity and latency 0, LRU, modulo indexing and every optional model
+// (write buffer, prefetchers, victim cache, DRAM, TLB, L1I) off
+inline CacheConfig defaultCacheConfig() {
+	CacheConfig config = CacheConfig();
+	config.replacement = REPLACEMENT_LRU;
+	config.writeBufferDepth = WRITE_BUFFER_OFF;
+	config.L1Prefetch.kind = config.L2Prefetch.kind = PREFETCH_NONE;
+	config.victimEntries = VICTIM_OFF;
+	config.L1Indexing = config.L2Indexing = INDEX_MODULO;
+	config.dram.channels = DRAM_OFF;
+	config.tlb.L1Entries = TLB_OFF;
+	config.L1ISize = L1I_OFF;
+	return config;
+}
+
+// The run modes of the command line, all off in defaultRunModes. At most one of them runs,
+// besides checkpoints, which go with the default mode only.
+struct RunModes {
+    const char* restorePath; // NULL for none, see simulateCheckpointedFile
+    const char* checkpointPath; // NULL for none, saved after checkpointAt accesses
+    uint64_t checkpointAt;
+    SamplingConfig sampling; // period 0 for none, see sampling.hpp
+    unsigned int numCores; // 0 for one core, private L1s over the shared L2, see coherence.hpp
+    TimingConfig timing; // 0 L1MSHRs for the serial model, see timing.hpp
+    bool classify; // the 3C miss classes, see classify.hpp
+    uint64_t intervalAccesses, intervalCycles; // 0 for none, see interval.hpp
+    unsigned int numShards; // 1 for none, 0 for one per hardware thread, see shard.hpp
+};
+
+// What simulateRun filled in besides stats, by mode
+struct RunResults {
+    CacheStats stats; // every mode, the sample totals of a sampled run
+    SampledStats sampled;
+    MultiCoreStats multiCore;
+    TimingStats timing;
+    ClassifyStats classes;
+};
+
+inline RunModes defaultRunModes() {
+	RunModes modes = RunModes();
+	modes.restorePath = modes.checkpointPath = NULL;
+	modes.sampling.warmFastForward = true;
+	modes.timing.issueCycles = 1;
+	modes.numShards = 1;
+	return modes;
+}
+
+// false if the modes cannot run together, or not with the models config turns on or with the
+// trace at path (an L1-filtered one, see filter.hpp)
+bool isValidRun(const char* path, const CacheConfig& config, const RunModes& modes);
+
+// simulate the trace at path in the mode modes picks (see isValidRun) or, with none, like
+// simulateConfigFile. Interval runs print their JSON lines as they go. Prints why and
+// returns false on errors.
+bool simulateRun(const char* path, const CacheConfig& config, const RunModes& modes, RunResults& results);
+
+// Collects the accesses of a trace driver (see simulateTrace) into batches for a simulator
+// with accessBatch. finish() passes on the last, partial batch.
+template <class Simulator>
+class AccessBatcher {
+private:
+    Simulator& sim;
+    uint64_t addresses[ACCESS_BATCH_SIZE];
+    uint8_t operations[ACCESS_BATCH_SIZE];
+    size_t count;
+public:
+    explicit AccessBatcher(Simulator& sim) : sim(sim), count(0) {}
+    void readFromCache(uint64_t address);
+    void writeToCache(uint64_t address);
+    void fetchFromCache(uint64_t address);
+    void finish();
+};
+
+// simulate the trace at path (a binary or text file, or a stream, see stream.hpp) with a
+// CacheSimulator built from config, fills stats and returns false on a trace error
+bool simulateConfigFile(const char* path, const CacheConfig& config, CacheStats& stats);
+
+// simulateConfigFile that starts from the checkpoint at restorePath and saves one to
+// checkpointPath after checkpointAt accesses of the trace, either path NULL for none (see
+// checkpoint.hpp). Prints why and returns false if the checkpoint does not fit config or the
+// trace.
+bool simulateCheckpointedFile(const char* path, const CacheConfig& config, const char* restorePath,
+							  const char* checkpointPath, uint64_t checkpointAt, CacheStats& stats);
+
+// simulateConfigFile with the modes of simulateRun, each printing the reason of an error
+bool simulateIntervalFile(const char* path, const CacheConfig& config, uint64_t intervalAccesses,
+						  uint64_t intervalCycles, CacheStats& stats);
+bool simulateSampledFile(const char* path, const CacheConfig& config, const SamplingConfig& sampling,
+						 SampledStats& stats);
+bool simulateTimedFile(const char* path, const CacheConfig& config, const TimingConfig& timing,
+					   CacheStats& stats, TimingStats& timingStats);
+bool simulateClassifiedFile(const char* path, const CacheConfig& config, CacheStats& stats,
+							ClassifyStats& classes);
+
+/**********************************************************************************************/
+// AccessBatcher definitions
+
+template <class Simulator>
+inline void AccessBatcher<Simulator>::readFromCache(uint64_t address) {
+	this->addresses[this->count] = address;
+	this->operations[this->count] = ACCESS_READ;
+	if (++this->count == ACCESS_BATCH_SIZE) {
+		this->finish();
+	}
+}
+
+template <class Simulator>
+inline void AccessBatcher<Simulator>::writeToCache(uint64_t address) {
+	this->addresses[this->count] = address;
+	this->operations[this->count] = ACCESS_WRITE;
+	if (++this->count == ACCESS_BATCH_SIZE) {
+		this->finish();
+	}
+}
+
+template <class Simulator>
+inline void AccessBatcher<Simulator>::fetchFromCache(uint64_t address) {
+	this->addresses[this->count] = address;
+	this->operations[this->count] = ACCESS_FETCH;
+	if (++this->count == ACCESS_BATCH_SIZE) {
+		this->finish();
+	}
+}
+
+template <class Simulator>
+void AccessBatcher<Simulator>::finish() {
+	this->sim.accessBatch(this->addresses, this->operations, this->count);
+	this->count = 0;
+}
+
+#endif // SIMULATOR_HPP
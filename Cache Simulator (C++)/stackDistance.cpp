@@ -0,0 +1,180 @@
+#include "stackDistance.hpp"
+
+#include <cstdio>
+
+#define MIN_SET_CAPACITY 16
+
+/**********************************************************************************************/
+// StackDistanceSet definitions
+StackDistanceSet::StackDistanceSet() : clock(0), live(0) {
+}
+
+void StackDistanceSet::add(uint32_t time, int delta) {
+	for (uint32_t i = time + 1; i <= this->mark.size(); i += i & (0 - i)) {
+		this->tree[i] += delta;
+	}
+}
+
+uint32_t StackDistanceSet::prefix(uint32_t time) {
+	// number of marked timestamps in [0, time]
+	uint32_t sum = 0;
+	for (uint32_t i = time + 1; i > 0; i -= i & (0 - i)) {
+		sum += this->tree[i];
+	}
+	return sum;
+}
+
+void StackDistanceSet::rebuild(vector<uint32_t>& lastUse) {
+	// renumber the live timestamps to 0..n-1 and leave room for as many new ones
+	uint32_t n = 0;
+	for (uint32_t time = 0; time < this->clock; time++) {
+		if (this->mark[time]) {
+			this->blockAt[n] = this->blockAt[time];
+			lastUse[this->blockAt[n]] = n;
+			n++;
+		}
+	}
+	uint32_t capacity = 2 * (n + 1);
+	if (capacity < MIN_SET_CAPACITY) {
+		capacity = MIN_SET_CAPACITY;
+	}
+	this->blockAt.resize(capacity);
+	this->mark.assign(capacity, 0);
+	this->tree.assign(capacity + 1, 0);
+	for (uint32_t time = 0; time < n; time++) {
+		this->mark[time] = 1;
+		this->tree[time + 1] = 1;
+	}
+	// linear time Fenwick construction
+	for (uint32_t i = 1; i <= capacity; i++) {
+		uint32_t parent = i + (i & (0 - i));
+		if (parent <= capacity) {
+			this->tree[parent] += this->tree[i];
+		}
+	}
+	this->clock = n;
+}
+
+uint32_t StackDistanceSet::access(uint32_t blockId, vector<uint32_t>& lastUse) {
+	uint32_t distance = COLD_DISTANCE;
+	if (lastUse[blockId] != COLD_DISTANCE) {
+		// distinct blocks touched after the previous access to block
+		uint32_t time = lastUse[blockId];
+		distance = this->live - this->prefix(time);
+		this->mark[time] = 0;
+		this->add(time, -1);
+	} else {
+		this->live++;
+	}
+	if (this->clock == this->mark.size()) {
+		this->rebuild(lastUse);
+	}
+	this->mark[this->clock] = 1;
+	this->blockAt[this->clock] = blockId;
+	this->add(this->clock, 1);
+	lastUse[blockId] = this->clock++;
+	return distance;
+}
+
+/**********************************************************************************************/
+// StackDistanceLevel definitions
+StackDistanceLevel::StackDistanceLevel(unsigned int indexBits, unsigned int maxWays) :
+		indexBits(indexBits), maxWays(maxWays), sets((size_t)1 << indexBits),
+		histogram(maxWays + 1, 0) {
+}
+
+void StackDistanceLevel::access(uint64_t block, uint32_t blockId) {
+	if (blockId == this->lastUse.size()) {
+		this->lastUse.push_back(COLD_DISTANCE);
+	}
+	uint64_t set = block & (((uint64_t)1 << this->indexBits) - 1);
+	uint32_t distance = this->sets[set].access(blockId, this->lastUse);
+	if (distance > this->maxWays) {
+		distance = this->maxWays;
+	}
+	this->histogram[distance]++;
+}
+
+uint64_t StackDistanceLevel::getMisses(unsigned int ways) {
+	uint64_t misses = 0;
+	for (unsigned int distance = ways; distance <= this->maxWays; distance++) {
+		misses += this->histogram[distance];
+	}
+	return misses;
+}
+
+/**********************************************************************************************/
+// StackDistanceProfiler definitions
+StackDistanceProfiler::StackDistanceProfiler(unsigned int BSize, unsigned int minSize,
+		unsigned int maxSize, unsigned int maxAssoc) : BSize(BSize), minSize(minSize),
+		maxSize(maxSize), maxAssoc(maxAssoc), accesses(0) {
+	for (unsigned int indexBits = 0; indexBits + BSize <= maxSize; indexBits++) {
+		unsigned int assoc = maxSize - BSize - indexBits;
+		if (assoc > maxAssoc) {
+			assoc = maxAssoc;
+		}
+		this->levels.push_back(StackDistanceLevel(indexBits, 1u << assoc));
+	}
+}
+
+void StackDistanceProfiler::readFromCache(uint64_t address) {
+	uint64_t block = address >> this->BSize;
+	this->accesses++;
+	// new blocks get the next id, so every level sees ids in order
+	uint32_t blockId = this->blockIds.insert(make_pair(block, (uint32_t)this->blockIds.size())).first->second;
+	for (size_t i = 0; i < this->levels.size(); i++) {
+		this->levels[i].access(block, blockId);
+	}
+}
+
+void StackDistanceProfiler::writeToCache(uint64_t address) {
+	// every access allocates, so a write moves the stack like a read
+	this->readFromCache(address);
+}
+
+void StackDistanceProfiler::fetchFromCache(uint64_t address) {
+	// one stack for instructions and data, as in a unified L1
+	this->readFromCache(address);
+}
+
+uint64_t StackDistanceProfiler::getAccesses() {
+	return this->accesses;
+}
+
+uint64_t StackDistanceProfiler::getMisses(unsigned int size, unsigned int assoc) {
+	return this->levels[size - this->BSize - assoc].getMisses(1u << assoc);
+}
+
+bool StackDistanceProfiler::writeCSV(const string& path) {
+	FILE* out = fopen(path.c_str(), "w");
+	if (out == nullptr) {
+		return false;
+	}
+	fprintf(out, "l1_size,l1_assoc,l1_miss_rate,l2_size,l2_assoc,l2_miss_rate\n");
+	double accesses = this->accesses > 0 ? (double)this->accesses : 1.0;
+	for (unsigned int L1Size = this->minSize; L1Size <= this->maxSize; L1Size++) {
+		for (unsigned int L1Assoc = 0; L1Assoc <= this->maxAssoc && L1Assoc + this->BSize <= L1Size; L1Assoc++) {
+			uint64_t L1Misses = this->getMisses(L1Size, L1Assoc);
+			double L1MissRate = L1Misses / accesses;
+			unsigned int L1IndexBits = L1Size - this->BSize - L1Assoc;
+			bool anyL2 = false;
+			// L2 must hold L1 for the inclusion property: larger, at least as many sets and ways
+			for (unsigned int L2Size = L1Size + 1; L2Size <= this->maxSize; L2Size++) {
+				for (unsigned int L2Assoc = L1Assoc; L2Assoc <= this->maxAssoc && L2Assoc + this->BSize <= L2Size; L2Assoc++) {
+					if (L2Size - this->BSize - L2Assoc < L1IndexBits) {
+						continue;
+					}
+					uint64_t L2Misses = this->getMisses(L2Size, L2Assoc);
+					double L2MissRate = L1Misses > 0 ? (double)L2Misses / L1Misses : 0.0;
+					fprintf(out, "%u,%u,%.6f,%u,%u,%.6f\n", L1Size, L1Assoc, L1MissRate,
+							L2Size, L2Assoc, L2MissRate);
+					anyL2 = true;
+				}
+			}
+			if (!anyL2) {
+				fprintf(out, "%u,%u,%.6f,,,\n", L1Size, L1Assoc, L1MissRate);
+			}
+		}
+	}
+	return fclose(out) == 0;
+}
@@ -0,0 +1,80 @@
+#ifndef STACK_DISTANCE_HPP
+#define STACK_DISTANCE_HPP
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <stdint.h>
+
+using  namespace std;
+
+#define COLD_DISTANCE ((uint32_t)-1)
+
+// Single pass miss rates for a whole range of cache geometries (Mattson et al. 1970).
+// For every number of index bits the profiler keeps a per-set LRU stack distance histogram.
+// The distance of an access is the number of distinct blocks of the same set touched since
+// the previous access to its block, so an access hits in an LRU cache with W ways iff its
+// distance is below W, and one histogram answers every associativity with that set count.
+//
+// Distances are counted with a Fenwick tree over per-set timestamps, where a 1 marks the
+// latest access of each block, giving O(log n) per access and index width. Blocks are
+// numbered once on first sight so the per-width state is plain arrays indexed by that id.
+//
+// Like any stack algorithm this assumes every access allocates (write allocate), and L2 is
+// modeled as an inclusive level whose LRU order sees all references. The L2 rate reported
+// for a pair of levels is the local one: global L2 misses over L1 misses.
+
+// LRU stack of one set
+class StackDistanceSet {
+private:
+    vector<uint32_t> tree; // Fenwick tree over timestamps, 1-based
+    vector<uint8_t> mark; // 1 at the latest timestamp of every live block
+    vector<uint32_t> blockAt; // block id accessed at each timestamp
+    uint32_t clock; // next timestamp
+    uint32_t live; // number of distinct blocks seen
+    void add(uint32_t time, int delta);
+    uint32_t prefix(uint32_t time);
+    void rebuild(vector<uint32_t>& lastUse);
+public:
+    StackDistanceSet();
+    // returns the stack distance of block, COLD_DISTANCE for a first access.
+    // lastUse maps block ids to their latest timestamp inside their set.
+    uint32_t access(uint32_t blockId, vector<uint32_t>& lastUse);
+};
+
+// Stack distances of every set for one index width
+class StackDistanceLevel {
+private:
+    unsigned int indexBits;
+    unsigned int maxWays; // distances >= maxWays are only counted as misses
+    vector<StackDistanceSet> sets;
+    vector<uint32_t> lastUse; // block id -> timestamp inside its set
+    vector<uint64_t> histogram; // [maxWays] holds the far and cold accesses
+public:
+    StackDistanceLevel(unsigned int indexBits, unsigned int maxWays);
+    void access(uint64_t block, uint32_t blockId);
+    uint64_t getMisses(unsigned int ways);
+};
+
+class StackDistanceProfiler {
+private:
+    unsigned int BSize; // Block size in bytes (given in log2)
+    unsigned int minSize, maxSize; // smallest and largest cache size in bytes (given in log2)
+    unsigned int maxAssoc; // largest associativity (given in log2)
+    uint64_t accesses;
+    unordered_map<uint64_t, uint32_t> blockIds; // block -> dense id
+    vector<StackDistanceLevel> levels; // one per index width, levels[i] has i index bits
+public:
+    StackDistanceProfiler(unsigned int BSize, unsigned int minSize, unsigned int maxSize,
+            unsigned int maxAssoc);
+    void readFromCache(uint64_t address);
+    void writeToCache(uint64_t address);
+    void fetchFromCache(uint64_t address);
+    uint64_t getAccesses();
+    // misses of a single LRU level of 2^size bytes and 2^assoc ways
+    uint64_t getMisses(unsigned int size, unsigned int assoc);
+    // write the miss rate surface of every L1/L2 pair to path, returns false on error
+    bool writeCSV(const string& path);
+};
+
+#endif // STACK_DISTANCE_HPP
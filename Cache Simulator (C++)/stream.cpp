@@ -0,0 +1,248 @@
+#include "stream.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**********************************************************************************************/
+// StreamTraceReader definitions
+StreamTraceReader::StreamTraceReader(const char* path) : fd(-1), ownsFd(false), decompressor(nullptr),
+														 slots(nullptr), head(0), tail(0), stopping(false),
+														 current(nullptr), cursor(0) {
+	if (string(path) == "-") {
+		this->fd = STDIN_FILENO;
+	} else {
+		this->fd = open(path, O_RDONLY | O_CLOEXEC);
+		this->ownsFd = true;
+	}
+	if (this->fd < 0) {
+		return;
+	}
+	struct stat st;
+	TraceCompression compression = COMPRESSION_NONE;
+	if (this->ownsFd && fstat(this->fd, &st) == 0 && S_ISREG(st.st_mode)) {
+		compression = traceCompression(path);
+	}
+	if (compression != COMPRESSION_NONE) {
+		this->decompressor = new Decompressor(this->fd, compression);
+		if (!this->decompressor->isOpen()) {
+			delete this->decompressor;
+			this->decompressor = nullptr;
+			close(this->fd);
+			this->fd = -1;
+			return;
+		}
+	}
+	this->slots = new TraceBatch[STREAM_SLOTS];
+	this->reader = thread(&StreamTraceReader::readLoop, this);
+}
+
+StreamTraceReader::~StreamTraceReader() {
+	if (this->reader.joinable()) {
+		// wake the reader thread if it waits for a free slot, it checks stopping between reads
+		{
+			lock_guard<mutex> guard(this->lock);
+			this->stopping = true;
+		}
+		this->notFull.notify_all();
+		if (this->decompressor != nullptr) {
+			this->decompressor->stop();
+		}
+		this->reader.join();
+	}
+	delete this->decompressor;
+	if (this->ownsFd && this->fd >= 0) {
+		close(this->fd);
+	}
+	delete[] this->slots;
+}
+
+bool StreamTraceReader::isOpen() {
+	return this->fd >= 0;
+}
+
+// read up to size bytes, returns 0 at the end of the input and -1 on errors or when stopping
+long StreamTraceReader::readSome(char* buffer, size_t size) {
+	if (this->decompressor != nullptr) {
+		return this->decompressor->read(buffer, size);
+	}
+	struct pollfd request = {this->fd, POLLIN, 0};
+	while (!this->stopping) {
+		int ready = poll(&request, 1, 100);
+		if (ready < 0 && errno != EINTR) {
+			return -1;
+		}
+		if (ready <= 0) {
+			continue;
+		}
+		ssize_t got = read(this->fd, buffer, size);
+		if (got >= 0) {
+			return got;
+		}
+		if (errno != EINTR && errno != EAGAIN) {
+			return -1;
+		}
+	}
+	return -1;
+}
+
+TraceBatch* StreamTraceReader::acquireSlot() {
+	unique_lock<mutex> guard(this->lock);
+	while (this->tail - this->head == STREAM_SLOTS && !this->stopping) {
+		this->notFull.wait(guard);
+	}
+	if (this->stopping) {
+		return nullptr;
+	}
+	TraceBatch* batch = &this->slots[this->tail % STREAM_SLOTS];
+	batch->count = 0;
+	batch->status = TRACE_OK;
+	return batch;
+}
+
+void StreamTraceReader::publish() {
+	{
+		lock_guard<mutex> guard(this->lock);
+		this->tail++;
+	}
+	this->notEmpty.notify_one();
+}
+
+void StreamTraceReader::readLoop() {
+	// unparsed bytes (an unfinished line or record) stay at the front of buffer
+	vector<char> buffer(2 * STREAM_READ_SIZE);
+	size_t used = 0;
+	bool detected = false, binary = false;
+	uint16_t flags = 0; // of a binary header
+	uint64_t lastAddress = 0;
+	TraceStatus status = TRACE_OK;
+	TraceBatch* batch = this->acquireSlot();
+	while (batch != nullptr && status == TRACE_OK) {
+		size_t room = min((size_t)STREAM_READ_SIZE, buffer.size() - used);
+		long got = this->readSome(buffer.data() + used, room);
+		if (got < 0 && this->stopping) {
+			return;
+		}
+		if (got < 0 && this->decompressor != nullptr) {
+			status = TRACE_FORMAT_ERROR; // corrupt compressed input
+			break;
+		}
+		bool atEnd = got <= 0;
+		used += atEnd ? 0 : got;
+		const char* p = buffer.data();
+		const char* end = p + used;
+
+		// the format is known once a full binary header could have arrived
+		if (!detected) {
+			if (used < sizeof(TraceHeader) && !atEnd) {
+				continue;
+			}
+			detected = true;
+			uint32_t magic = 0;
+			if (used >= sizeof(magic)) {
+				memcpy(&magic, p, sizeof(magic));
+			}
+			if (magic == TRACE_MAGIC) {
+				// the access count is not used, a live writer cannot fill it in
+				TraceHeader header;
+				if (used < sizeof(header)) {
+					status = TRACE_FORMAT_ERROR;
+					break;
+				}
+				memcpy(&header, p, sizeof(header));
+				if (header.version != TRACE_VERSION) {
+					status = TRACE_FORMAT_ERROR;
+					break;
+				}
+				binary = true;
+				flags = header.flags;
+				p += sizeof(header);
+			}
+		}
+
+		while (p != end && status == TRACE_OK) {
+			TraceAccess& access = batch->accesses[batch->count];
+			if (binary) {
+				const uint8_t* record = (const uint8_t*)p;
+				status = decodeTraceRecord(record, (const uint8_t*)end, access, lastAddress, flags);
+				if (status == TRACE_END) {
+					// cut off by the end of this read, finish it after the next one
+					status = atEnd ? TRACE_FORMAT_ERROR : TRACE_OK;
+					break;
+				}
+				p = (const char*)record;
+			} else {
+				const char* newline = (const char*)memchr(p, '\n', end - p);
+				if (newline == nullptr && !atEnd) {
+					break;
+				}
+				const char* lineEnd = newline != nullptr ? newline : end;
+				if (!parseTraceLine(p, lineEnd, access)) {
+					status = TRACE_FORMAT_ERROR;
+					break;
+				}
+				p = newline != nullptr ? newline + 1 : end;
+			}
+			if (status == TRACE_OK && ++batch->count == STREAM_BATCH) {
+				this->publish();
+				batch = this->acquireSlot();
+				if (batch == nullptr) {
+					return;
+				}
+			}
+		}
+		used = end - p;
+		memmove(buffer.data(), p, used);
+		if (status == TRACE_OK && used == buffer.size()) {
+			status = TRACE_FORMAT_ERROR; // a line longer than the whole buffer
+		}
+		if (status == TRACE_OK && atEnd) {
+			status = TRACE_END;
+		}
+		if (status == TRACE_OK && batch->count > 0) {
+			this->publish();
+			batch = this->acquireSlot();
+		}
+	}
+	if (batch != nullptr) {
+		batch->status = status;
+		this->publish();
+	}
+}
+
+TraceStatus StreamTraceReader::refill(TraceAccess& access) {
+	unique_lock<mutex> guard(this->lock);
+	while (true) {
+		if (this->current != nullptr) {
+			if (this->current->status != TRACE_OK) {
+				return this->current->status;
+			}
+			// hand the finished batch back to the reader thread
+			this->head++;
+			this->notFull.notify_one();
+		}
+		while (this->head == this->tail) {
+			this->notEmpty.wait(guard);
+		}
+		this->current = &this->slots[this->head % STREAM_SLOTS];
+		this->cursor = 0;
+		if (this->current->count > 0) {
+			access = this->current->accesses[this->cursor++];
+			return TRACE_OK;
+		}
+	}
+}
+
+/**********************************************************************************************/
+
+bool isStreamPath(const char* path) {
+	if (string(path) == "-") {
+		return true;
+	}
+	// only regular files are probed, reading a pipe would take its first bytes away
+	struct stat st;
+	return stat(path, &st) == 0 && (!S_ISREG(st.st_mode) || traceCompression(path) != COMPRESSION_NONE);
+}
@@ -0,0 +1,93 @@
+#ifndef STREAM_HPP
+#define STREAM_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <stdint.h>
+
+#include "decompress.hpp"
+#include "trace.hpp"
+
+using  namespace std;
+
+// Traces that cannot be mapped or read twice: stdin ("-"), FIFOs and other pipes, and
+// compressed files, which come out of a Decompressor (decompress.hpp) instead of the descriptor.
+//
+// A reader thread pulls bytes off the file descriptor, detects the format from the first
+// bytes (binary magic or text), parses them and publishes the accesses in batches through a
+// bounded ring of STREAM_SLOTS slots, so parsing overlaps the simulation and never runs more
+// than STREAM_SLOTS batches ahead of it. A batch is published when it is full or when a read
+// has been parsed, so a slow live producer is simulated as its accesses arrive.
+#define STREAM_BATCH 4096 // accesses per ring slot
+#define STREAM_SLOTS 16
+#define STREAM_READ_SIZE (1 << 16) // bytes asked from the descriptor per read
+
+struct TraceBatch {
+    TraceAccess accesses[STREAM_BATCH];
+    size_t count;
+    TraceStatus status; // TRACE_OK, or how the stream ends after the accesses of this batch
+};
+
+class StreamTraceReader {
+private:
+    int fd;
+    bool ownsFd;
+    Decompressor* decompressor; // nullptr for uncompressed input
+    TraceBatch* slots;
+    uint64_t head, tail; // batches consumed and published so far, guarded by lock
+    mutex lock;
+    condition_variable notEmpty, notFull;
+    atomic<bool> stopping;
+    thread reader;
+    TraceBatch* current; // batch being consumed, nullptr before the first one
+    size_t cursor;
+    StreamTraceReader(const StreamTraceReader&) = delete;
+    StreamTraceReader& operator=(const StreamTraceReader&) = delete;
+    // reader thread side
+    void readLoop();
+    long readSome(char* buffer, size_t size);
+    TraceBatch* acquireSlot();
+    void publish();
+    // simulation thread side
+    TraceStatus refill(TraceAccess& access);
+public:
+    // path "-" reads stdin
+    StreamTraceReader(const char* path);
+    ~StreamTraceReader();
+    bool isOpen();
+    TraceStatus next(TraceAccess& access);
+    // a stream has no offsets, positions are reached by reading up to them
+    bool tell(TracePosition&) { return false; }
+    bool seek(const TracePosition&) { return false; }
+};
+
+// true for "-", for anything that exists but is not a regular file, and for compressed files
+bool isStreamPath(const char* path);
+
+// simulateTraceFile that also takes stdin and pipes, reading those through a StreamTraceReader
+template <class Simulator>
+bool simulateTraceInput(const char* path, Simulator& sim) {
+	if (!isStreamPath(path)) {
+		return simulateTraceFile(path, sim);
+	}
+	StreamTraceReader reader(path);
+	if (!reader.isOpen()) {
+		cerr << "File not found" << endl;
+		return false;
+	}
+	return simulateTrace(reader, sim);
+}
+
+/**********************************************************************************************/
+
+inline TraceStatus StreamTraceReader::next(TraceAccess& access) {
+	if (this->current == nullptr || this->cursor == this->current->count) {
+		return this->refill(access);
+	}
+	access = this->current->accesses[this->cursor++];
+	return TRACE_OK;
+}
+
+#endif // STREAM_HPP
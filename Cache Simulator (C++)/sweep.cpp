@@ -0,0 +1,135 @@
+#include "sweep.hpp"
+#include "simulator.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+/**********************************************************************************************/
+// Sweep definitions
+unsigned int Sweep::addGrid(const vector<unsigned int> lists[9],
+						   const vector<ReplacementPolicyKind>& policies) {
+	unsigned int skipped = 0;
+	size_t total = policies.size();
+	for (int i = 0; i < 9; i++) {
+		total *= lists[i].size();
+	}
+	for (size_t point = 0; point < total; point++) {
+		// decode point as a mixed radix number, one digit per parameter
+		unsigned int values[9];
+		size_t rest = point;
+		for (int i = 8; i >= 0; i--) {
+			values[i] = lists[i][rest % lists[i].size()];
+			rest /= lists[i].size();
+		}
+		CacheConfig config = defaultCacheConfig();
+		config.MemCyc = values[0];
+		config.BSize = values[1];
+		config.L1Size = values[2];
+		config.L2Size = values[3];
+		config.L1Assoc = values[4];
+		config.L2Assoc = values[5];
+		config.L1Cyc = values[6];
+		config.L2Cyc = values[7];
+		config.WrAlloc = values[8];
+		config.replacement = policies[rest];
+		// every level needs at least one set
+		if (config.L1Size < config.BSize + config.L1Assoc || config.L2Size < config.BSize + config.L2Assoc) {
+			skipped++;
+			continue;
+		}
+		this->configs.push_back(config);
+	}
+	return skipped;
+}
+
+size_t Sweep::getNumConfigs() {
+	return this->configs.size();
+}
+
+template <class Simulate>
+void Sweep::runConfigs(Simulate simulate, unsigned int numThreads) {
+	if (numThreads == 0) {
+		numThreads = thread::hardware_concurrency();
+		if (numThreads == 0) {
+			numThreads = 1;
+		}
+	}
+	if (numThreads > this->configs.size()) {
+		numThreads = this->configs.size();
+	}
+	this->results.assign(this->configs.size(), SweepResult());
+	atomic<size_t> nextConfig(0);
+	vector<thread> workers;
+	for (unsigned int t = 0; t < numThreads; t++) {
+		workers.push_back(thread([this, &simulate, &nextConfig]() {
+			size_t i;
+			while ((i = nextConfig.fetch_add(1)) < this->configs.size()) {
+				const CacheConfig& c = this->configs[i];
+				chrono::steady_clock::time_point start = chrono::steady_clock::now();
+				CacheStats stats;
+				simulate(c, stats);
+				double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+				SweepResult& result = this->results[i];
+				double accesses = (double)stats.L1Reads + stats.L1Writes;
+				result.config = c;
+				result.L1MissRate = (double)(stats.L1ReadMisses + stats.L1WriteMisses) / accesses;
+				result.L2MissRate = (double)(stats.L2ReadMisses + stats.L2WriteMisses) /
+									((double)stats.L2Reads + stats.L2Writes);
+				result.avgAccTime = ((double)stats.totalL1Cycles + stats.totalL2Cycles +
+									 stats.totalMemCycles) / accesses;
+				result.accessesPerSecond = seconds > 0 ? accesses / seconds : 0;
+			}
+		}));
+	}
+	for (size_t t = 0; t < workers.size(); t++) {
+		workers[t].join();
+	}
+}
+
+void Sweep::run(TraceImage& trace, unsigned int numThreads) {
+	this->runConfigs([&trace](const CacheConfig& c, CacheStats& stats) {
+		BinaryTraceReader reader(trace.getRecords(), trace.getRecordsEnd(), trace.getNumAccesses(),
+								 trace.getFlags());
+		simulateConfig(reader, c, stats);
+	}, numThreads);
+}
+
+unsigned int Sweep::keepReplayable(FilteredTraceReader& trace) {
+	vector<CacheConfig> replayable;
+	for (size_t i = 0; i < this->configs.size(); i++) {
+		if (isReplayableConfig(trace.getHeader(), this->configs[i])) {
+			replayable.push_back(this->configs[i]);
+		}
+	}
+	unsigned int dropped = this->configs.size() - replayable.size();
+	this->configs.swap(replayable);
+	return dropped;
+}
+
+void Sweep::run(FilteredTraceReader& trace, unsigned int numThreads) {
+	this->runConfigs([&trace](const CacheConfig& c, CacheStats& stats) {
+		FilteredTraceReader reader(trace.getHeader(), trace.getRecords(), trace.getRecordsEnd());
+		simulateFilteredConfig(reader, c, stats);
+	}, numThreads);
+}
+
+bool Sweep::writeCSV(const string& path) {
+	FILE* out = fopen(path.c_str(), "w");
+	if (out == nullptr) {
+		return false;
+	}
+	fprintf(out, "mem_cyc,bsize,l1_size,l2_size,l1_assoc,l2_assoc,l1_cyc,l2_cyc,wr_alloc,repl,"
+				 "l1_miss_rate,l2_miss_rate,acc_time_avg,accesses_per_sec\n");
+	for (size_t i = 0; i < this->results.size(); i++) {
+		const SweepResult& r = this->results[i];
+		const CacheConfig& c = r.config;
+		fprintf(out, "%u,%u,%u,%u,%u,%u,%u,%u,%u,%s,%.6f,%.6f,%.6f,%.0f\n", c.MemCyc, c.BSize,
+				c.L1Size, c.L2Size, c.L1Assoc, c.L2Assoc, c.L1Cyc, c.L2Cyc, c.WrAlloc,
+				replacementPolicyName(c.replacement),
+				r.L1MissRate, r.L2MissRate, r.avgAccTime, r.accessesPerSecond);
+	}
+	return fclose(out) == 0;
+}
@@ -0,0 +1,44 @@
+#ifndef SWEEP_HPP
+#define SWEEP_HPP
+
+#include <string>
+#include <vector>
+
+#include "cacheSim.hpp"
+#include "filter.hpp"
+#include "trace.hpp"
+
+using  namespace std;
+
+struct SweepResult {
+    CacheConfig config;
+    double L1MissRate;
+    double L2MissRate;
+    double avgAccTime;
+    double accessesPerSecond;
+};
+
+// Design space sweep: every configuration gets its own Cache and reads the same in-memory
+// trace image, configurations are handed out to a pool of worker threads one at a time.
+// An L1-filtered trace (see filter.hpp) is shared the same way, for sweeps of the L2.
+class Sweep {
+private:
+    vector<CacheConfig> configs;
+    vector<SweepResult> results;
+    // simulate(config, stats) for every configuration on numThreads threads
+    template <class Simulate>
+    void runConfigs(Simulate simulate, unsigned int numThreads);
+public:
+    // add the cartesian product of the value lists and policies, skipping impossible
+    // geometries. lists are given in the Cache constructor order.
+    unsigned int addGrid(const vector<unsigned int> lists[9], const vector<ReplacementPolicyKind>& policies);
+    size_t getNumConfigs();
+    // simulate every configuration, numThreads = 0 uses one thread per hardware thread
+    void run(TraceImage& trace, unsigned int numThreads);
+    // drop the configurations trace cannot be replayed with, returns how many
+    unsigned int keepReplayable(FilteredTraceReader& trace);
+    void run(FilteredTraceReader& trace, unsigned int numThreads);
+    bool writeCSV(const string& path);
+};
+
+#endif // SWEEP_HPP
@@ -0,0 +1,161 @@
+#include "synthetic.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#define SYNTHETIC_BLOCK 64 // bytes per block for the block based patterns
+#define SYNTHETIC_WORD 4
+
+// splitmix64, small and the same on every platform, unlike the <random> distributions
+static uint64_t nextRandom(uint64_t& state) {
+	uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+	return z ^ (z >> 31);
+}
+
+// uniform in [0, 1)
+static double nextUnit(uint64_t& state) {
+	return (double)(nextRandom(state) >> 11) / (double)((uint64_t)1 << 53);
+}
+
+static char nextOperation(uint64_t& state, double writeFraction) {
+	return nextUnit(state) < writeFraction ? 'w' : 'r';
+}
+
+static uint64_t greatestCommonDivisor(uint64_t a, uint64_t b) {
+	while (b != 0) {
+		uint64_t rest = a % b;
+		a = b;
+		b = rest;
+	}
+	return a;
+}
+
+static void generateZipf(const SyntheticConfig& config, uint64_t numBlocks, uint64_t& state,
+						 vector<TraceAccess>& accesses) {
+	// cumulative weights of the ranks, looked up by binary search
+	vector<double> cdf(numBlocks);
+	double sum = 0;
+	for (uint64_t rank = 0; rank < numBlocks; rank++) {
+		sum += 1.0 / pow((double)(rank + 1), ZIPF_SKEW);
+		cdf[rank] = sum;
+	}
+	// rank r lives at block (r * step) % numBlocks, a permutation for any step coprime to
+	// numBlocks
+	uint64_t step = 0x9E3779B1ull % numBlocks;
+	while (numBlocks > 1 && (step == 0 || greatestCommonDivisor(step, numBlocks) != 1)) {
+		step++;
+	}
+	for (uint64_t i = 0; i < config.numAccesses; i++) {
+		double target = nextUnit(state) * sum;
+		uint64_t rank = lower_bound(cdf.begin(), cdf.end(), target) - cdf.begin();
+		rank = min(rank, numBlocks - 1);
+		uint64_t block = (rank * step) % numBlocks;
+		TraceAccess access = {nextOperation(state, config.writeFraction), 0, block * SYNTHETIC_BLOCK};
+		accesses.push_back(access);
+	}
+}
+
+static void generateChase(const SyntheticConfig& config, uint64_t numBlocks, uint64_t& state,
+						  vector<TraceAccess>& accesses) {
+	// Sattolo's algorithm, a random permutation that is a single cycle
+	vector<uint64_t> next(numBlocks);
+	for (uint64_t block = 0; block < numBlocks; block++) {
+		next[block] = block;
+	}
+	for (uint64_t i = numBlocks - 1; i > 0; i--) {
+		swap(next[i], next[nextRandom(state) % i]);
+	}
+	uint64_t block = 0;
+	for (uint64_t i = 0; i < config.numAccesses; i++) {
+		TraceAccess access = {nextOperation(state, config.writeFraction), 0, block * SYNTHETIC_BLOCK};
+		accesses.push_back(access);
+		block = next[block];
+	}
+}
+
+static void generateTile(const SyntheticConfig& config, vector<TraceAccess>& accesses) {
+	// three n x n matrices of doubles, n a multiple of the tile size
+	uint64_t n = (uint64_t)sqrt((double)config.footprint / (3 * sizeof(double)));
+	n = max((uint64_t)TILE_SIZE, n / TILE_SIZE * TILE_SIZE);
+	uint64_t matrixBytes = n * n * sizeof(double);
+	uint64_t A = 0, B = matrixBytes, C = 2 * matrixBytes;
+	while (true) {
+		for (uint64_t ii = 0; ii < n; ii += TILE_SIZE) {
+			for (uint64_t jj = 0; jj < n; jj += TILE_SIZE) {
+				for (uint64_t kk = 0; kk < n; kk += TILE_SIZE) {
+					for (uint64_t i = ii; i < ii + TILE_SIZE; i++) {
+						for (uint64_t j = jj; j < jj + TILE_SIZE; j++) {
+							for (uint64_t k = kk; k < kk + TILE_SIZE; k++) {
+								TraceAccess a = {'r', 0, A + (i * n + k) * sizeof(double)};
+								TraceAccess b = {'r', 0, B + (k * n + j) * sizeof(double)};
+								accesses.push_back(a);
+								accesses.push_back(b);
+							}
+							TraceAccess c = {'w', 0, C + (i * n + j) * sizeof(double)};
+							accesses.push_back(c);
+							if (accesses.size() >= config.numAccesses) {
+								accesses.resize(config.numAccesses);
+								return;
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+void generateSyntheticTrace(const SyntheticConfig& config, vector<TraceAccess>& accesses) {
+	accesses.clear();
+	accesses.reserve(config.numAccesses + 2 * TILE_SIZE + 1); // tile overshoots by one row
+	uint64_t state = config.seed;
+	uint64_t numBlocks = max((uint64_t)1, config.footprint / SYNTHETIC_BLOCK);
+	uint64_t numWords = max((uint64_t)1, config.footprint / SYNTHETIC_WORD);
+	switch (config.pattern) {
+	case SYNTHETIC_SEQUENTIAL: {
+		uint64_t address = 0;
+		for (uint64_t i = 0; i < config.numAccesses; i++) {
+			TraceAccess access = {nextOperation(state, config.writeFraction), 0, address};
+			accesses.push_back(access);
+			address = (address + config.stride) % config.footprint;
+		}
+		break;
+	}
+	case SYNTHETIC_UNIFORM:
+		for (uint64_t i = 0; i < config.numAccesses; i++) {
+			uint64_t word = nextRandom(state) % numWords;
+			TraceAccess access = {nextOperation(state, config.writeFraction), 0, word * SYNTHETIC_WORD};
+			accesses.push_back(access);
+		}
+		break;
+	case SYNTHETIC_ZIPF:
+		generateZipf(config, numBlocks, state, accesses);
+		break;
+	case SYNTHETIC_CHASE:
+		generateChase(config, numBlocks, state, accesses);
+		break;
+	case SYNTHETIC_TILE:
+		generateTile(config, accesses);
+		break;
+	}
+}
+
+/**********************************************************************************************/
+
+static const char* patternNames[] = {"sequential", "uniform", "zipf", "chase", "tile"};
+
+bool parseSyntheticPattern(const string& name, SyntheticPattern& pattern) {
+	for (int i = 0; i < NUM_SYNTHETIC_PATTERNS; i++) {
+		if (name == patternNames[i]) {
+			pattern = (SyntheticPattern)i;
+			return true;
+		}
+	}
+	return false;
+}
+
+const char* syntheticPatternName(SyntheticPattern pattern) {
+	return patternNames[pattern];
+}
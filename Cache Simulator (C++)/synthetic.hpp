@@ -0,0 +1,75 @@
+#ifndef SYNTHETIC_HPP
+#define SYNTHETIC_HPP
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include "trace.hpp"
+
+using  namespace std;
+
+// Synthetic access patterns, generated into memory so the simulator can be timed without
+// any trace parsing. Every pattern touches `footprint` bytes from address 0 and is the same
+// on every run for the same seed:
+//   sequential - a walk with a fixed stride in bytes, wrapping around the footprint
+//   uniform    - uniformly random words
+//   zipf       - blocks drawn from a Zipfian distribution (skew ZIPF_SKEW), hot blocks are
+//                scattered over the footprint so they do not crowd a few sets
+//   chase      - a pointer chase through one random cycle over every block
+//   tile       - a tiled matrix multiply C += A * B over three square matrices of doubles,
+//                TILE_SIZE x TILE_SIZE tiles, C is written
+// Except for tile, writeFraction of the accesses are writes.
+#define ZIPF_SKEW 0.99
+#define TILE_SIZE 32
+
+enum SyntheticPattern {
+    SYNTHETIC_SEQUENTIAL = 0,
+    SYNTHETIC_UNIFORM = 1,
+    SYNTHETIC_ZIPF = 2,
+    SYNTHETIC_CHASE = 3,
+    SYNTHETIC_TILE = 4
+};
+#define NUM_SYNTHETIC_PATTERNS 5
+
+struct SyntheticConfig {
+    SyntheticPattern pattern;
+    uint64_t numAccesses;
+    uint64_t footprint; // bytes
+    unsigned int stride; // bytes, sequential only
+    double writeFraction;
+    uint64_t seed;
+};
+
+// "sequential", "uniform", "zipf", "chase" or "tile", returns false for anything else
+bool parseSyntheticPattern(const string& name, SyntheticPattern& pattern);
+const char* syntheticPatternName(SyntheticPattern pattern);
+
+// replace accesses with config.numAccesses accesses of the pattern
+void generateSyntheticTrace(const SyntheticConfig& config, vector<TraceAccess>& accesses);
+
+// Reads a generated trace, with the same next() as the file readers
+class MemoryTraceReader {
+private:
+    const TraceAccess* current;
+    const TraceAccess* end;
+public:
+    explicit MemoryTraceReader(const vector<TraceAccess>& accesses);
+    TraceStatus next(TraceAccess& access);
+};
+
+/**********************************************************************************************/
+
+inline MemoryTraceReader::MemoryTraceReader(const vector<TraceAccess>& accesses) :
+		current(accesses.data()), end(accesses.data() + accesses.size()) {
+}
+
+inline TraceStatus MemoryTraceReader::next(TraceAccess& access) {
+	if (this->current == this->end) {
+		return TRACE_END;
+	}
+	access = *this->current++;
+	return TRACE_OK;
+}
+
+#endif // SYNTHETIC_HPP
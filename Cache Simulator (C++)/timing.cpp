@@ -0,0 +1,17 @@
+#include "timing.hpp"
+
+uint64_t latencyPercentile(const vector<uint64_t>& histogram, uint64_t accesses, double fraction) {
+	// the latency of access number ceil(fraction * accesses) in increasing latency order
+	uint64_t rank = (uint64_t)(fraction * accesses + 0.999999);
+	if (rank == 0) {
+		rank = 1;
+	}
+	uint64_t seen = 0;
+	for (size_t latency = 0; latency < histogram.size(); latency++) {
+		seen += histogram[latency];
+		if (seen >= rank) {
+			return latency;
+		}
+	}
+	return 0;
+}
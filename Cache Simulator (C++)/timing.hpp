@@ -0,0 +1,223 @@
+#ifndef TIMING_HPP
+#define TIMING_HPP
+
+#include <vector>
+#include <stdint.h>
+
+#include "cacheSim.hpp"
+
+using  namespace std;
+
+// Non-blocking timing model, an alternative to the serial AccTimeAvg where every access waits
+// for the one before it. Accesses issue issueCycles apart and may overlap. BasicCache still
+// decides hits and misses, and the L1Cyc, L2Cyc and memory cycles (MemCyc, or the DRAM
+// latency, see dram.hpp) it charges an access are the latencies of the stages that access goes
+// through, with the address translation (see tlb.hpp) part of the L1 stage:
+//   - An L1 miss holds one of L1MSHRs miss status holding registers until its line is back.
+//     With every one of them busy the core stops issuing until the first one frees.
+//   - An L2 miss also holds one of L2MSHRs L2 registers and then one of memChannels memory
+//     channels for its memory cycles, waiting for both if none is free.
+//   - An access to a block that is still outstanding in L1 or L2 merges with that miss and
+//     completes when its line arrives, without taking another register.
+// The latency of an access is the time from its issue to its completion. Without overlap it
+// is the serial access time, so the serial model stays the default and the comparable one.
+#define MAX_MSHRS 256
+
+struct TimingConfig {
+    unsigned int L1MSHRs, L2MSHRs; // 1 .. MAX_MSHRS
+    unsigned int memChannels; // concurrent memory accesses, 1 .. MAX_MSHRS
+    unsigned int issueCycles; // cycles between the issue of two accesses
+};
+
+struct TimingStats {
+    uint64_t accesses;
+    uint64_t cycles; // completion of the last access
+    uint64_t totalLatency;
+    uint64_t latencyP50, latencyP99;
+    uint64_t merged; // accesses merged with an outstanding miss
+    uint64_t stallCycles; // issue cycles lost to full L1 MSHRs
+    double L1MSHROccupancy, L2MSHROccupancy, memOccupancy; // average busy entries
+};
+
+// smallest latency at or above fraction of the accesses of histogram (counts per latency)
+uint64_t latencyPercentile(const vector<uint64_t>& histogram, uint64_t accesses, double fraction);
+
+// Drives a BasicCache and times its accesses
+template <class Simulator>
+class TimingSimulator {
+private:
+    struct Entry {
+        uint64_t block;
+        uint64_t ready; // cycle the line arrives, the entry is free from then on
+    };
+    Simulator& cache;
+    TimingConfig config;
+    unsigned int blockBits;
+    vector<Entry> L1MSHR, L2MSHR;
+    vector<uint64_t> channels; // cycle every memory channel is free again
+    vector<uint64_t> histogram; // accesses per latency, the last entry counts all longer ones
+    uint64_t nextIssue;
+    uint64_t L1Busy, L2Busy, memBusy; // entry cycles spent busy
+    TimingStats stats;
+    static Entry* findBlock(vector<Entry>& entries, uint64_t block, uint64_t time);
+    static Entry& earliestEntry(vector<Entry>& entries);
+    void access(uint64_t address, uint8_t operation); // ACCESS_READ, ACCESS_WRITE or ACCESS_FETCH
+public:
+    TimingSimulator(Simulator& cache, const CacheConfig& cacheConfig, const TimingConfig& config);
+    void readFromCache(uint64_t address);
+    void writeToCache(uint64_t address);
+    void fetchFromCache(uint64_t address);
+    void finish(TimingStats& stats);
+};
+
+/**********************************************************************************************/
+// TimingSimulator definitions
+
+template <class Simulator>
+TimingSimulator<Simulator>::TimingSimulator(Simulator& cache, const CacheConfig& cacheConfig,
+											const TimingConfig& config) :
+		cache(cache), config(config), blockBits(cacheConfig.BSize), nextIssue(0), L1Busy(0),
+		L2Busy(0), memBusy(0) {
+	Entry idle = {0, 0};
+	this->L1MSHR.assign(config.L1MSHRs, idle);
+	this->L2MSHR.assign(config.L2MSHRs, idle);
+	this->channels.assign(config.memChannels, 0);
+	// an L2 miss waits at most for every L2 register ahead of it, twice (for a register, then
+	// for a channel), so longer latencies only come from merging (or DRAM banks still busy
+	// past a row conflict) and are all counted last
+	uint64_t queued = (config.L2MSHRs + config.memChannels - 1) / config.memChannels;
+	uint64_t memory = cacheConfig.MemCyc;
+	if (cacheConfig.dram.channels != DRAM_OFF) {
+		memory += cacheConfig.dram.tRP + cacheConfig.dram.tRCD + cacheConfig.dram.tCAS;
+	}
+	uint64_t longest = (uint64_t)max(cacheConfig.L1Cyc, cacheConfig.L1ICyc) + cacheConfig.L2Cyc +
+					   (2 * queued + 1) * memory;
+	if (cacheConfig.tlb.L1Entries != TLB_OFF) {
+		longest += cacheConfig.tlb.L2TlbCyc + PAGE_TABLE_LEVELS * cacheConfig.tlb.walkCyc;
+	}
+	this->histogram.assign(longest + 1, 0);
+	this->stats = TimingStats();
+}
+
+template <class Simulator>
+inline typename TimingSimulator<Simulator>::Entry*
+TimingSimulator<Simulator>::findBlock(vector<Entry>& entries, uint64_t block, uint64_t time) {
+	for (size_t i = 0; i < entries.size(); i++) {
+		if (entries[i].ready > time && entries[i].block == block) {
+			return &entries[i];
+		}
+	}
+	return nullptr;
+}
+
+template <class Simulator>
+inline typename TimingSimulator<Simulator>::Entry&
+TimingSimulator<Simulator>::earliestEntry(vector<Entry>& entries) {
+	size_t earliest = 0;
+	for (size_t i = 1; i < entries.size(); i++) {
+		if (entries[i].ready < entries[earliest].ready) {
+			earliest = i;
+		}
+	}
+	return entries[earliest];
+}
+
+template <class Simulator>
+inline void TimingSimulator<Simulator>::access(uint64_t address, uint8_t operation) {
+	// the stages the access goes through are the cycles the serial model charges it
+	uint64_t L1Cycles = this->cache.getTotalL1Cycles();
+	uint64_t L2Cycles = this->cache.getTotalL2Cycles();
+	uint64_t memCycles = this->cache.getTotalMemCycles();
+	uint64_t L1Misses = this->cache.getL1ReadMisses() + this->cache.getL1WriteMisses();
+	if (operation == ACCESS_WRITE) {
+		this->cache.writeToCache(address);
+	} else if (operation == ACCESS_FETCH) {
+		this->cache.fetchFromCache(address);
+	} else {
+		this->cache.readFromCache(address);
+	}
+	L1Cycles = this->cache.getTotalL1Cycles() - L1Cycles;
+	L2Cycles = this->cache.getTotalL2Cycles() - L2Cycles;
+	memCycles = this->cache.getTotalMemCycles() - memCycles;
+	bool L1Miss = this->cache.getL1ReadMisses() + this->cache.getL1WriteMisses() != L1Misses;
+
+	uint64_t block = address >> this->blockBits;
+	uint64_t issue = this->nextIssue;
+	uint64_t done;
+	Entry* outstanding = findBlock(this->L1MSHR, block, issue);
+	if (outstanding != nullptr) {
+		done = max(issue + L1Cycles, outstanding->ready);
+		this->stats.merged++;
+	} else if (!L1Miss) {
+		done = issue + L1Cycles;
+	} else {
+		Entry& L1Entry = earliestEntry(this->L1MSHR);
+		if (L1Entry.ready > issue) {
+			// every L1 register is busy, nothing issues until one frees
+			this->stats.stallCycles += L1Entry.ready - issue;
+			issue = L1Entry.ready;
+		}
+		uint64_t L2Start = issue + L1Cycles;
+		outstanding = findBlock(this->L2MSHR, block, L2Start);
+		if (outstanding != nullptr) {
+			done = max(L2Start + L2Cycles, outstanding->ready);
+			this->stats.merged++;
+		} else if (memCycles == 0) {
+			done = L2Start + L2Cycles;
+		} else {
+			Entry& L2Entry = earliestEntry(this->L2MSHR);
+			L2Start = max(L2Start, L2Entry.ready);
+			uint64_t* channel = &this->channels[0];
+			for (size_t i = 1; i < this->channels.size(); i++) {
+				if (this->channels[i] < *channel) {
+					channel = &this->channels[i];
+				}
+			}
+			uint64_t memStart = max(L2Start + L2Cycles, *channel);
+			done = memStart + memCycles;
+			*channel = done;
+			L2Entry.block = block;
+			L2Entry.ready = done;
+			this->L2Busy += done - L2Start;
+			this->memBusy += memCycles;
+		}
+		L1Entry.block = block;
+		L1Entry.ready = done;
+		this->L1Busy += done - issue;
+	}
+
+	uint64_t latency = done - issue;
+	this->histogram[min(latency, (uint64_t)this->histogram.size() - 1)]++;
+	this->stats.totalLatency += latency;
+	this->stats.cycles = max(this->stats.cycles, done);
+	this->stats.accesses++;
+	this->nextIssue = issue + this->config.issueCycles;
+}
+
+template <class Simulator>
+void TimingSimulator<Simulator>::readFromCache(uint64_t address) {
+	this->access(address, ACCESS_READ);
+}
+
+template <class Simulator>
+void TimingSimulator<Simulator>::writeToCache(uint64_t address) {
+	this->access(address, ACCESS_WRITE);
+}
+
+template <class Simulator>
+void TimingSimulator<Simulator>::fetchFromCache(uint64_t address) {
+	this->access(address, ACCESS_FETCH);
+}
+
+template <class Simulator>
+void TimingSimulator<Simulator>::finish(TimingStats& stats) {
+	stats = this->stats;
+	stats.latencyP50 = latencyPercentile(this->histogram, stats.accesses, 0.50);
+	stats.latencyP99 = latencyPercentile(this->histogram, stats.accesses, 0.99);
+	double cycles = (double)stats.cycles;
+	stats.L1MSHROccupancy = cycles ? this->L1Busy / cycles : 0.0;
+	stats.L2MSHROccupancy = cycles ? this->L2Busy / cycles : 0.0;
+	stats.memOccupancy = cycles ? this->memBusy / cycles : 0.0;
+}
+
+#endif // TIMING_HPP
@@ -0,0 +1,184 @@
+#include "tlb.hpp"
+
+/**********************************************************************************************/
+// TlbStats definitions
+TlbStats& TlbStats::operator+=(const TlbStats& other) {
+	this->L1Misses += other.L1Misses;
+	this->L2Misses += other.L2Misses;
+	this->walkReads += other.walkReads;
+	this->pwcHits += other.pwcHits;
+	this->cycles += other.cycles;
+	return *this;
+}
+
+TlbStats& TlbStats::operator-=(const TlbStats& other) {
+	this->L1Misses -= other.L1Misses;
+	this->L2Misses -= other.L2Misses;
+	this->walkReads -= other.walkReads;
+	this->pwcHits -= other.pwcHits;
+	this->cycles -= other.cycles;
+	return *this;
+}
+
+/**********************************************************************************************/
+// TlbArray definitions
+TlbArray::TlbArray() : numSets(0), numWays(0), pages(nullptr), stamps(nullptr), clock(0) {
+}
+
+TlbArray::~TlbArray() {
+	delete[] this->pages;
+	delete[] this->stamps;
+}
+
+void TlbArray::initArray(unsigned int entries, unsigned int ways) {
+	this->numSets = entries / ways;
+	this->numWays = ways;
+	this->pages = new uint64_t[entries]();
+	this->stamps = new uint64_t[entries]();
+}
+
+bool TlbArray::lookup(uint64_t page) {
+	size_t first = (size_t)(page & (this->numSets - 1)) * this->numWays;
+	for (size_t entry = first; entry < first + this->numWays; entry++) {
+		if (this->stamps[entry] != 0 && this->pages[entry] == page) {
+			this->stamps[entry] = ++this->clock;
+			return true;
+		}
+	}
+	return false;
+}
+
+void TlbArray::insert(uint64_t page) {
+	size_t first = (size_t)(page & (this->numSets - 1)) * this->numWays;
+	size_t victim = first;
+	for (size_t entry = first + 1; entry < first + this->numWays; entry++) {
+		if (this->stamps[entry] < this->stamps[victim]) {
+			victim = entry;
+		}
+	}
+	this->pages[victim] = page;
+	this->stamps[victim] = ++this->clock;
+}
+
+void TlbArray::saveState(CheckpointWriter& checkpoint) {
+	checkpoint.writeArray(this->pages, (size_t)this->numSets * this->numWays);
+	checkpoint.writeArray(this->stamps, (size_t)this->numSets * this->numWays);
+	checkpoint.writeArray(&this->clock, 1);
+}
+
+bool TlbArray::restoreState(CheckpointReader& checkpoint) {
+	return checkpoint.readArray(this->pages, (size_t)this->numSets * this->numWays) &&
+		   checkpoint.readArray(this->stamps, (size_t)this->numSets * this->numWays) &&
+		   checkpoint.readArray(&this->clock, 1);
+}
+
+/**********************************************************************************************/
+// TlbModel definitions
+TlbModel::TlbModel() : pageBits(0) {
+	this->config = TlbConfig();
+	this->config.L1Entries = TLB_OFF;
+}
+
+void TlbModel::initTlb(const TlbConfig& config) {
+	this->config = config;
+	if (config.L1Entries == TLB_OFF) {
+		return;
+	}
+	this->pageBits = config.pageSize == TLB_PAGE_2M ? 21 : 12;
+	this->L1.initArray(config.L1Entries, config.L1Ways);
+	if (config.L2Entries != 0) {
+		this->L2.initArray(config.L2Entries, config.L2Ways);
+	}
+	if (config.pwcEntries != 0) {
+		for (int level = 0; level < PAGE_TABLE_LEVELS - 1; level++) {
+			this->walkCaches[level].initArray(config.pwcEntries, config.pwcEntries);
+		}
+	}
+}
+
+uint64_t TlbModel::translate(uint64_t address, TlbStats& stats) {
+	uint64_t page = address >> this->pageBits;
+	if (this->L1.lookup(page)) {
+		return 0;
+	}
+	stats.L1Misses++;
+	uint64_t cycles = 0;
+	if (this->config.L2Entries != 0) {
+		cycles += this->config.L2TlbCyc;
+		if (this->L2.lookup(page)) {
+			this->L1.insert(page);
+			stats.cycles += cycles;
+			return cycles;
+		}
+	}
+	stats.L2Misses++;
+	// the levels above the leaf, the root first: 3 for 4KB pages, 2 for 2MB ones
+	int upperLevels = this->config.pageSize == TLB_PAGE_2M ? PAGE_TABLE_LEVELS - 2 : PAGE_TABLE_LEVELS - 1;
+	// the walk starts below the deepest upper level entry a page walk cache holds
+	int start = 0;
+	if (this->config.pwcEntries != 0) {
+		for (int level = upperLevels - 1; level >= 0 && start == 0; level--) {
+			// entries of level are named by the address bits above the ones it translates
+			uint64_t entry = address >> (this->pageBits + PAGE_TABLE_LEVEL_BITS * (upperLevels - level));
+			if (this->walkCaches[level].lookup(entry)) {
+				start = level + 1;
+			}
+		}
+		if (start != 0) {
+			stats.pwcHits++;
+		}
+		for (int level = start; level < upperLevels; level++) {
+			this->walkCaches[level].insert(address >> (this->pageBits + PAGE_TABLE_LEVEL_BITS * (upperLevels - level)));
+		}
+	}
+	unsigned int reads = upperLevels + 1 - start;
+	stats.walkReads += reads;
+	cycles += (uint64_t)reads * this->config.walkCyc;
+	if (this->config.L2Entries != 0) {
+		this->L2.insert(page);
+	}
+	this->L1.insert(page);
+	stats.cycles += cycles;
+	return cycles;
+}
+
+void TlbModel::saveState(CheckpointWriter& checkpoint) {
+	this->L1.saveState(checkpoint);
+	if (this->config.L2Entries != 0) {
+		this->L2.saveState(checkpoint);
+	}
+	if (this->config.pwcEntries != 0) {
+		for (int level = 0; level < PAGE_TABLE_LEVELS - 1; level++) {
+			this->walkCaches[level].saveState(checkpoint);
+		}
+	}
+}
+
+bool TlbModel::restoreState(CheckpointReader& checkpoint) {
+	if (!this->L1.restoreState(checkpoint) ||
+		(this->config.L2Entries != 0 && !this->L2.restoreState(checkpoint))) {
+		return false;
+	}
+	if (this->config.pwcEntries != 0) {
+		for (int level = 0; level < PAGE_TABLE_LEVELS - 1; level++) {
+			if (!this->walkCaches[level].restoreState(checkpoint)) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+/**********************************************************************************************/
+
+static const char* pageSizeNames[] = {"4k", "2m"};
+
+bool parseTlbPageSize(const string& name, TlbPageSize& pageSize) {
+	for (int i = 0; i < (int)(sizeof(pageSizeNames) / sizeof(pageSizeNames[0])); i++) {
+		if (name == pageSizeNames[i]) {
+			pageSize = (TlbPageSize)i;
+			return true;
+		}
+	}
+	return false;
+}
@@ -0,0 +1,95 @@
+#ifndef TLB_HPP
+#define TLB_HPP
+
+#include <string>
+#include <stdint.h>
+
+#include "checkpoint.hpp"
+
+using  namespace std;
+
+// Address translation in front of L1. Every access looks its page up in the L1 DTLB, which
+// costs nothing (it runs alongside the L1 lookup). An L1 DTLB miss looks in the shared L2 TLB
+// (if any) for L2TlbCyc cycles, and an L2 TLB miss walks the x86-64 four level page table:
+// four page table reads of walkCyc cycles for a 4KB page, three for a 2MB page, whose
+// leaf is the third level. A walk reads the levels the page walk caches miss, one cache of
+// pwcEntries per upper level (PML4, PDPT and, for 4KB pages, PD entries), as in the paging
+// structure caches of Barr et al., ISCA 2010. The walk fills both TLBs and the page walk
+// caches of the levels it read. All the arrays are LRU.
+// The TLBs are the data side only: instruction fetches (the "i" trace operation) are not
+// translated, with or without an L1I, and the miss rates are per read and write. An ITLB
+// would see a different, far smaller page set and only blur the DTLB counters.
+// Traces have no page tables, so every address is mapped and the caches stay indexed by the
+// trace address. The page size is one for the whole run, 4KB or 2MB (every page huge).
+#define TLB_OFF 0 // L1 entries
+#define MAX_TLB_ENTRIES 4096
+#define MAX_PWC_ENTRIES 64
+#define PAGE_TABLE_LEVELS 4
+#define PAGE_TABLE_LEVEL_BITS 9 // 512 entries per level
+
+enum TlbPageSize {
+    TLB_PAGE_4K = 0,
+    TLB_PAGE_2M = 1
+};
+
+struct TlbConfig {
+    unsigned int L1Entries; // TLB_OFF, or a power of two up to MAX_TLB_ENTRIES
+    unsigned int L1Ways; // a power of two up to L1Entries
+    unsigned int L2Entries, L2Ways; // 0 entries for no L2 TLB
+    unsigned int L2TlbCyc; // L2 TLB lookup time in cycles
+    unsigned int walkCyc; // cycles per page table read
+    unsigned int pwcEntries; // per page walk cache, 0 .. MAX_PWC_ENTRIES
+    TlbPageSize pageSize;
+};
+
+// "4k" or "2m", returns false for anything else
+bool parseTlbPageSize(const string& name, TlbPageSize& pageSize);
+
+struct TlbStats {
+    uint64_t L1Misses, L2Misses; // L2Misses are the page walks
+    uint64_t walkReads; // page table reads
+    uint64_t pwcHits; // walks that started below the root
+    uint64_t cycles; // L2 TLB lookups and walks, part of totalL1Cycles
+    TlbStats& operator+=(const TlbStats& other);
+    TlbStats& operator-=(const TlbStats& other);
+};
+
+// A set associative LRU array of page numbers, one set for the fully associative page walk
+// caches
+class TlbArray {
+private:
+    unsigned int numSets, numWays;
+    uint64_t* pages;
+    uint64_t* stamps; // last use of every entry, 0 for a free one
+    uint64_t clock;
+    TlbArray(const TlbArray&) = delete;
+    TlbArray& operator=(const TlbArray&) = delete;
+public:
+    TlbArray();
+    ~TlbArray();
+    void initArray(unsigned int entries, unsigned int ways);
+    // true if page is in the array, which makes it the most recently used
+    bool lookup(uint64_t page);
+    // page replaces the least recently used entry of its set
+    void insert(uint64_t page);
+    void saveState(CheckpointWriter& checkpoint);
+    bool restoreState(CheckpointReader& checkpoint);
+};
+
+class TlbModel {
+private:
+    TlbConfig config;
+    unsigned int pageBits; // 12 or 21
+    TlbArray L1, L2;
+    TlbArray walkCaches[PAGE_TABLE_LEVELS - 1]; // PML4, PDPT and PD entries
+public:
+    TlbModel();
+    void initTlb(const TlbConfig& config);
+    bool isEnabled() { return this->config.L1Entries != TLB_OFF; }
+    // translates address, returns the cycles it took beyond the L1 DTLB
+    uint64_t translate(uint64_t address, TlbStats& stats);
+    void saveState(CheckpointWriter& checkpoint);
+    bool restoreState(CheckpointReader& checkpoint);
+};
+
+#endif // TLB_HPP
@@ -0,0 +1,379 @@
+#include "trace.hpp"
+#include "stream.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**********************************************************************************************/
+// TextTraceReader definitions
+TextTraceReader::TextTraceReader(const char* path) : file(path) {
+}
+
+bool TextTraceReader::isOpen() {
+	return this->file && this->file.good();
+}
+
+TraceStatus TextTraceReader::next(TraceAccess& access) {
+	if (!getline(this->file, this->line)) {
+		return TRACE_END;
+	}
+	if (!parseTraceLine(this->line.data(), this->line.data() + this->line.size(), access)) {
+		return TRACE_FORMAT_ERROR;
+	}
+	return TRACE_OK;
+}
+
+bool TextTraceReader::tell(TracePosition& position) {
+	streamoff offset = this->file.tellg();
+	if (offset < 0) {
+		return false;
+	}
+	position.offset = offset;
+	position.lastAddress = 0;
+	return true;
+}
+
+bool TextTraceReader::seek(const TracePosition& position) {
+	this->file.clear();
+	streamoff size = this->file.seekg(0, ios::end).tellg();
+	if (size < 0 || position.offset > (uint64_t)size) {
+		this->file.clear();
+		this->file.seekg(0);
+		return false;
+	}
+	return (bool)this->file.seekg(position.offset);
+}
+
+/**********************************************************************************************/
+// BinaryTraceReader definitions
+BinaryTraceReader::BinaryTraceReader(const char* path) : data(nullptr), size(0), records(nullptr),
+														 cursor(nullptr), end(nullptr), numAccesses(0),
+														 lastAddress(0), flags(0) {
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		return;
+	}
+	struct stat st;
+	if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(TraceHeader)) {
+		void* mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (mapped != MAP_FAILED) {
+			madvise(mapped, st.st_size, MADV_SEQUENTIAL);
+			this->data = (const uint8_t*)mapped;
+			this->size = st.st_size;
+		}
+	}
+	close(fd);
+	if (this->data == nullptr) {
+		return;
+	}
+	TraceHeader header;
+	memcpy(&header, this->data, sizeof(header));
+	if (header.magic != TRACE_MAGIC || header.version != TRACE_VERSION) {
+		munmap((void*)this->data, this->size);
+		this->data = nullptr;
+		return;
+	}
+	this->numAccesses = header.numAccesses;
+	this->flags = header.flags;
+	this->records = this->data + sizeof(TraceHeader);
+	this->cursor = this->records;
+	this->end = this->data + this->size;
+}
+
+BinaryTraceReader::BinaryTraceReader(const uint8_t* records, const uint8_t* end, uint64_t numAccesses,
+									 uint16_t flags) :
+		data(nullptr), size(0), records(records), cursor(records), end(end),
+		numAccesses(numAccesses), lastAddress(0), flags(flags) {
+}
+
+BinaryTraceReader::~BinaryTraceReader() {
+	if (this->data != nullptr) {
+		munmap((void*)this->data, this->size);
+	}
+}
+
+bool BinaryTraceReader::isOpen() {
+	return this->records != nullptr;
+}
+
+bool BinaryTraceReader::tell(TracePosition& position) {
+	if (this->data == nullptr) {
+		return false;
+	}
+	position.offset = this->cursor - this->data;
+	position.lastAddress = this->lastAddress;
+	return true;
+}
+
+bool BinaryTraceReader::seek(const TracePosition& position) {
+	if (this->data == nullptr || position.offset < (uint64_t)(this->records - this->data) ||
+		position.offset > this->size) {
+		return false;
+	}
+	this->cursor = this->data + position.offset;
+	this->lastAddress = position.lastAddress;
+	return true;
+}
+
+bool BinaryTraceReader::hasCores() {
+	return (this->flags & TRACE_FLAG_CORES) != 0;
+}
+
+uint16_t BinaryTraceReader::getFlags() {
+	return this->flags;
+}
+
+uint64_t BinaryTraceReader::getNumAccesses() {
+	return this->numAccesses;
+}
+
+const uint8_t* BinaryTraceReader::getRecords() {
+	return this->records;
+}
+
+const uint8_t* BinaryTraceReader::getRecordsEnd() {
+	return this->end;
+}
+
+/**********************************************************************************************/
+// BinaryTraceWriter definitions
+BinaryTraceWriter::BinaryTraceWriter(const char* path, uint16_t flags) :
+		file(path, ios::binary | ios::trunc), numAccesses(0), lastAddress(0), flags(flags), used(0) {
+	// the header is rewritten with the final count on close
+	TraceHeader header = {TRACE_MAGIC, TRACE_VERSION, flags, 0};
+	this->file.write((const char*)&header, sizeof(header));
+}
+
+BinaryTraceWriter::~BinaryTraceWriter() {
+	this->close();
+}
+
+bool BinaryTraceWriter::isOpen() {
+	return this->file.is_open() && this->file.good();
+}
+
+void BinaryTraceWriter::flush() {
+	this->file.write(this->buffer, this->used);
+	this->used = 0;
+}
+
+void BinaryTraceWriter::append(const TraceAccess& access) {
+	if (this->used + TRACE_MAX_RECORD > sizeof(this->buffer)) {
+		this->flush();
+	}
+	this->used += encodeTraceRecord((uint8_t*)this->buffer + this->used, access, this->lastAddress,
+										this->flags);
+	this->numAccesses++;
+}
+
+void BinaryTraceWriter::close() {
+	if (!this->file.is_open()) {
+		return;
+	}
+	this->flush();
+	TraceHeader header = {TRACE_MAGIC, TRACE_VERSION, this->flags, this->numAccesses};
+	this->file.seekp(0);
+	this->file.write((const char*)&header, sizeof(header));
+	this->file.close();
+}
+
+void BinaryTraceWriter::discard() {
+	if (this->file.is_open()) {
+		this->file.close();
+	}
+	this->used = 0;
+}
+
+/**********************************************************************************************/
+// TraceImage definitions
+TraceImage::TraceImage() : mappedFile(nullptr), records(nullptr), end(nullptr), numAccesses(0),
+						   flags(TRACE_FLAG_FETCHES) {
+}
+
+TraceImage::~TraceImage() {
+	delete this->mappedFile;
+}
+
+bool TraceImage::load(const char* path) {
+	if (isStreamPath(path)) {
+		StreamTraceReader reader(path);
+		if (!reader.isOpen()) {
+			cerr << "File not found" << endl;
+			return false;
+		}
+		return this->encode(reader);
+	}
+	if (isBinaryTrace(path)) {
+		this->mappedFile = new BinaryTraceReader(path);
+		if (!this->mappedFile->isOpen()) {
+			cerr << "File not found" << endl;
+			return false;
+		}
+		if (this->mappedFile->hasCores()) {
+			// the shared image has no core ids, re-encode the records without them
+			bool ok = this->encode(*this->mappedFile);
+			delete this->mappedFile;
+			this->mappedFile = nullptr;
+			return ok;
+		}
+		this->records = this->mappedFile->getRecords();
+		this->end = this->mappedFile->getRecordsEnd();
+		this->numAccesses = this->mappedFile->getNumAccesses();
+		this->flags = this->mappedFile->getFlags();
+		return true;
+	}
+	TextTraceReader reader(path);
+	if (!reader.isOpen()) {
+		cerr << "File not found" << endl;
+		return false;
+	}
+	return this->encode(reader);
+}
+
+template <class TraceReader>
+bool TraceImage::encode(TraceReader& reader) {
+	TraceAccess access;
+	TraceStatus status;
+	uint64_t lastAddress = 0;
+	uint8_t record[TRACE_MAX_RECORD];
+	while ((status = reader.next(access)) == TRACE_OK) {
+		if (access.operation != 'r' && access.operation != 'w' && access.operation != 'i') {
+			cout << "Operation Format error" << endl;
+			return false;
+		}
+		size_t length = encodeTraceRecord(record, access, lastAddress, this->flags);
+		this->encoded.insert(this->encoded.end(), record, record + length);
+		this->numAccesses++;
+	}
+	if (status == TRACE_FORMAT_ERROR) {
+		cout << "Command Format error" << endl;
+		return false;
+	}
+	this->records = this->encoded.data();
+	this->end = this->records + this->encoded.size();
+	return true;
+}
+
+uint64_t TraceImage::getNumAccesses() {
+	return this->numAccesses;
+}
+
+const uint8_t* TraceImage::getRecords() {
+	return this->records;
+}
+
+const uint8_t* TraceImage::getRecordsEnd() {
+	return this->end;
+}
+
+uint16_t TraceImage::getFlags() {
+	return this->flags;
+}
+
+/**********************************************************************************************/
+
+bool isBinaryTrace(const char* path) {
+	ifstream file(path, ios::binary);
+	uint32_t magic = 0;
+	if (!file.read((char*)&magic, sizeof(magic))) {
+		return false;
+	}
+	return magic == TRACE_MAGIC;
+}
+
+static bool isSpace(char c) {
+	return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+}
+
+bool parseTraceLine(const char* begin, const char* end, TraceAccess& access) {
+	// the operation is the first non blank character, the address the next word
+	const char* p = begin;
+	while (p != end && isSpace(*p)) {
+		p++;
+	}
+	if (p == end) {
+		return false;
+	}
+	access.operation = *p++;
+	while (p != end && isSpace(*p)) {
+		p++;
+	}
+	const char* word = p;
+	while (p != end && !isSpace(*p)) {
+		p++;
+	}
+	// Removing the "0x" part of the address
+	size_t length = p - word;
+	if (length < 2) {
+		return false;
+	}
+	char digits[32];
+	length = min(length - 2, sizeof(digits) - 1);
+	memcpy(digits, word + 2, length);
+	digits[length] = '\0';
+	access.address = strtoull(digits, NULL, 16);
+	// optional decimal core id
+	access.core = 0;
+	while (p != end && isSpace(*p)) {
+		p++;
+	}
+	while (p != end && *p >= '0' && *p <= '9') {
+		access.core = access.core * 10 + (*p++ - '0');
+	}
+	return true;
+}
+
+bool convertTextTrace(const char* textPath, const char* binaryPath) {
+	// core ids are only stored if the trace names a core other than 0, and the wider op field
+	// if it fetches instructions. The flags are found while converting: the first access that
+	// needs one the output lacks starts the conversion over with it, so a trace of plain reads
+	// and writes on core 0 is parsed once.
+	uint16_t flags = 0;
+	while (true) {
+		TextTraceReader reader(textPath);
+		if (!reader.isOpen()) {
+			cerr << "File not found" << endl;
+			return false;
+		}
+		BinaryTraceWriter writer(binaryPath, flags);
+		if (!writer.isOpen()) {
+			cerr << "Cannot create " << binaryPath << endl;
+			return false;
+		}
+		TraceAccess access;
+		TraceStatus status;
+		uint16_t needed = flags;
+		while ((status = reader.next(access)) == TRACE_OK) {
+			if (access.operation != 'r' && access.operation != 'w' && access.operation != 'i') {
+				cout << "Operation Format error" << endl;
+				// no partial trace that reads as a complete one is left behind
+				writer.discard();
+				unlink(binaryPath);
+				return false;
+			}
+			needed |= (access.core != 0 ? TRACE_FLAG_CORES : 0) | (access.operation == 'i' ? TRACE_FLAG_FETCHES : 0);
+			if (needed != flags) {
+				break;
+			}
+			writer.append(access);
+		}
+		if (needed != flags) {
+			writer.discard();
+			flags = needed;
+			continue;
+		}
+		if (status == TRACE_FORMAT_ERROR) {
+			cout << "Command Format error" << endl;
+			writer.discard();
+			unlink(binaryPath);
+			return false;
+		}
+		writer.close();
+		return true;
+	}
+}
@@ -0,0 +1,343 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include "allocCheck.hpp"
+
+using  namespace std;
+
+// Binary trace layout:
+//   header  - TraceHeader below (16 bytes, little endian)
+//   records - one per access. The address is stored as the delta from the previous address,
+//             zigzag encoded, and packed with the operation bit as a varint:
+//             byte 0:  bit 0 = op (0 = read, 1 = write), bits 1-6 = low 6 delta bits, bit 7 = more
+//             byte 1+: 7 delta bits each, bit 7 = more
+//             With TRACE_FLAG_FETCHES set the op takes bits 0-1 (0 = read, 1 = write,
+//             2 = instruction fetch) and byte 0 keeps 5 delta bits in bits 2-6.
+//             With TRACE_FLAG_CORES set every record is followed by the core id as a varint
+//             (7 bits per byte, bit 7 = more).
+// Text traces may carry the core id as an optional third word: "r 0x1234abcd 3", and fetch
+// instructions with the "i" operation: "i 0x400a10".
+#define TRACE_MAGIC 0x52545343 // "CSTR"
+#define TRACE_VERSION 1
+#define TRACE_FLAG_CORES 1
+#define TRACE_FLAG_FETCHES 2
+#define TRACE_MAX_RECORD 15 // bytes needed for a 64 bit delta plus the op bits and a core id
+
+enum TraceStatus {
+    TRACE_END = 0,
+    TRACE_OK = 1,
+    TRACE_FORMAT_ERROR = -1
+};
+
+struct TraceHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t flags; // TRACE_FLAG_CORES and TRACE_FLAG_FETCHES, or 0
+    uint64_t numAccesses;
+};
+
+enum TraceKind {
+    TRACE_KIND_TEXT = 0,
+    TRACE_KIND_BINARY = 1,
+    TRACE_KIND_STREAM = 2 // cannot seek, a position is reached by reading up to it
+};
+
+// Where a reader is in its trace, saved with checkpoints (see checkpoint.hpp)
+struct TracePosition {
+    TraceKind kind;
+    uint64_t accesses; // accesses read before this position
+    uint64_t offset; // byte offset of the next access in the file
+    uint64_t lastAddress; // binary delta decoder state
+};
+
+struct TraceAccess {
+    char operation; // read (r), write (w) or instruction fetch (i)
+    uint32_t core; // issuing core, 0 in single core traces
+    uint64_t address;
+};
+
+// Reads the "r 0x1234abcd" text format line by line
+class TextTraceReader {
+private:
+    ifstream file;
+    string line;
+public:
+    TextTraceReader(const char* path);
+    bool isOpen();
+    TraceStatus next(TraceAccess& access);
+    // fill the offset of position, returns false if there is none to seek back to
+    bool tell(TracePosition& position);
+    bool seek(const TracePosition& position);
+};
+
+// Maps a binary trace and decodes it in place, no allocation per access
+class BinaryTraceReader {
+private:
+    const uint8_t* data; // the mapping, nullptr when reading records owned by someone else
+    size_t size;
+    const uint8_t* records;
+    const uint8_t* cursor;
+    const uint8_t* end;
+    uint64_t numAccesses;
+    uint64_t lastAddress;
+    uint16_t flags; // of the header, how the records are laid out
+    BinaryTraceReader(const BinaryTraceReader&) = delete;
+    BinaryTraceReader& operator=(const BinaryTraceReader&) = delete;
+public:
+    BinaryTraceReader(const char* path);
+    // read records already in memory (see TraceImage), the caller keeps them alive
+    BinaryTraceReader(const uint8_t* records, const uint8_t* end, uint64_t numAccesses,
+            uint16_t flags = 0);
+    ~BinaryTraceReader();
+    bool isOpen();
+    bool hasCores();
+    uint16_t getFlags();
+    uint64_t getNumAccesses();
+    const uint8_t* getRecords();
+    const uint8_t* getRecordsEnd();
+    TraceStatus next(TraceAccess& access);
+    // mapped files only
+    bool tell(TracePosition& position);
+    bool seek(const TracePosition& position);
+};
+
+// Ends the trace of reader after limit more accesses, reader can go on reading after that
+template <class TraceReader>
+class LimitedTraceReader {
+private:
+    TraceReader& reader;
+    uint64_t remaining;
+public:
+    LimitedTraceReader(TraceReader& reader, uint64_t limit) : reader(reader), remaining(limit) {}
+    // nonzero if the trace ended before the limit
+    uint64_t getRemaining() { return this->remaining; }
+    TraceStatus next(TraceAccess& access) {
+        if (this->remaining == 0) {
+            return TRACE_END;
+        }
+        TraceStatus status = this->reader.next(access);
+        if (status == TRACE_OK) {
+            this->remaining--;
+        }
+        return status;
+    }
+};
+
+// Writes the binary format, used by the text to binary converter
+class BinaryTraceWriter {
+private:
+    ofstream file;
+    uint64_t numAccesses;
+    uint64_t lastAddress;
+    uint16_t flags;
+    char buffer[1 << 16];
+    size_t used;
+    void flush();
+public:
+    BinaryTraceWriter(const char* path, uint16_t flags = 0);
+    ~BinaryTraceWriter();
+    bool isOpen();
+    void append(const TraceAccess& access);
+    void close();
+    // close without writing the header count, for output that is thrown away
+    void discard();
+};
+
+// A whole trace loaded once and shared read-only between threads. Binary traces stay mapped,
+// text traces, streams (stream.hpp) and binary traces with core ids are parsed once and
+// encoded into the binary record format in memory, without core ids and with the fetch op
+// (TRACE_FLAG_FETCHES). Readers of the image take its flags.
+class TraceImage {
+private:
+    BinaryTraceReader* mappedFile;
+    vector<uint8_t> encoded;
+    const uint8_t* records;
+    const uint8_t* end;
+    uint64_t numAccesses;
+    uint16_t flags;
+    TraceImage(const TraceImage&) = delete;
+    TraceImage& operator=(const TraceImage&) = delete;
+    template <class TraceReader>
+    bool encode(TraceReader& reader);
+public:
+    TraceImage();
+    ~TraceImage();
+    // returns false (after printing the reason) if the trace cannot be read
+    bool load(const char* path);
+    uint64_t getNumAccesses();
+    const uint8_t* getRecords();
+    const uint8_t* getRecordsEnd();
+    uint16_t getFlags();
+};
+
+// true if the file at path starts with the binary trace magic
+bool isBinaryTrace(const char* path);
+
+// parse one "r 0x1234abcd" line (without the newline), returns false if it is malformed
+bool parseTraceLine(const char* begin, const char* end, TraceAccess& access);
+
+// convert a text trace to the binary format, returns false on error
+bool convertTextTrace(const char* textPath, const char* binaryPath);
+
+/**********************************************************************************************/
+// Record encoding and the BinaryTraceReader hot path
+
+// encode access after lastAddress into out (at least TRACE_MAX_RECORD bytes) in the layout of
+// flags, returns its length. A fetch needs TRACE_FLAG_FETCHES.
+inline size_t encodeTraceRecord(uint8_t* out, const TraceAccess& access, uint64_t& lastAddress,
+								uint16_t flags = 0) {
+	uint64_t delta = access.address - lastAddress;
+	uint64_t zigzag = (delta << 1) ^ (0 - (delta >> 63));
+	lastAddress = access.address;
+	size_t length = 0;
+	unsigned int opBits = (flags & TRACE_FLAG_FETCHES) ? 2 : 1;
+	uint8_t op = access.operation == 'w' ? 1 : (access.operation == 'i' ? 2 : 0);
+	uint8_t byte = op | (uint8_t)((zigzag & (0x7F >> opBits)) << opBits);
+	zigzag >>= 7 - opBits;
+	while (zigzag != 0) {
+		out[length++] = byte | 0x80;
+		byte = zigzag & 0x7F;
+		zigzag >>= 7;
+	}
+	out[length++] = byte;
+	if (flags & TRACE_FLAG_CORES) {
+		uint32_t core = access.core;
+		while (core >= 0x80) {
+			out[length++] = (uint8_t)(core | 0x80);
+			core >>= 7;
+		}
+		out[length++] = (uint8_t)core;
+	}
+	return length;
+}
+
+// decode the record at cursor and move past it. Returns TRACE_END, leaving everything as it
+// was, if the record is cut off by end (a stream reader then waits for more bytes).
+inline TraceStatus decodeTraceRecord(const uint8_t*& cursor, const uint8_t* end, TraceAccess& access,
+									 uint64_t& lastAddress, uint16_t flags) {
+	const uint8_t* p = cursor;
+	uint8_t byte = *p++;
+	unsigned int opBits = (flags & TRACE_FLAG_FETCHES) ? 2 : 1;
+	uint64_t zigzag = (byte & 0x7F) >> opBits;
+	unsigned int shift = 7 - opBits;
+	while (byte & 0x80) {
+		if (p == end) {
+			return TRACE_END;
+		}
+		if (shift > 63) {
+			return TRACE_FORMAT_ERROR;
+		}
+		byte = *p++;
+		zigzag |= (uint64_t)(byte & 0x7F) << shift;
+		shift += 7;
+	}
+	access.core = 0;
+	if (flags & TRACE_FLAG_CORES) {
+		shift = 0;
+		do {
+			if (p == end) {
+				return TRACE_END;
+			}
+			if (shift > 28) {
+				return TRACE_FORMAT_ERROR;
+			}
+			byte = *p++;
+			access.core |= (uint32_t)(byte & 0x7F) << shift;
+			shift += 7;
+		} while (byte & 0x80);
+	}
+	unsigned int op = *cursor & ((1u << opBits) - 1);
+	if (op == 3) {
+		return TRACE_FORMAT_ERROR;
+	}
+	access.operation = op == 0 ? 'r' : (op == 1 ? 'w' : 'i');
+	cursor = p;
+	// undo the zigzag encoding and the delta
+	uint64_t delta = (zigzag >> 1) ^ (0 - (zigzag & 1));
+	lastAddress += delta;
+	access.address = lastAddress;
+	return TRACE_OK;
+}
+
+inline TraceStatus BinaryTraceReader::next(TraceAccess& access) {
+	if (this->cursor == this->end) {
+		return TRACE_END;
+	}
+	TraceStatus status = decodeTraceRecord(this->cursor, this->end, access, this->lastAddress,
+											 this->flags);
+	// a record cut off by the end of the file is a format error here
+	return status == TRACE_END ? TRACE_FORMAT_ERROR : status;
+}
+
+/**********************************************************************************************/
+// Trace drivers. A Simulator is anything with readFromCache(address), writeToCache(address)
+// and fetchFromCache(address), the Cache itself or one of the profilers built on the same
+// interface.
+
+// feed every access of the trace into sim, returns false on a format error. ALLOC_CHECK builds
+// end the program with a failure status if sim allocated while handling an access, so sharded
+// and sweep runs, which do not look at the result, fail too.
+template <class TraceReader, class Simulator>
+bool simulateTrace(TraceReader& reader, Simulator& sim) {
+	TraceAccess access;
+	TraceStatus status;
+#ifdef CACHESIM_ALLOC_CHECK
+	uint64_t allocationsBefore = getScopedAllocations();
+#endif
+	while ((status = reader.next(access)) == TRACE_OK) {
+		if (access.operation == 'r') {
+			sim.readFromCache(access.address);
+		} else if (access.operation == 'w') {
+			sim.writeToCache(access.address);
+		} else if (access.operation == 'i') {
+			sim.fetchFromCache(access.address);
+		} else {
+			// Operation appears in an Invalid format
+			cout << "Operation Format error" << endl;
+			return false;
+		}
+	}
+	if (status == TRACE_FORMAT_ERROR) {
+		// Operation appears in an Invalid format
+		cout << "Command Format error" << endl;
+		return false;
+	}
+#ifdef CACHESIM_ALLOC_CHECK
+	uint64_t allocations = getScopedAllocations() - allocationsBefore;
+	if (allocations != 0) {
+		cerr << "Allocation check failed: " << allocations
+			 << " heap allocations in the simulation loop" << endl;
+		exit(EXIT_FAILURE);
+	}
+#endif
+	return true;
+}
+
+// open path as a binary or a text trace and simulate it, returns false on any error
+template <class Simulator>
+bool simulateTraceFile(const char* path, Simulator& sim) {
+	if (isBinaryTrace(path)) {
+		BinaryTraceReader reader(path);
+		if (!reader.isOpen()) {
+			cerr << "File not found" << endl;
+			return false;
+		}
+		return simulateTrace(reader, sim);
+	}
+	TextTraceReader reader(path); //input file stream
+	if (!reader.isOpen()) {
+		// File doesn't exist or some other error
+		cerr << "File not found" << endl;
+		return false;
+	}
+	return simulateTrace(reader, sim);
+}
+
+#endif // TRACE_HPP